@@ -0,0 +1,80 @@
+// Formats a buffer through each available kernel and reports input GB/s.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "hexformat.h"
+
+static const size_t kInput = 16u * 1024 * 1024;
+static const int kRounds = 8;
+
+int main()
+{
+  uint8_t* input = (uint8_t*)malloc(kInput);
+  char* hex = (char*)malloc(kInput * 3);
+  char* ascii = (char*)malloc(kInput);
+  char* reference = (char*)malloc(kInput * 3);
+  char* referenceAscii = (char*)malloc(kInput);
+  if (!input || !hex || !ascii || !reference || !referenceAscii)
+    return 1;
+
+  uint32_t seed = 0x9E3779B9u;
+  for (size_t i = 0; i < kInput; i++)
+  {
+    seed = seed * 1664525u + 1013904223u;
+    input[i] = (uint8_t)(seed >> 24);
+  }
+
+  hf_set_backend(HEXFORMAT_SCALAR);
+  hf_hex(input, kInput, reference);
+  hf_ascii(input, kInput, referenceAscii);
+
+  hf_set_backend(HEXFORMAT_AVX2);
+  int best = hf_backend();
+
+  for (int backend = HEXFORMAT_SCALAR; backend <= best; backend++)
+  {
+    hf_set_backend(backend);
+
+    // Row-sized calls, the way the view formats, as well as one bulk call.
+    double rowSeconds = 1e30, bulkSeconds = 1e30;
+    for (int round = 0; round < kRounds; round++)
+    {
+      auto t0 = std::chrono::steady_clock::now();
+      for (size_t off = 0; off < kInput; off += 16)
+      {
+        hf_hex(input + off, 16, hex + off * 3);
+        hf_ascii(input + off, 16, ascii + off);
+      }
+      auto t1 = std::chrono::steady_clock::now();
+      hf_hex(input, kInput, hex);
+      hf_ascii(input, kInput, ascii);
+      auto t2 = std::chrono::steady_clock::now();
+
+      double row = std::chrono::duration<double>(t1 - t0).count();
+      double bulk = std::chrono::duration<double>(t2 - t1).count();
+      if (row < rowSeconds)
+        rowSeconds = row;
+      if (bulk < bulkSeconds)
+        bulkSeconds = bulk;
+    }
+
+    bool ok = memcmp(hex, reference, kInput * 3) == 0 &&
+              memcmp(ascii, referenceAscii, kInput) == 0;
+    printf("%-7s rows %6.2f GB/s  bulk %6.2f GB/s  %s\n",
+           hf_backend_name(backend),
+           kInput / rowSeconds / 1e9,
+           kInput / bulkSeconds / 1e9,
+           ok ? "ok" : "MISMATCH");
+    if (!ok)
+      return 1;
+  }
+
+  free(input);
+  free(hex);
+  free(ascii);
+  free(reference);
+  free(referenceAscii);
+  return 0;
+}
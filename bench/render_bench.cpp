@@ -0,0 +1,384 @@
+// Drives the Linux renderer against an offscreen pixmap over synthetic files
+// and prints one CSV row per scenario. Needs an X server; in CI run it as
+//   xvfb-run -s "-screen 0 1280x800x24" ./render_bench [--frames N] [--max-mb N]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <X11/Xlib.h>
+
+#include "render.h"
+#include "options.h"
+#include "menu.h"
+#include "hexdata.h"
+#include "linecache.h"
+#include "frameprofile.h"
+#include "minimap.h"
+#include "scanreader.h"
+#include "panelcontent.h"
+
+// Host state that hexviewer.cpp normally owns; the renderer and panels read it.
+HexData* g_HexData = nullptr;
+AppOptions g_Options;
+MenuBar g_MenuBar;
+ScrollbarState g_MainScrollbar;
+SelectionState g_Selection;
+LeftPanelState g_LeftPanel;
+BottomPanelState g_BottomPanel;
+Minimap g_Minimap;
+RenderManager g_Renderer;
+Display* g_display = nullptr;
+Window g_window = 0;
+char g_CurrentFilePath[MAX_PATH_LEN] = {0};
+char g_RecentFiles[10][MAX_PATH_LEN] = {0};
+int g_RecentFileCount = 0;
+long long cursorBytePos = -1;
+int cursorNibblePos = 0;
+long long selectionLength = 0;
+size_t editingOffset = (size_t)-1;
+bool caretVisible = true;
+long long g_ScrollY = 0;
+long long maxScrolls = 0;
+int g_LinesPerPage = 0;
+long long g_TotalLines = 0;
+int g_SearchCaretX = 0;
+int g_SearchCaretY = 0;
+bool g_FollowTail = false;
+
+void OnUndo() {}
+void OnRedo() {}
+void OnInsertBytes() {}
+void OnDeleteBytes() {}
+void OnNextDataExtent() {}
+void OnPrevDataExtent() {}
+void OnToggleFollowTail() {}
+void ApplyEnabledPlugins() {}
+
+static const int kWidth = 1280;
+static const int kHeight = 800;
+static const int kBookmarks = 100000;
+static const uint64_t kSizes[] = {
+  1ull << 20,
+  64ull << 20,
+  1ull << 30,
+  16ull << 30
+};
+static const size_t kBlock = 1u << 20;
+
+static LineCache g_BenchLines;
+static ChecksumResults g_BenchChecksums;
+static FrameProfiler g_BenchProfiler;
+static int g_FrameWidth = kWidth;
+static int g_FrameHeight = kHeight;
+
+// A quarter each of text, noise, a counter and zeros, so every byte class and
+// overview class shows up on screen.
+static void fill_block(uint8_t* block, uint32_t* seed)
+{
+  static const char text[] = "The quick brown fox jumps over the lazy dog.\n";
+  size_t quarter = kBlock / 4;
+  for (size_t i = 0; i < quarter; i++)
+    block[i] = (uint8_t)text[i % (sizeof(text) - 1)];
+  for (size_t i = quarter; i < quarter * 2; i++)
+  {
+    *seed = *seed * 1664525u + 1013904223u;
+    block[i] = (uint8_t)(*seed >> 24);
+  }
+  for (size_t i = quarter * 2; i < quarter * 3; i++)
+    block[i] = (uint8_t)i;
+  memset(block + quarter * 3, 0, quarter);
+}
+
+// Large sizes stay sparse: up to 64 data blocks are spread evenly and the rest
+// of the file is holes, which the loader maps without reading.
+static bool make_file(char* path, uint64_t size)
+{
+  strcpy(path, "/tmp/hexviewer-bench-XXXXXX");
+  int fd = mkstemp(path);
+  if (fd < 0)
+    return false;
+
+  bool ok = ftruncate(fd, (off_t)size) == 0;
+  uint8_t* block = (uint8_t*)malloc(kBlock);
+  uint32_t seed = 0x9E3779B9u;
+  uint64_t count = size / kBlock < 64 ? size / kBlock : 64;
+  uint64_t stride = count ? size / count : 0;
+  for (uint64_t i = 0; ok && block && i < count; i++)
+  {
+    fill_block(block, &seed);
+    ok = pwrite(fd, block, kBlock, (off_t)(i * stride)) == (ssize_t)kBlock;
+  }
+
+  free(block);
+  close(fd);
+  if (!ok || !block)
+    unlink(path);
+  return ok && block;
+}
+
+static void set_frame_size(int width, int height)
+{
+  g_FrameWidth = width;
+  g_FrameHeight = height;
+  g_Renderer.resize(width, height);
+  int charHeight = g_Renderer.getCharHeight() > 0 ? g_Renderer.getCharHeight() : 16;
+  g_LinesPerPage = (height - g_MenuBar.getHeight() - 40) / charHeight;
+  if (g_LinesPerPage < 1)
+    g_LinesPerPage = 1;
+}
+
+static long long max_scroll()
+{
+  long long maxScroll = g_TotalLines - g_LinesPerPage;
+  return maxScroll > 0 ? maxScroll : 0;
+}
+
+// Mirrors LinuxPaint with the whole frame damaged, which is what scrolling,
+// selection changes and resizes cost in the app.
+static void render_frame()
+{
+  int menuBarHeight = g_MenuBar.getHeight();
+  int leftPanelWidth = g_LeftPanel.visible ? g_LeftPanel.width : 0;
+  Theme theme = g_Options.darkMode ? Theme::Dark() : Theme::Light();
+
+  g_Renderer.invalidateAll();
+  g_Renderer.resetDrawCalls();
+  fp_begin_frame(&g_BenchProfiler);
+  g_Renderer.UpdateHexMetrics(leftPanelWidth, menuBarHeight);
+  g_Renderer.beginFrame();
+
+  size_t lineCount = g_HexData->getLineCount();
+  size_t first = (size_t)g_ScrollY;
+  size_t last = first + g_LinesPerPage + 1;
+  if (last > lineCount)
+    last = lineCount;
+  LineProvider lines = lc_begin_frame(&g_BenchLines, g_HexData, first, last > first ? last - first : 0);
+
+  const SimpleString& header = g_HexData->getHeaderLine();
+
+  fp_begin_phase(&g_BenchProfiler, PHASE_HEX);
+  g_Renderer.clear(theme.windowBackground);
+  g_Renderer.renderHexViewer(
+    lines,
+    header.data ? header.data : "",
+    g_ScrollY,
+    max_scroll(),
+    false,
+    false,
+    Rect(0, 0, 0, 0),
+    Rect(0, 0, 0, 0),
+    g_Options.darkMode,
+    -1,
+    -1,
+    "",
+    cursorBytePos,
+    cursorNibblePos,
+    (long long)g_HexData->getFileSize(),
+    leftPanelWidth,
+    g_FrameHeight);
+  fp_end_phase(&g_BenchProfiler, PHASE_HEX);
+
+  fp_begin_phase(&g_BenchProfiler, PHASE_PANELS);
+  Rect leftBounds = GetLeftPanelBounds(g_LeftPanel, g_FrameWidth, g_FrameHeight, menuBarHeight);
+  g_Renderer.drawLeftPanel(g_LeftPanel, theme, g_FrameHeight, leftBounds);
+  Rect bottomBounds = GetBottomPanelBounds(g_BottomPanel, g_FrameWidth, g_FrameHeight, menuBarHeight, g_LeftPanel);
+  g_Renderer.drawBottomPanel(g_BottomPanel, theme, g_BenchChecksums, g_FrameWidth, g_FrameHeight, bottomBounds);
+  fp_end_phase(&g_BenchProfiler, PHASE_PANELS);
+
+  uint32_t drawCalls = g_Renderer.getDrawCalls();
+  fp_begin_phase(&g_BenchProfiler, PHASE_BLIT);
+  g_Renderer.endFrame(nullptr);
+  fp_end_phase(&g_BenchProfiler, PHASE_BLIT);
+  fp_end_frame(&g_BenchProfiler, drawCalls);
+}
+
+enum Scenario
+{
+  SCENARIO_SCROLL,
+  SCENARIO_SELECT_ALL,
+  SCENARIO_BOOKMARKS,
+  SCENARIO_RESIZE,
+  SCENARIO_COUNT
+};
+
+static const char* kScenarioNames[SCENARIO_COUNT] = { "scroll", "select_all", "bookmarks", "resize" };
+
+// Half the bookmarks land in the range the scroll passes over, half are spread
+// across the whole file.
+static void add_bookmarks(uint64_t size)
+{
+  uint64_t near = size < 65536 ? size : 65536;
+  for (int i = 0; i < kBookmarks; i++)
+  {
+    Bookmark bm{};
+    bm.byteOffset = (long long)((uint64_t)i * (i % 2 ? near : size) / kBookmarks);
+    bm.color = Color((uint8_t)(i * 37), (uint8_t)(i * 91), (uint8_t)(i * 53));
+    snprintf(bm.name, sizeof(bm.name), "bm%d", i);
+    g_Bookmarks.bookmarks.push_back(bm);
+  }
+  Bookmarks_Invalidate();
+  g_Options.bookmarkHighlights = true;
+}
+
+static void run_scenario(int scenario, uint64_t size, int frames)
+{
+  g_ScrollY = 0;
+  g_Selection.clear();
+  if (scenario == SCENARIO_SELECT_ALL)
+  {
+    g_Selection.startByte = 0;
+    g_Selection.endByte = (long long)size - 1;
+    g_Selection.active = true;
+  }
+  if (scenario == SCENARIO_BOOKMARKS)
+    add_bookmarks(size);
+
+  fp_init(&g_BenchProfiler);
+  g_BenchProfiler.enabled = true;
+  render_frame();
+  fp_init(&g_BenchProfiler);
+  g_BenchProfiler.enabled = true;
+
+  uint64_t start = sr_now_us();
+  for (int frame = 0; frame < frames; frame++)
+  {
+    if (scenario == SCENARIO_RESIZE)
+    {
+      if (frame % 2)
+        set_frame_size(kWidth, kHeight);
+      else
+        set_frame_size(kWidth - 256, kHeight - 160);
+    }
+    else
+    {
+      g_ScrollY += 3;
+      if (g_ScrollY > max_scroll())
+        g_ScrollY = 0;
+    }
+    render_frame();
+  }
+  uint64_t elapsed = sr_now_us() - start;
+
+  printf("%s,%llu,%d,%d,%d,%.1f,%u,%u,%u,%u\n",
+    kScenarioNames[scenario],
+    (unsigned long long)size,
+    g_FrameWidth,
+    g_FrameHeight,
+    frames,
+    elapsed ? frames * 1e6 / (double)elapsed : 0.0,
+    fp_percentile(&g_BenchProfiler, PHASE_COUNT, 50),
+    fp_percentile(&g_BenchProfiler, PHASE_COUNT, 95),
+    fp_percentile(&g_BenchProfiler, PHASE_COUNT, 99),
+    fp_draw_calls(&g_BenchProfiler, 50));
+  fflush(stdout);
+
+  if (scenario == SCENARIO_BOOKMARKS)
+  {
+    g_Bookmarks.bookmarks.clear();
+    Bookmarks_Invalidate();
+    g_Options.bookmarkHighlights = false;
+  }
+  if (scenario == SCENARIO_RESIZE)
+    set_frame_size(kWidth, kHeight);
+}
+
+static bool load_file(const char* path)
+{
+  HexData* data = new HexData();
+  g_HexData = data;
+  if (!data->loadFile(path))
+    return false;
+  while (!data->pollLoad())
+  {
+    if (!data->isLoading())
+      break;
+    usleep(1000);
+  }
+
+  g_TotalLines = (long long)data->getLineCount();
+  lc_invalidate(&g_BenchLines);
+  while (mm_step(&g_Minimap, data, 1000000))
+  {
+  }
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  int frames = 120;
+  uint64_t maxBytes = kSizes[sizeof(kSizes) / sizeof(kSizes[0]) - 1];
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    if (strcmp(argv[i], "--frames") == 0)
+      frames = atoi(argv[i + 1]);
+    else if (strcmp(argv[i], "--max-mb") == 0)
+      maxBytes = (uint64_t)atoll(argv[i + 1]) << 20;
+  }
+  if (frames < 1 || frames > PROFILE_FRAMES)
+    frames = PROFILE_FRAMES;
+
+  g_display = XOpenDisplay(nullptr);
+  if (!g_display)
+  {
+    fprintf(stderr, "render_bench: cannot open X display (run under Xvfb)\n");
+    return 1;
+  }
+
+  int screen = DefaultScreen(g_display);
+  Pixmap target = XCreatePixmap(g_display, RootWindow(g_display, screen), kWidth, kHeight,
+                                DefaultDepth(g_display, screen));
+  // The renderer talks to the server over its own connection.
+  XSync(g_display, False);
+
+  if (!g_Renderer.initialize((NativeWindow)target))
+  {
+    fprintf(stderr, "render_bench: renderer initialization failed\n");
+    return 1;
+  }
+
+  g_Options.darkMode = true;
+  g_Options.bookmarkHighlights = false;
+  g_LeftPanel.visible = true;
+  g_LeftPanel.width = 280;
+  g_BottomPanel.visible = true;
+  g_BottomPanel.height = 250;
+  set_frame_size(kWidth, kHeight);
+
+  printf("scenario,file_bytes,width,height,frames,fps,p50_us,p95_us,p99_us,draw_calls\n");
+
+  for (size_t s = 0; s < sizeof(kSizes) / sizeof(kSizes[0]); s++)
+  {
+    uint64_t size = kSizes[s];
+    if (size > maxBytes)
+      break;
+
+    char path[64];
+    if (!make_file(path, size))
+    {
+      fprintf(stderr, "render_bench: cannot create a %llu byte file\n", (unsigned long long)size);
+      return 1;
+    }
+
+    if (load_file(path))
+    {
+      for (int scenario = 0; scenario < SCENARIO_COUNT; scenario++)
+        run_scenario(scenario, size, frames);
+    }
+    else
+    {
+      fprintf(stderr, "render_bench: cannot load %s\n", path);
+    }
+
+    lc_invalidate(&g_BenchLines);
+    g_Minimap.owner = nullptr;
+    delete g_HexData;
+    g_HexData = nullptr;
+    unlink(path);
+  }
+
+  g_Renderer.cleanup();
+  XFreePixmap(g_display, target);
+  XCloseDisplay(g_display);
+  return 0;
+}
@@ -0,0 +1,53 @@
+#ifndef DOCUMENTS_H
+#define DOCUMENTS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "global.h"
+#include "hexdata.h"
+#include "panelcontent.h"
+
+#define MAX_DOCUMENTS 16
+#define MAX_AFTER_LOAD 4
+
+struct DocumentView
+{
+  char path[MAX_PATH_LEN];
+  long long cursorBytePos;
+  int cursorNibblePos;
+  long long scrollY;
+  SelectionState selection;
+  BookmarksState bookmarks;
+  ByteStatistics byteStats;
+  DetectItEasyState die;
+  bool followTail;
+  void (*afterLoad[MAX_AFTER_LOAD])();
+  int afterLoadCount;
+};
+
+struct Document
+{
+  HexData data;
+  DocumentView view;
+  uint64_t lastActive;
+  uint64_t memoryUsage;
+};
+
+struct DocumentSet
+{
+  Document* items[MAX_DOCUMENTS];
+  int count;
+  int active;
+  uint64_t clock;
+};
+
+void ds_init(DocumentSet* s);
+int ds_add(DocumentSet* s);
+void ds_remove(DocumentSet* s, int index);
+void ds_activate(DocumentSet* s, int index);
+Document* ds_active(DocumentSet* s);
+uint64_t ds_memory_usage(DocumentSet* s);
+uint64_t ds_enforce_budget(DocumentSet* s, uint64_t budget, uint64_t keepOffset, uint64_t keepLength);
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef EDITJOURNAL_H
+#define EDITJOURNAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "global.h"
+#include "piecetable.h"
+
+struct EditRecord
+{
+  uint64_t offset;
+  uint64_t oldLength;
+  uint64_t newLength;
+  size_t oldFirst;
+  size_t oldCount;
+  size_t newFirst;
+  size_t newCount;
+  bool mergeable;
+};
+
+class EditJournal
+{
+public:
+  EditJournal();
+
+  void clear();
+
+  bool begin(const PieceTable& pieces, uint64_t offset, uint64_t oldLength, uint64_t newLength, bool mergeable);
+  void commit(const PieceTable& pieces);
+  void cancel() { pending = false; }
+
+  bool canUndo() const { return position > 0; }
+  bool canRedo() const { return position < records.size(); }
+  bool undo(PieceTable& pieces, uint64_t* outOffset, uint64_t* outRemoved, uint64_t* outInserted);
+  bool redo(PieceTable& pieces, uint64_t* outOffset, uint64_t* outRemoved, uint64_t* outInserted);
+
+  uint64_t detachCost(const PieceTable& pieces, const Vector<ByteExtent>& extents) const;
+  bool detachOriginal(PieceTable& pieces, const Vector<ByteExtent>& extents);
+  void rebase(PieceTable& pieces);
+
+  uint64_t memoryUsage() const { return records.size() * sizeof(EditRecord) + journalPieces.size() * sizeof(Piece); }
+
+  void markSaved() { savedPosition = (long long)position; }
+  bool isAtSavedPoint() const { return savedPosition == (long long)position; }
+
+private:
+  Vector<EditRecord> records;
+  Vector<Piece> journalPieces;
+  size_t position;
+  long long savedPosition;
+
+  bool pending;
+  bool pendingMerge;
+  uint64_t pendingOffset;
+  uint64_t pendingOldLength;
+  uint64_t pendingNewLength;
+  bool pendingMergeable;
+  Vector<Piece> pendingOld;
+
+  void appendPieces(const Vector<Piece>& source);
+  void truncatePieces(size_t count);
+};
+
+#endif
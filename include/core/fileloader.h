@@ -0,0 +1,45 @@
+#ifndef FILELOADER_H
+#define FILELOADER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "global.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+enum LoaderState
+{
+  LOADER_IDLE,
+  LOADER_RUNNING,
+  LOADER_DONE,
+  LOADER_CANCELLED,
+  LOADER_FAILED
+};
+
+struct FileLoader
+{
+  char path[MAX_PATH_LEN];
+  uint8_t* target;
+  uint64_t total;
+  uint64_t done;
+  int state;
+  int cancelRequested;
+  bool threadStarted;
+#ifdef _WIN32
+  void* thread;
+#else
+  pthread_t thread;
+#endif
+};
+
+void fl_init(FileLoader* l);
+bool fl_start_read(FileLoader* l, const char* path, uint8_t* target, uint64_t size);
+void fl_cancel(FileLoader* l);
+void fl_wait(FileLoader* l);
+int fl_state(const FileLoader* l);
+uint64_t fl_done(const FileLoader* l);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef FILEMAP_H
+#define FILEMAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "global.h"
+
+enum FileMapAdvice
+{
+  FM_ADVICE_NORMAL,
+  FM_ADVICE_SEQUENTIAL,
+  FM_ADVICE_RANDOM,
+  FM_ADVICE_WILLNEED,
+  FM_ADVICE_DONTNEED
+};
+
+struct FileMapping
+{
+  uint8_t* data;
+  uint64_t size;
+  bool device;
+#ifdef _WIN32
+  void* file;
+  void* section;
+#else
+  int fd;
+#endif
+};
+
+void fm_init(FileMapping* m);
+bool fm_open(FileMapping* m, const char* path);
+void fm_close(FileMapping* m);
+bool fm_is_open(const FileMapping* m);
+bool fm_same_file(const FileMapping* m, const char* path);
+bool fm_current_size(const FileMapping* m, uint64_t* outSize);
+bool fm_remap(FileMapping* m, uint64_t newSize);
+bool fm_data_extents(const FileMapping* m, Vector<ByteExtent>& out);
+uint64_t fm_read(const FileMapping* m, uint64_t offset, uint8_t* out, uint64_t length);
+void fm_advise(FileMapping* m, uint64_t offset, uint64_t length, FileMapAdvice advice);
+
+#endif
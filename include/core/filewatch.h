@@ -0,0 +1,30 @@
+#ifndef FILEWATCH_H
+#define FILEWATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "global.h"
+
+struct FileWatch
+{
+  char path[MAX_PATH_LEN];
+  bool active;
+#if defined(__linux__)
+  int fd;
+  int wd;
+  const char* name;
+#endif
+  uint64_t stampSize;
+  uint64_t stampTime;
+  uint64_t stampId;
+};
+
+void fw_init(FileWatch* w);
+bool fw_start(FileWatch* w, const char* path);
+void fw_stop(FileWatch* w);
+bool fw_is_watching(const FileWatch* w, const char* path);
+bool fw_poll(FileWatch* w);
+void fw_sync(FileWatch* w);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef FRAMEPROFILE_H
+#define FRAMEPROFILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "global.h"
+
+#define PROFILE_FRAMES 240
+#define PROFILE_HUD_LINES 8
+#define PROFILE_HUD_TEXT 64
+
+enum FramePhase
+{
+  PHASE_FORMAT,
+  PHASE_HEX,
+  PHASE_PANELS,
+  PHASE_MENU,
+  PHASE_BLIT,
+  PHASE_COUNT
+};
+
+struct FrameSample
+{
+  uint32_t phaseUs[PHASE_COUNT];
+  uint32_t totalUs;
+  uint32_t drawCalls;
+};
+
+struct FrameProfiler
+{
+  FrameSample samples[PROFILE_FRAMES];
+  int next;
+  int count;
+  FrameSample current;
+  uint64_t frameStart;
+  uint64_t phaseStart[PHASE_COUNT];
+  bool enabled;
+};
+
+void fp_init(FrameProfiler* p);
+void fp_begin_frame(FrameProfiler* p);
+void fp_begin_phase(FrameProfiler* p, int phase);
+void fp_end_phase(FrameProfiler* p, int phase);
+void fp_add(FrameProfiler* p, int phase, uint64_t microseconds);
+void fp_end_frame(FrameProfiler* p, uint32_t drawCalls);
+uint32_t fp_percentile(const FrameProfiler* p, int phase, int percentile);
+uint32_t fp_draw_calls(const FrameProfiler* p, int percentile);
+int fp_format_hud(const FrameProfiler* p, char lines[][PROFILE_HUD_TEXT], int maxLines);
+bool fp_dump(const FrameProfiler* p, const char* path);
+const char* fp_phase_name(int phase);
+
+#endif
@@ -474,6 +474,12 @@ inline void uintToHex8(unsigned int v, char out[8])
   out[7] = intToHexChar(v & 0xF);
 }
 
+inline void uintToHex16(unsigned long long v, char out[16])
+{
+  for (int i = 0; i < 16; i++)
+    out[i] = intToHexChar((int)((v >> (60 - i * 4)) & 0xF));
+}
+
 inline void itoaHex(unsigned long long value, char* out, int max)
 {
   static const char* hex = "0123456789ABCDEF";
@@ -774,6 +780,12 @@ struct ByteBuffer
   size_t capacity;
 };
 
+struct ByteExtent
+{
+  uint64_t offset;
+  uint64_t length;
+};
+
 struct LineArray
 {
   SimpleString* lines;
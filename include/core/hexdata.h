@@ -4,10 +4,51 @@
 #include <stddef.h>
 
 #include "global.h"
+#include "filemap.h"
+#include "fileloader.h"
+#include "scanreader.h"
+#include "streamsource.h"
+#include "piecetable.h"
+#include "editjournal.h"
+#include "hexformat.h"
 #include "pluginexecutor.h"
 #include "options.h"
 
 #define MAX_PLUGINS 10
+#define DISASM_CACHE_LINES 1024
+#define DISASM_LINE_LEN 128
+#define READAHEAD_WINDOW (4ull * 1024 * 1024)
+#define EDIT_HISTORY 64
+
+typedef void (*OffsetShiftCallback)(uint64_t offset, uint64_t removed, uint64_t inserted);
+
+static inline uint64_t shift_offset(uint64_t pos, uint64_t offset, uint64_t removed, uint64_t inserted)
+{
+  if (pos < offset)
+    return pos;
+  if (pos >= offset + removed)
+    return pos - removed + inserted;
+  return pos - offset < inserted ? pos : offset + inserted;
+}
+
+enum ReloadResult
+{
+  RELOAD_NONE,
+  RELOAD_CHANGED,
+  RELOAD_APPENDED,
+  RELOAD_REPLACED,
+  RELOAD_DETACHED,
+  RELOAD_UNDETACHED,  // Too much to copy out; unsaved edits still read the live file.
+  RELOAD_FAILED
+};
+
+// The bytes one edit generation touched, so views can refresh just that part.
+struct EditSpan
+{
+  uint64_t generation;
+  uint64_t offset;
+  uint64_t length;
+};
 
 struct MemoryRegion
 {
@@ -19,41 +60,75 @@ struct MemoryRegion
 class HexData
 {
 public:
-  struct DisasmCache
-  {
-    size_t startOffset;
-    size_t endOffset;
-    bool valid;
-  };
-  Vector<DisasmCache> disasmRanges;
   Vector<MemoryRegion> memoryMap;
   HexData();
   ~HexData();
 
-  ByteBuffer fileData;
   bool virtualAddressToOffset(uint64_t virtualAddress, size_t* outOffset) const;
   bool loadFile(const char* filepath);
+  bool loadBuffer(const uint8_t* data, size_t size);
   bool saveFile(const char* filepath);
+  ReloadResult reloadFromDisk(const char* filepath);
+  ReloadResult detachFromDisk(const char* filepath);
+
+  bool openStream(const char* path);
+  void setStreamLimit(uint64_t bytes) { streamLimit = bytes > 0 ? bytes : STREAM_DEFAULT_LIMIT; }
+  bool isStream() const { return st_is_open(&stream); }
+  uint64_t getStreamReceived() const { return st_received(&stream); }
+  uint64_t getStreamDropped() const { return streamDropped; }
+  bool pollStream();
+
+  bool isLoading() const { return fl_state(&loader) == LOADER_RUNNING || (isStream() && !loadReported); }
+  float getLoadProgress() const;
+  uint64_t getLoadedSize() const;
+  void cancelLoad() { fl_cancel(&loader); st_cancel(&stream); }
+  bool pollLoad();
   void clear();
 
-  bool isRangeDisassembled(size_t startOffset, size_t endOffset);
-  void disassembleRange(size_t offset, size_t size);
+  bool isRangeDisassembled(uint64_t startOffset, uint64_t endOffset);
+  void disassembleRange(uint64_t offset, uint64_t size);
   void clearDisassemblyCache();
+  void invalidateDisassembly(uint64_t offset, uint64_t length);
 
-  const LineArray& getHexLines() const { return hexLines; }
-  const LineArray& getDisassemblyLines() const { return disassemblyLines; }
+  uint64_t getLineCount() const { return isEmpty() ? 0 : (getFileSize() + currentBytesPerLine - 1) / currentBytesPerLine; }
+  const char* getDisassemblyLine(uint64_t lineIndex) const;
   const SimpleString& getHeaderLine() const { return headerLine; }
 
-  size_t getFileSize() const { return fileData.size; }
-  bool isEmpty() const { return fileData.size == 0; }
+  uint64_t getFileSize() const { return pieces.length(); }
+  bool isEmpty() const { return getFileSize() == 0; }
+  bool isMapped() const { return fm_is_open(&fileMap); }
+  uint64_t getEditGeneration() const { return editGeneration; }
+  // Unique per load in this process, unlike the object's address.
+  uint64_t getContentId() const { return contentId; }
+  bool editedSince(uint64_t generation, Vector<ByteExtent>& out) const;
+  size_t readBytes(uint64_t offset, uint8_t* out, size_t length) const { return (size_t)pieces.read(offset, out, length); }
+  void adviseAccess(uint64_t offset, uint64_t length, FileMapAdvice advice);
+  void readAhead(uint64_t viewOffset, uint64_t viewLength);
+  uint64_t memoryUsage() const;
+  uint64_t releaseCaches(uint64_t keepOffset, uint64_t keepLength);
+  bool scanRange(uint64_t offset, uint64_t length, ScanChunkCallback callback, void* context);
+  const ScanStats& getScanStats() const { return scanStats; }
   int getCurrentBytesPerLine() const { return currentBytesPerLine; }
-
-  bool editByte(size_t offset, uint8_t newValue);
-  uint8_t getByte(size_t offset) const;
-  uint8_t readByte(size_t offset) const { return getByte(offset); }
-
-  bool isModified() const { return modified; }
-  void setModified(bool mod) { modified = mod; }
+  bool findDataExtent(uint64_t from, bool forward, uint64_t* outOffset) const { return pieces.findDataStart(from, forward, outOffset); }
+  int getOffsetDigits() const { return getFileSize() > 0xFFFFFFFFull ? 16 : 8; }
+
+  bool editByte(uint64_t offset, uint8_t newValue);
+  bool writeRange(uint64_t offset, const uint8_t* data, uint64_t length);
+  bool fillRange(uint64_t offset, uint64_t length, const uint8_t* pattern, uint32_t patternLength);
+  bool copyRange(uint64_t srcOffset, uint64_t dstOffset, uint64_t length);
+  bool insertBytes(uint64_t offset, const uint8_t* data, uint64_t length);
+  bool deleteBytes(uint64_t offset, uint64_t length);
+  void setOffsetShiftCallback(OffsetShiftCallback callback) { shiftCallback = callback; }
+  uint8_t getByte(uint64_t offset) const;
+  uint8_t readByte(uint64_t offset) const { return getByte(offset); }
+
+  bool isModified() const { return modified || !journal.isAtSavedPoint(); }
+  void setModified(bool mod);
+
+  bool canUndo() const { return journal.canUndo(); }
+  bool canRedo() const { return journal.canRedo(); }
+  bool undo(uint64_t* outOffset = nullptr);
+  bool redo(uint64_t* outOffset = nullptr);
 
   void regenerateHexLines(int bytesPerLine);
   bool isProcessMemory;
@@ -94,7 +169,8 @@ public:
   void executeBookmarkPlugins();
   void convertDataToHex(int bytesPerLine);
 
-  void getHexLine(size_t lineIndex, char* outBuffer, size_t bufferSize) const;
+  void getHexLine(uint64_t lineIndex, char* outBuffer, size_t bufferSize) const;
+  size_t formatHex(uint64_t offset, uint64_t length, char* out) const;
 
 private:
   char pluginPaths[MAX_PLUGINS][512];
@@ -109,10 +185,46 @@ private:
   void disassembleInstruction(size_t offset, int& instructionLength, SimpleString& outInstr);
   bool initializeCapstone();
   void cleanupCapstone();
+  const uint8_t* baseData() const { return fm_is_open(&fileMap) ? fileMap.data : fileData.data; }
+  size_t baseSize() const { return fm_is_open(&fileMap) ? (size_t)fileMap.size : fileData.size; }
+  uint64_t clipToEnd(uint64_t offset, uint64_t length) const;
+  bool detachBase();
+  bool saveInPlace(const char* filepath);
+  void adoptSavedFile(const char* filepath);
+  bool isFilling() const { return isLoading(); }
+  void stopLoading();
+  bool writeBytes(uint64_t offset, const uint8_t* data, uint64_t length, bool mergeable);
+  bool spliceBytes(uint64_t offset, uint64_t removeLength, const uint8_t* data, uint64_t length);
+  void markEdited(uint64_t offset, uint64_t removed, uint64_t inserted);
+  void shiftOffsets(uint64_t offset, uint64_t removed, uint64_t inserted);
 
 private:
-  LineArray hexLines;
-  LineArray disassemblyLines;
+  struct DisasmLine
+  {
+    uint64_t lineIndex;
+    bool valid;
+    char text[DISASM_LINE_LEN];
+  };
+
+  ByteBuffer fileData;
+  FileMapping fileMap;
+  PieceTable pieces;
+  EditJournal journal;
+  uint64_t editGeneration;
+  uint64_t contentId;
+  EditSpan editHistory[EDIT_HISTORY];
+  OffsetShiftCallback shiftCallback;
+  FileLoader loader;
+  bool loadReported;
+  StreamSource stream;
+  StreamStore streamStore;
+  uint64_t streamLimit;
+  uint64_t streamDropped;
+  ScanStats scanStats;
+  uint64_t lastViewOffset;
+  uint64_t readAheadStart;
+  uint64_t readAheadEnd;
+  DisasmLine* disasmLines;
   SimpleString headerLine;
   int currentBytesPerLine;
   bool modified;
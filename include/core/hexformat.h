@@ -0,0 +1,36 @@
+#ifndef HEXFORMAT_H
+#define HEXFORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+enum HexFormatBackend
+{
+  HEXFORMAT_SCALAR,
+  HEXFORMAT_SSSE3,
+  HEXFORMAT_AVX2
+};
+
+// Writes "XX " for every byte, 3 * count characters, no terminator.
+void hf_hex(const uint8_t* src, size_t count, char* out);
+// Writes one character per byte, '.' for control characters and DEL.
+void hf_ascii(const uint8_t* src, size_t count, char* out);
+
+enum ByteClass
+{
+  BYTE_CLASS_ZERO,
+  BYTE_CLASS_PRINTABLE,
+  BYTE_CLASS_WHITESPACE,
+  BYTE_CLASS_CONTROL,
+  BYTE_CLASS_HIGH,
+  BYTE_CLASS_COUNT
+};
+
+// Indexed by byte value; used to color cells without branching per byte.
+extern const uint8_t hf_byte_class[256];
+
+int hf_backend();
+void hf_set_backend(int backend);
+const char* hf_backend_name(int backend);
+
+#endif
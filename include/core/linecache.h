@@ -0,0 +1,65 @@
+#ifndef LINECACHE_H
+#define LINECACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "global.h"
+
+class HexData;
+
+#define LINE_TEXT_SIZE 256
+#define LINE_CACHE_WAYS 4
+#define LINE_CACHE_SETS 64
+#define FRAME_ARENA_SIZE (64u * 1024)
+
+typedef const char* (*LineFetchCallback)(void* context, uint64_t line);
+
+struct LineProvider
+{
+  LineFetchCallback fetch;
+  void* context;
+  uint64_t firstLine;
+  size_t count;
+};
+
+struct FrameArena
+{
+  uint8_t* data;
+  size_t capacity;
+  size_t used;
+};
+
+struct LineCacheSlot
+{
+  const HexData* owner;
+  uint64_t generation;
+  uint64_t line;
+  uint64_t lastUse;
+  int bytesPerLine;
+  bool valid;
+};
+
+struct LineCache
+{
+  LineCacheSlot slots[LINE_CACHE_SETS * LINE_CACHE_WAYS];
+  char* text;
+  FrameArena arena;
+  const HexData* data;
+  uint64_t clock;
+  uint64_t hits;
+  uint64_t misses;
+};
+
+void fa_init(FrameArena* a);
+void fa_reset(FrameArena* a);
+void* fa_alloc(FrameArena* a, size_t size);
+void fa_free(FrameArena* a);
+
+void lc_init(LineCache* c);
+void lc_free(LineCache* c);
+void lc_invalidate(LineCache* c);
+LineProvider lc_begin_frame(LineCache* c, const HexData* data, uint64_t firstLine, size_t count);
+const char* lc_get_line(LineCache* c, uint64_t line);
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef MINIMAP_H
+#define MINIMAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "global.h"
+
+class HexData;
+
+#define MINIMAP_WIDTH 12
+#define MINIMAP_MAX_LEAVES 16384
+#define MINIMAP_MIN_LEAF 4096
+#define MINIMAP_LEVELS 15
+#define MINIMAP_SAMPLE_SPANS 4
+#define MINIMAP_SAMPLE_SPAN 4096
+#define MINIMAP_SLICE_US 6000
+#define MINIMAP_STALE 0x80
+
+enum MinimapClass
+{
+  MINIMAP_ZERO,
+  MINIMAP_TEXT,
+  MINIMAP_ENTROPY,
+  MINIMAP_OTHER,
+  MINIMAP_CLASSES,
+  MINIMAP_UNKNOWN = -1
+};
+
+// Leaves classified so far beneath a node, by class.
+struct MinimapNode
+{
+  uint32_t counts[MINIMAP_CLASSES];
+};
+
+// Level 0 holds one node per leaf; every level above halves the node count,
+// so a range of any size is answered from at most three nodes of the level
+// whose block size fits it. Edited leaves keep their old class, flagged
+// MINIMAP_STALE, until they are classified again.
+struct Minimap
+{
+  const HexData* owner;
+  uint64_t generation;
+  uint64_t fileSize;
+  uint64_t leafBytes;
+  uint32_t leafCount;
+  uint32_t built;
+  uint32_t stale;
+  uint32_t staleFrom;
+  uint8_t leaves[MINIMAP_MAX_LEAVES];
+  int levelCount;
+  uint32_t levelStart[MINIMAP_LEVELS];
+  uint32_t levelSize[MINIMAP_LEVELS];
+  MinimapNode* nodes;
+  uint32_t nodeCapacity;
+};
+
+void mm_init(Minimap* m);
+void mm_free(Minimap* m);
+bool mm_step(Minimap* m, const HexData* data, uint64_t budgetUs);
+bool mm_is_building(const Minimap* m);
+int mm_class_at(const Minimap* m, uint64_t start, uint64_t end);
+
+#endif
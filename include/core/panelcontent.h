@@ -80,6 +80,8 @@ struct BookmarksState {
     Vector<Bookmark> bookmarks;
     int selectedIndex;
     int hoveredIndex;
+    Vector<int> byOffset;
+    bool indexDirty;
 };
 
 struct ByteStatistics {
@@ -141,7 +143,10 @@ void Bookmarks_Add(long long byteOffset, const char* name, Color color);
 void Bookmarks_Remove(int index);
 void Bookmarks_JumpTo(int index);
 void Bookmarks_clear();
+void Bookmarks_ShiftOffsets(uint64_t offset, uint64_t removed, uint64_t inserted);
 int Bookmarks_findAtOffset(long long byteOffset);
+void Bookmarks_Invalidate();
+int Bookmarks_LowerBound(long long byteOffset);
 const Bookmark* Bookmarks_GetAtOffset(long long byteOffset);
 
 void ByteStats_Compute(HexData& hexData);
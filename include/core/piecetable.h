@@ -0,0 +1,108 @@
+#ifndef PIECETABLE_H
+#define PIECETABLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "global.h"
+#include "filemap.h"
+
+enum PieceSource
+{
+  PIECE_ORIGINAL,
+  PIECE_ADD,
+  PIECE_FILL,
+  PIECE_ZERO
+};
+
+typedef uint64_t (*OriginalReadCallback)(const void* context, uint64_t offset, uint8_t* out, uint64_t length);
+
+struct Piece
+{
+  uint8_t source;
+  uint64_t start;
+  uint64_t length;
+  uint32_t patternLength;
+  uint32_t phase;
+};
+
+struct PieceNode
+{
+  Piece piece;
+  uint64_t subtreeLength;
+  uint32_t priority;
+  int left;
+  int right;
+};
+
+class PieceTable
+{
+public:
+  PieceTable();
+  ~PieceTable();
+
+  void reset(const uint8_t* original, uint64_t originalSize);
+  bool resetExtents(const uint8_t* original, uint64_t originalSize, const Vector<ByteExtent>& dataExtents);
+  void clear();
+  void setOriginal(const uint8_t* data) { original = data; originalRead = nullptr; originalContext = nullptr; }
+  void setOriginalMapping(const FileMapping* mapping);
+  void setOriginalReader(OriginalReadCallback read, const void* context) { original = nullptr; originalRead = read; originalContext = context; }
+
+  uint64_t length() const { return root >= 0 ? nodes[root].subtreeLength : 0; }
+  bool isPristine() const;
+  int pieceCount() const { return liveNodes; }
+  uint64_t memoryUsage() const { return (uint64_t)nodeCapacity * sizeof(PieceNode) + addBuffer.capacity; }
+
+  uint8_t byteAt(uint64_t pos) const;
+  uint64_t read(uint64_t pos, uint8_t* out, uint64_t len) const;
+  bool locate(uint64_t pos, Piece* outPiece, uint64_t* outOffsetInPiece) const;
+  const uint8_t* sourceData(const Piece& piece) const;
+  void copyOut(const Piece& piece, uint64_t offset, uint8_t* out, uint64_t len) const;
+  bool collect(uint64_t pos, uint64_t len, Vector<Piece>& out) const;
+  bool findDataStart(uint64_t pos, bool forward, uint64_t* outPos) const;
+
+  bool replace(uint64_t pos, uint64_t removeLength, const uint8_t* data, uint64_t dataLength);
+  bool fill(uint64_t pos, uint64_t removeLength, uint64_t fillLength, const uint8_t* pattern, uint32_t patternLength);
+  bool copy(uint64_t srcPos, uint64_t copyLength, uint64_t dstPos, uint64_t removeLength);
+  bool replacePieces(uint64_t pos, uint64_t removeLength, const Piece* inserted, int count);
+
+  void dirtyExtents(Vector<ByteExtent>& out) const;
+  uint64_t detachCost(const Vector<ByteExtent>& extents) const;
+  bool detachOriginal(const Vector<ByteExtent>& extents);
+  bool overlapsOriginal(const Piece& piece, const Vector<ByteExtent>& extents) const;
+  bool detachPiece(Piece& piece);
+  void rebase(Piece* retained, size_t count);
+
+private:
+  PieceTable(const PieceTable&);
+  PieceTable& operator=(const PieceTable&);
+
+  const uint8_t* original;
+  OriginalReadCallback originalRead;
+  const void* originalContext;
+  uint64_t originalSize;
+  ByteBuffer addBuffer;
+
+  PieceNode* nodes;
+  int nodeCapacity;
+  int nodeCount;
+  int freeList;
+  int liveNodes;
+  int root;
+  uint32_t seed;
+
+  uint32_t nextPriority();
+  bool reserveNodes(int extra);
+  int allocNode(const Piece& piece);
+  void releaseTree(int t);
+  void update(int t);
+  uint64_t lengthOf(int t) const { return t >= 0 ? nodes[t].subtreeLength : 0; }
+  void split(int t, uint64_t pos, int& outLeft, int& outRight);
+  int merge(int a, int b);
+  bool extendRightmost(int t, const Piece& piece);
+  void dirtyTree(int t, uint64_t base, Vector<ByteExtent>& out) const;
+  uint64_t detachCostTree(int t, const Vector<ByteExtent>& extents) const;
+  bool detachTree(int t, const Vector<ByteExtent>& extents);
+};
+
+#endif
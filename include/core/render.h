@@ -13,6 +13,12 @@
 #endif
 
 #include "global.h"
+#include "linecache.h"
+#include "hexformat.h"
+#include "minimap.h"
+#if !defined(_WIN32) && !defined(__APPLE__)
+#include "x11canvas.h"
+#endif
 
 struct PatternSearchState;
 struct ChecksumState;
@@ -80,6 +86,9 @@ struct Theme
   Color menuBorder;
   Color disabledText;
 
+  Color byteColors[BYTE_CLASS_COUNT];
+  Color overviewColors[MINIMAP_CLASSES];
+
   static Theme Dark()
   {
     Theme t;
@@ -109,6 +118,17 @@ struct Theme
     t.menuBorder = Color(255, 255, 255, 15);
     t.disabledText = Color(255, 255, 255, 80);
 
+    t.byteColors[BYTE_CLASS_ZERO] = Color(120, 120, 120);
+    t.byteColors[BYTE_CLASS_PRINTABLE] = Color(118, 215, 235);
+    t.byteColors[BYTE_CLASS_WHITESPACE] = Color(150, 220, 120);
+    t.byteColors[BYTE_CLASS_CONTROL] = Color(235, 150, 90);
+    t.byteColors[BYTE_CLASS_HIGH] = Color(235, 205, 100);
+
+    t.overviewColors[MINIMAP_ZERO] = Color(70, 70, 70);
+    t.overviewColors[MINIMAP_TEXT] = Color(118, 215, 235);
+    t.overviewColors[MINIMAP_ENTROPY] = Color(205, 110, 205);
+    t.overviewColors[MINIMAP_OTHER] = Color(110, 140, 190);
+
     return t;
   }
 
@@ -141,6 +161,17 @@ struct Theme
     t.menuBorder = Color(0, 0, 0, 15);
     t.disabledText = Color(0, 0, 0, 90);
 
+    t.byteColors[BYTE_CLASS_ZERO] = Color(150, 150, 150);
+    t.byteColors[BYTE_CLASS_PRINTABLE] = Color(0, 110, 160);
+    t.byteColors[BYTE_CLASS_WHITESPACE] = Color(40, 130, 40);
+    t.byteColors[BYTE_CLASS_CONTROL] = Color(190, 90, 20);
+    t.byteColors[BYTE_CLASS_HIGH] = Color(150, 110, 0);
+
+    t.overviewColors[MINIMAP_ZERO] = Color(215, 215, 215);
+    t.overviewColors[MINIMAP_TEXT] = Color(0, 130, 180);
+    t.overviewColors[MINIMAP_ENTROPY] = Color(170, 60, 160);
+    t.overviewColors[MINIMAP_OTHER] = Color(120, 140, 175);
+
     return t;
   }
 };
@@ -299,6 +330,20 @@ struct BottomPanelState
   }
 };
 
+#define MAX_DAMAGE_RECTS 8
+
+struct DamageRegion
+{
+  Rect rects[MAX_DAMAGE_RECTS];
+  int count;
+};
+
+struct DocumentTab
+{
+  char label[32];
+  Rect bounds;
+};
+
 struct SelectionState
 {
   bool active;
@@ -545,6 +590,17 @@ public:
 
   void beginFrame();
   void endFrame(NativeDrawContext ctx);
+  void invalidate(const Rect& rect);
+  void invalidateAll();
+  bool hasDamage() const { return damage.count > 0; }
+  int getDamageCount() const { return damage.count; }
+  Rect getDamageRect(int index) const { return damage.rects[index]; }
+  bool isDamaged(const Rect& rect) const;
+  void setClip(const Rect& rect);
+  void resetClip();
+  bool isClipped(const Rect& rect) const;
+  uint32_t getDrawCalls() const { return drawCalls; }
+  void resetDrawCalls() { drawCalls = 0; }
   void clear(const Color& color);
   void drawRect(const Rect& rect, const Color& color, bool filled = true);
   void drawLine(int x1, int y1, int x2, int y2, const Color& color);
@@ -558,6 +614,7 @@ public:
   PointF GetBytePointF(Point gridPoint);
   BytePositionInfo GetHexBytePositionInfo(Point screenPoint);
   void drawProgressBar(const Rect& rect, float progress, const Theme& theme);
+  void drawDocumentTabs(const DocumentTab* tabs, int count, int activeIndex, const Theme& theme);
   void UpdateCaret();
   void DrawCaret();
   long long ScreenToByteIndex(int mouseX, int mouseY);
@@ -603,6 +660,7 @@ public:
   int getContextMenuHoveredItem(int mouseX, int mouseY, const ContextMenuState& state);
   void drawContextMenu(const ContextMenuState& state, const Theme& theme);
   bool isPointInContextMenu(int mouseX, int mouseY, const ContextMenuState& state);
+  Rect getContextMenuBounds(const ContextMenuState& state);
 
   int getSectionHeaderY(const LeftPanelState& state, int sectionIndex, int menuBarHeight);
   int getItemY(const LeftPanelState& state, int sectionIndex, int itemIndex, int menuBarHeight);
@@ -614,6 +672,7 @@ public:
   int getDisasmColumnWidth() const { return _disasmColumnWidth; }
   void setDisasmColumnWidth(int width) { _disasmColumnWidth = width; }
   bool isResizingDisasmColumn() const { return _resizingDisasmColumn; }
+  const Rect& getMinimapRect() const { return _minimapRect; }
 
 
 
@@ -626,7 +685,7 @@ public:
 #endif
 
   void drawDropdown(const WidgetState& state, const Theme& theme, const char* selectedText, bool isOpen, const Vector<char*>& items, int selectedIndex, int hoveredIndex, int scrollOffset);
-  void renderHexViewer(const Vector<char*>& hexLines, const char* headerLine, int scrollPos, int maxScrollPos, bool scrollbarHovered, bool scrollbarPressed, const Rect& scrollbarRect, const Rect& thumbRect, bool darkMode, int editingRow, int editingCol, const char* editBuffer, long long cursorBytePos, int cursorNibblePos, long long totalBytes, int leftPanelWidth, int effectiveWindowHeight = 0);
+  void renderHexViewer(const LineProvider& lines, const char* headerLine, long long scrollPos, long long maxScrollPos, bool scrollbarHovered, bool scrollbarPressed, const Rect& scrollbarRect, const Rect& thumbRect, bool darkMode, int editingRow, int editingCol, const char* editBuffer, long long cursorBytePos, int cursorNibblePos, long long totalBytes, int leftPanelWidth, int effectiveWindowHeight = 0);
 
   Theme getCurrentTheme() const { return currentTheme; }
 
@@ -638,10 +697,17 @@ public:
   void setContext(void* ctx); 
 #endif
 private:
+  void drawByteClassLine(const char* line, int x, int y);
+  void drawMinimap(const Rect& bounds);
+
   NativeWindow window;
   int windowWidth;
   int windowHeight;
   Theme currentTheme;
+  DamageRegion damage;
+  Rect clipRect;
+  bool clipping;
+  uint32_t drawCalls;
   long long _bytePos;
   int _byteCharacterPos;
   long long _startByte;
@@ -656,6 +722,7 @@ private:
 
   int _disasmColumnWidth;
   bool _resizingDisasmColumn;
+  Rect _minimapRect;
   int _resizeStartX;
   int _resizeStartWidth;
 
@@ -691,7 +758,8 @@ private:
 #else
   Display* display;
   GC gc;
-  Pixmap backBuffer;
+  X11Canvas canvas;
+  GlyphAtlas atlas;
   XFontStruct* fontInfo;
 #endif
   void setColor(const Color& color);
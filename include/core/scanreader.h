@@ -0,0 +1,37 @@
+#ifndef SCANREADER_H
+#define SCANREADER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "global.h"
+#include "filemap.h"
+
+#define SCAN_CHUNK (1u * 1024 * 1024)
+#define SCAN_DEPTH 16
+#define SCAN_THREADS 4
+
+enum ScanBackend
+{
+  SCAN_BACKEND_NONE,
+  SCAN_BACKEND_MEMORY,
+  SCAN_BACKEND_THREADS,
+  SCAN_BACKEND_IO_URING
+};
+
+typedef bool (*ScanChunkCallback)(void* context, uint64_t offset, const uint8_t* data, size_t length);
+
+struct ScanStats
+{
+  uint64_t bytes;
+  uint64_t microseconds;
+  int backend;
+};
+
+uint64_t sr_now_us();
+bool sr_scan_file(const FileMapping* m, uint64_t offset, uint64_t length,
+                  ScanChunkCallback callback, void* context, ScanStats* stats);
+uint64_t sr_throughput(const ScanStats* stats);
+const char* sr_backend_name(int backend);
+
+#endif
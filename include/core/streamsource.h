@@ -0,0 +1,85 @@
+#ifndef STREAMSOURCE_H
+#define STREAMSOURCE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "global.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#define STREAM_CHUNK (256u * 1024)
+#define STREAM_BACKLOG (64u * 1024 * 1024)
+#define STREAM_STORE_CHUNK (1u * 1024 * 1024)
+#define STREAM_DEFAULT_LIMIT (256ull * 1024 * 1024)
+
+enum StreamState
+{
+  STREAM_IDLE,
+  STREAM_RUNNING,
+  STREAM_ENDED,
+  STREAM_CANCELLED,
+  STREAM_FAILED
+};
+
+struct StreamChunk
+{
+  uint8_t* data;
+  size_t length;
+};
+
+struct StreamSource
+{
+  char path[MAX_PATH_LEN];
+  Vector<StreamChunk> chunks;
+  size_t consumed;
+  uint64_t pending;
+  uint64_t received;
+  int state;
+  int cancelRequested;
+  bool threadStarted;
+#ifdef _WIN32
+  HANDLE handle;
+  bool ownHandle;
+  CRITICAL_SECTION lock;
+  HANDLE thread;
+#else
+  int fd;
+  bool ownFd;
+  pthread_mutex_t lock;
+  pthread_t thread;
+#endif
+};
+
+// Received bytes kept in fixed-size chunks on a ring. Positions are absolute
+// offsets into the stream; trimming frees whole chunks from the front.
+struct StreamStore
+{
+  uint8_t** slots;
+  size_t capacity;
+  size_t head;
+  size_t count;
+  uint64_t base;
+  uint64_t end;
+};
+
+void st_init(StreamSource* s);
+bool st_is_stream_path(const char* path);
+bool st_open(StreamSource* s, const char* path);
+void st_close(StreamSource* s);
+void st_cancel(StreamSource* s);
+bool st_is_open(const StreamSource* s);
+int st_state(const StreamSource* s);
+uint64_t st_received(const StreamSource* s);
+size_t st_available(StreamSource* s);
+size_t st_drain(StreamSource* s, uint8_t* out, size_t max);
+
+void st_store_init(StreamStore* store);
+void st_store_free(StreamStore* store);
+bool st_store_append(StreamStore* store, StreamSource* s, size_t max);
+uint64_t st_store_trim(StreamStore* store, uint64_t limit);
+uint64_t st_store_read(const StreamStore* store, uint64_t pos, uint8_t* out, uint64_t length);
+
+#endif
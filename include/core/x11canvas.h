@@ -0,0 +1,64 @@
+#ifndef X11CANVAS_H
+#define X11CANVAS_H
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+
+#include <stdint.h>
+#include <stddef.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+
+#include "global.h"
+
+#define GLYPH_COUNT 256
+
+struct GlyphAtlas
+{
+  uint8_t* coverage;
+  int cellWidth;
+  int cellHeight;
+  int ascent;
+  uint8_t blank[GLYPH_COUNT];
+};
+
+// Client-side 0xAARRGGBB frame for a 24/32-bit TrueColor visual. Colors passed
+// to the drawing calls are composited source-over using their alpha byte.
+struct X11Canvas
+{
+  Display* display;
+  XImage* image;
+  uint32_t* pixels;
+  int width;
+  int height;
+  int clipLeft;
+  int clipTop;
+  int clipRight;
+  int clipBottom;
+  bool shm;
+  XShmSegmentInfo shmInfo;
+};
+
+void ga_init(GlyphAtlas* a);
+bool ga_build(GlyphAtlas* a, Display* display, Drawable drawable, XFontStruct* font);
+void ga_free(GlyphAtlas* a);
+
+void xc_init(X11Canvas* c);
+bool xc_resize(X11Canvas* c, Display* display, int width, int height);
+void xc_free(X11Canvas* c);
+void xc_set_clip(X11Canvas* c, int x, int y, int width, int height);
+void xc_reset_clip(X11Canvas* c);
+void xc_fill_rect(X11Canvas* c, int x, int y, int width, int height, uint32_t argb);
+void xc_frame_rect(X11Canvas* c, int x, int y, int width, int height, uint32_t argb);
+void xc_line(X11Canvas* c, int x1, int y1, int x2, int y2, uint32_t argb);
+void xc_fill_ellipse(X11Canvas* c, int x, int y, int width, int height, uint32_t argb);
+void xc_frame_ellipse(X11Canvas* c, int x, int y, int width, int height, uint32_t argb);
+void xc_text(X11Canvas* c, const GlyphAtlas* a, const char* text, int x, int baseline, uint32_t argb);
+void xc_blit(X11Canvas* c, XImage* src, int width, int height, int x, int y);
+void xc_present(X11Canvas* c, Drawable target, GC gc);
+void xc_present_rect(X11Canvas* c, Drawable target, GC gc, int x, int y, int width, int height);
+void xc_finish(X11Canvas* c);
+
+#endif
+
+#endif
@@ -44,7 +44,14 @@ enum ContextMenuAction
   ID_FILL_FF = 111,
   ID_FILL_PATTERN = 112,
   ID_ADD_BOOKMARK = 114,
-  ID_SELECT_BLOCK = 115
+  ID_SELECT_BLOCK = 115,
+  ID_UNDO = 116,
+  ID_REDO = 117,
+  ID_INSERT_BYTE = 118,
+  ID_DELETE_BYTES = 119,
+  ID_FOLLOW_TAIL = 120,
+  ID_NEXT_DATA_EXTENT = 121,
+  ID_PREV_DATA_EXTENT = 122
 };
 
 long long ParseNumber(const char* text, int numberFormat);
@@ -77,6 +77,8 @@ private:
     void destroyNativeMenu();
     int getMenuIndexAt(int mx, int my) const;
     int getMenuItemIndexAt(int menuIndex, int mx, int my) const;
+    Rect getDropdownRect() const;
+    Rect getSubmenuRect() const;
 
 public:
     MenuBar();
@@ -96,6 +98,7 @@ public:
 
     bool containsPoint(int px, int py) const;
     Rect getBounds(int windowWidth) const;
+    int getDamageRects(int windowWidth, Rect *out) const;
 
     void closeAllMenus();
     void openMenu(int menuIndex);
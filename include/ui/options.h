@@ -9,11 +9,14 @@
 struct AppOptions {
   bool darkMode;
   bool bookmarkHighlights;
+  bool byteClassColors;
   int defaultBytesPerLine;
   bool autoReload;
   bool contextMenu;
   char language[64];
   int fontSize;
+  int streamBufferMB;
+  int memoryBudgetMB;
   char fontName[64];
   char enabledPlugins[10][128];
   int enabledPluginCount;
@@ -21,10 +24,13 @@ struct AppOptions {
   AppOptions()
     : darkMode(true),
 		bookmarkHighlights(false),
+    byteClassColors(false),
     defaultBytesPerLine(16),
     autoReload(true),
     contextMenu(false),
-    fontSize(14) {
+    fontSize(14),
+    streamBufferMB(256),
+    memoryBudgetMB(2048) {
     language[0] = 'E';
     language[1] = 'n';
     language[2] = 'g';
@@ -37,10 +43,13 @@ struct AppOptions {
 
   AppOptions(bool dark, int bpl, bool reload, bool ctx, const char* lang)
     : darkMode(dark),
+    byteClassColors(false),
     defaultBytesPerLine(bpl),
     autoReload(reload),
     contextMenu(ctx),
-    fontSize(14) {
+    fontSize(14),
+    streamBufferMB(256),
+    memoryBudgetMB(2048) {
     strCopy(fontName, "Consolas");
     int i = 0;
     while (lang && lang[i] && i < 63) {
@@ -53,10 +62,13 @@ struct AppOptions {
   AppOptions(const AppOptions& other)
     : darkMode(other.darkMode),
     bookmarkHighlights(other.bookmarkHighlights),
+    byteClassColors(other.byteClassColors),
     defaultBytesPerLine(other.defaultBytesPerLine),
     autoReload(other.autoReload),
     contextMenu(other.contextMenu),
-    fontSize(other.fontSize) {
+    fontSize(other.fontSize),
+    streamBufferMB(other.streamBufferMB),
+    memoryBudgetMB(other.memoryBudgetMB) {
     strCopy(fontName, other.fontName);
     for (int i = 0; i < 64; i++) {
       language[i] = other.language[i];
@@ -68,10 +80,13 @@ struct AppOptions {
     if (this != &other) {
       darkMode = other.darkMode;
       bookmarkHighlights = other.bookmarkHighlights;
+      byteClassColors = other.byteClassColors;
       defaultBytesPerLine = other.defaultBytesPerLine;
       autoReload = other.autoReload;
       contextMenu = other.contextMenu;
       fontSize = other.fontSize;
+      streamBufferMB = other.streamBufferMB;
+      memoryBudgetMB = other.memoryBudgetMB;
       strCopy(fontName, other.fontName);
 
       for (int i = 0; i < 64; i++) {
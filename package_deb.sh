@@ -35,6 +35,7 @@ check_and_install "CMake" "cmake" "cmake"
 check_and_install "Ninja" "ninja" "ninja-build"
 check_and_install "C++ Compiler" "g++" "build-essential"
 check_and_install "X11 Development Library" "" "libx11-dev"
+check_and_install "X11 Extension Development Library" "" "libxext-dev"
 check_and_install "Libcurl Development Library" "" "libcurl4-openssl-dev"
 check_and_install "dpkg-dev" "dpkg-shlibdeps" "dpkg-dev"
 
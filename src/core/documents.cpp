@@ -0,0 +1,127 @@
+#include "documents.h"
+
+static void reset_view(DocumentView* v)
+{
+  v->path[0] = '\0';
+  v->cursorBytePos = -1;
+  v->cursorNibblePos = 0;
+  v->scrollY = 0;
+  v->selection.clear();
+  v->bookmarks.bookmarks.clear();
+  v->bookmarks.selectedIndex = -1;
+  v->bookmarks.hoveredIndex = -1;
+  v->bookmarks.byOffset.clear();
+  v->bookmarks.indexDirty = true;
+  memSet(&v->byteStats, 0, sizeof(v->byteStats));
+  memSet(&v->die, 0, sizeof(v->die));
+  v->followTail = false;
+  v->afterLoadCount = 0;
+}
+
+void ds_init(DocumentSet* s)
+{
+  s->count = 0;
+  s->active = -1;
+  s->clock = 0;
+  for (int i = 0; i < MAX_DOCUMENTS; i++)
+    s->items[i] = nullptr;
+}
+
+int ds_add(DocumentSet* s)
+{
+  if (s->count >= MAX_DOCUMENTS)
+    return -1;
+
+  Document* doc = new Document();
+  if (!doc)
+    return -1;
+
+  reset_view(&doc->view);
+  doc->lastActive = ++s->clock;
+  doc->memoryUsage = 0;
+  s->items[s->count] = doc;
+  return s->count++;
+}
+
+void ds_remove(DocumentSet* s, int index)
+{
+  if (index < 0 || index >= s->count)
+    return;
+
+  delete s->items[index];
+  for (int i = index; i < s->count - 1; i++)
+    s->items[i] = s->items[i + 1];
+  s->items[--s->count] = nullptr;
+
+  if (s->active > index || s->active >= s->count)
+    s->active--;
+}
+
+void ds_activate(DocumentSet* s, int index)
+{
+  if (index < 0 || index >= s->count)
+    return;
+
+  s->active = index;
+  s->items[index]->lastActive = ++s->clock;
+}
+
+Document* ds_active(DocumentSet* s)
+{
+  return s->active >= 0 ? s->items[s->active] : nullptr;
+}
+
+// Refreshes each document's cached figure; releases then adjust it in place.
+uint64_t ds_memory_usage(DocumentSet* s)
+{
+  uint64_t usage = 0;
+  for (int i = 0; i < s->count; i++)
+  {
+    s->items[i]->memoryUsage = s->items[i]->data.memoryUsage();
+    usage += s->items[i]->memoryUsage;
+  }
+  return usage;
+}
+
+static uint64_t release_document(Document* doc, uint64_t keepOffset, uint64_t keepLength)
+{
+  uint64_t released = doc->data.releaseCaches(keepOffset, keepLength);
+  if (released > doc->memoryUsage)
+    released = doc->memoryUsage;
+  doc->memoryUsage -= released;
+  return released;
+}
+
+// Inactive documents give up their caches coldest first; the active document
+// is only trimmed down to the visible window once nothing else is left.
+uint64_t ds_enforce_budget(DocumentSet* s, uint64_t budget, uint64_t keepOffset, uint64_t keepLength)
+{
+  uint64_t usage = ds_memory_usage(s);
+  if (budget == 0 || usage <= budget)
+    return usage;
+
+  bool released[MAX_DOCUMENTS] = {};
+  for (;;)
+  {
+    int coldest = -1;
+    for (int i = 0; i < s->count; i++)
+    {
+      if (i == s->active || released[i])
+        continue;
+      if (coldest < 0 || s->items[i]->lastActive < s->items[coldest]->lastActive)
+        coldest = i;
+    }
+    if (coldest < 0)
+      break;
+
+    released[coldest] = true;
+    usage -= release_document(s->items[coldest], 0, 0);
+    if (usage <= budget)
+      return usage;
+  }
+
+  Document* active = ds_active(s);
+  if (active)
+    usage -= release_document(active, keepOffset, keepLength);
+  return usage;
+}
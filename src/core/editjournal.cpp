@@ -0,0 +1,209 @@
+#include "editjournal.h"
+
+static bool isContinuation(const Piece& a, const Piece& b)
+{
+  if (a.source != b.source || a.source == PIECE_FILL)
+    return false;
+  return a.start + a.length == b.start;
+}
+
+EditJournal::EditJournal()
+  : position(0),
+  savedPosition(0),
+  pending(false),
+  pendingMerge(false),
+  pendingOffset(0),
+  pendingOldLength(0),
+  pendingNewLength(0),
+  pendingMergeable(false)
+{
+}
+
+void EditJournal::clear()
+{
+  records.clear();
+  journalPieces.clear();
+  pendingOld.clear();
+  position = 0;
+  savedPosition = 0;
+  pending = false;
+}
+
+void EditJournal::appendPieces(const Vector<Piece>& source)
+{
+  for (size_t i = 0; i < source.size(); i++)
+  {
+    journalPieces.push_back(source[i]);
+  }
+}
+
+void EditJournal::truncatePieces(size_t count)
+{
+  while (journalPieces.size() > count)
+    journalPieces.remove(journalPieces.size() - 1);
+}
+
+bool EditJournal::begin(const PieceTable& pieces, uint64_t offset, uint64_t oldLength, uint64_t newLength, bool mergeable)
+{
+  pending = false;
+  pendingMerge = false;
+  pendingOld.clear();
+
+  if (mergeable && oldLength == newLength &&
+    position > 0 && position == records.size() &&
+    savedPosition != (long long)position)
+  {
+    const EditRecord& last = records[position - 1];
+    uint64_t lastEnd = last.offset + last.newLength;
+
+    if (last.mergeable && last.oldLength == last.newLength &&
+      offset >= last.offset && offset <= lastEnd)
+    {
+      pendingMerge = true;
+
+      uint64_t end = offset + oldLength;
+      if (end > lastEnd && !pieces.collect(lastEnd, end - lastEnd, pendingOld))
+        return false;
+    }
+  }
+
+  if (!pendingMerge && !pieces.collect(offset, oldLength, pendingOld))
+    return false;
+
+  pending = true;
+  pendingOffset = offset;
+  pendingOldLength = oldLength;
+  pendingNewLength = newLength;
+  pendingMergeable = mergeable;
+  return true;
+}
+
+void EditJournal::commit(const PieceTable& pieces)
+{
+  if (!pending)
+    return;
+  pending = false;
+
+  Vector<Piece> inserted;
+
+  if (pendingMerge)
+  {
+    EditRecord& last = records[position - 1];
+    uint64_t end = pendingOffset + pendingOldLength;
+    if (end > last.offset + last.oldLength)
+      last.oldLength = end - last.offset;
+    last.newLength = last.oldLength;
+
+    truncatePieces(last.newFirst);
+    for (size_t i = 0; i < pendingOld.size(); i++)
+    {
+      if (last.oldCount > 0 && isContinuation(journalPieces[journalPieces.size() - 1], pendingOld[i]))
+      {
+        journalPieces[journalPieces.size() - 1].length += pendingOld[i].length;
+        continue;
+      }
+      journalPieces.push_back(pendingOld[i]);
+      last.oldCount++;
+    }
+
+    pieces.collect(last.offset, last.newLength, inserted);
+    last.newFirst = journalPieces.size();
+    last.newCount = inserted.size();
+    appendPieces(inserted);
+    pendingOld.clear();
+    return;
+  }
+
+  if (position < records.size())
+  {
+    truncatePieces(records[position].oldFirst);
+    while (records.size() > position)
+      records.remove(records.size() - 1);
+    if (savedPosition > (long long)position)
+      savedPosition = -1;
+  }
+
+  pieces.collect(pendingOffset, pendingNewLength, inserted);
+
+  EditRecord record;
+  record.offset = pendingOffset;
+  record.oldLength = pendingOldLength;
+  record.newLength = pendingNewLength;
+  record.oldFirst = journalPieces.size();
+  record.oldCount = pendingOld.size();
+  appendPieces(pendingOld);
+  record.newFirst = journalPieces.size();
+  record.newCount = inserted.size();
+  appendPieces(inserted);
+  record.mergeable = pendingMergeable;
+
+  records.push_back(record);
+  position = records.size();
+  pendingOld.clear();
+}
+
+bool EditJournal::undo(PieceTable& pieces, uint64_t* outOffset, uint64_t* outRemoved, uint64_t* outInserted)
+{
+  if (!canUndo())
+    return false;
+
+  const EditRecord& record = records[position - 1];
+  const Piece* old = record.oldCount ? &journalPieces[record.oldFirst] : nullptr;
+  if (!pieces.replacePieces(record.offset, record.newLength, old, (int)record.oldCount))
+    return false;
+
+  position--;
+  if (outOffset)
+    *outOffset = record.offset;
+  if (outRemoved)
+    *outRemoved = record.newLength;
+  if (outInserted)
+    *outInserted = record.oldLength;
+  return true;
+}
+
+bool EditJournal::redo(PieceTable& pieces, uint64_t* outOffset, uint64_t* outRemoved, uint64_t* outInserted)
+{
+  if (!canRedo())
+    return false;
+
+  const EditRecord& record = records[position];
+  const Piece* inserted = record.newCount ? &journalPieces[record.newFirst] : nullptr;
+  if (!pieces.replacePieces(record.offset, record.oldLength, inserted, (int)record.newCount))
+    return false;
+
+  position++;
+  if (outOffset)
+    *outOffset = record.offset;
+  if (outRemoved)
+    *outRemoved = record.oldLength;
+  if (outInserted)
+    *outInserted = record.newLength;
+  return true;
+}
+
+uint64_t EditJournal::detachCost(const PieceTable& pieces, const Vector<ByteExtent>& extents) const
+{
+  uint64_t cost = 0;
+  for (size_t i = 0; i < journalPieces.size(); i++)
+  {
+    if (pieces.overlapsOriginal(journalPieces[i], extents))
+      cost += journalPieces[i].length;
+  }
+  return cost;
+}
+
+bool EditJournal::detachOriginal(PieceTable& pieces, const Vector<ByteExtent>& extents)
+{
+  for (size_t i = 0; i < journalPieces.size(); i++)
+  {
+    if (pieces.overlapsOriginal(journalPieces[i], extents) && !pieces.detachPiece(journalPieces[i]))
+      return false;
+  }
+  return true;
+}
+
+void EditJournal::rebase(PieceTable& pieces)
+{
+  pieces.rebase(journalPieces.empty() ? nullptr : &journalPieces[0], journalPieces.size());
+}
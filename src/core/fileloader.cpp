@@ -0,0 +1,170 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#endif
+
+#include "fileloader.h"
+
+#define LOADER_CHUNK (4u * 1024 * 1024)
+
+#ifdef _WIN32
+#define LOADER_STORE(p, v) InterlockedExchange64((volatile LONG64*)(p), (LONG64)(v))
+#define LOADER_LOAD(p) InterlockedCompareExchange64((volatile LONG64*)(p), 0, 0)
+#define LOADER_STORE_INT(p, v) InterlockedExchange((volatile LONG*)(p), (LONG)(v))
+#define LOADER_LOAD_INT(p) InterlockedCompareExchange((volatile LONG*)(p), 0, 0)
+#else
+#define LOADER_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define LOADER_LOAD(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define LOADER_STORE_INT(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define LOADER_LOAD_INT(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#endif
+
+static bool read_chunks(FileLoader* l)
+{
+#ifdef _WIN32
+  HANDLE hFile = CreateFileA(l->path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                             NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (hFile == INVALID_HANDLE_VALUE)
+    return false;
+#else
+  int fd = open(l->path, O_RDONLY);
+  if (fd < 0)
+    return false;
+#endif
+
+  bool ok = true;
+  uint64_t done = 0;
+  while (done < l->total && !LOADER_LOAD_INT(&l->cancelRequested))
+  {
+    uint64_t chunk = l->total - done;
+    if (chunk > LOADER_CHUNK)
+      chunk = LOADER_CHUNK;
+
+#ifdef _WIN32
+    DWORD got = 0;
+    if (!ReadFile(hFile, l->target + done, (DWORD)chunk, &got, NULL) || got == 0)
+    {
+      ok = false;
+      break;
+    }
+#else
+    ssize_t got = read(fd, l->target + done, (size_t)chunk);
+    if (got <= 0)
+    {
+      ok = false;
+      break;
+    }
+#endif
+    done += (uint64_t)got;
+    LOADER_STORE(&l->done, done);
+  }
+
+#ifdef _WIN32
+  CloseHandle(hFile);
+#else
+  close(fd);
+#endif
+  return ok;
+}
+
+static void run_loader(FileLoader* l)
+{
+  bool ok = read_chunks(l);
+
+  int state = LOADER_DONE;
+  if (LOADER_LOAD_INT(&l->cancelRequested))
+    state = LOADER_CANCELLED;
+  else if (!ok)
+    state = LOADER_FAILED;
+  LOADER_STORE_INT(&l->state, state);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI LoaderThread(LPVOID param)
+{
+  run_loader((FileLoader*)param);
+  return 0;
+}
+#else
+static void* LoaderThread(void* param)
+{
+  run_loader((FileLoader*)param);
+  return nullptr;
+}
+#endif
+
+static void start_thread(FileLoader* l)
+{
+  l->done = 0;
+  l->cancelRequested = 0;
+  l->state = LOADER_RUNNING;
+
+#ifdef _WIN32
+  l->thread = CreateThread(nullptr, 0, LoaderThread, l, 0, nullptr);
+  l->threadStarted = l->thread != nullptr;
+#else
+  l->threadStarted = pthread_create(&l->thread, nullptr, LoaderThread, l) == 0;
+#endif
+
+  if (!l->threadStarted)
+    run_loader(l);
+}
+
+void fl_init(FileLoader* l)
+{
+  l->path[0] = '\0';
+  l->target = nullptr;
+  l->total = 0;
+  l->done = 0;
+  l->state = LOADER_IDLE;
+  l->cancelRequested = 0;
+  l->threadStarted = false;
+#ifdef _WIN32
+  l->thread = nullptr;
+#endif
+}
+
+bool fl_start_read(FileLoader* l, const char* path, uint8_t* target, uint64_t size)
+{
+  fl_wait(l);
+  fl_init(l);
+  stringCopy(l->path, path, MAX_PATH_LEN);
+  l->target = target;
+  l->total = size;
+  start_thread(l);
+  return true;
+}
+
+void fl_cancel(FileLoader* l)
+{
+  LOADER_STORE_INT(&l->cancelRequested, 1);
+}
+
+void fl_wait(FileLoader* l)
+{
+  if (!l->threadStarted)
+    return;
+
+#ifdef _WIN32
+  WaitForSingleObject((HANDLE)l->thread, INFINITE);
+  CloseHandle((HANDLE)l->thread);
+  l->thread = nullptr;
+#else
+  pthread_join(l->thread, nullptr);
+#endif
+  l->threadStarted = false;
+}
+
+int fl_state(const FileLoader* l)
+{
+  return LOADER_LOAD_INT(&l->state);
+}
+
+uint64_t fl_done(const FileLoader* l)
+{
+  return LOADER_LOAD(&l->done);
+}
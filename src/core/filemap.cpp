@@ -0,0 +1,429 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <signal.h>
+#include <setjmp.h>
+#include <pthread.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
+#include "filemap.h"
+
+void fm_init(FileMapping* m)
+{
+  m->data = nullptr;
+  m->size = 0;
+  m->device = false;
+#ifdef _WIN32
+  m->file = INVALID_HANDLE_VALUE;
+  m->section = nullptr;
+#else
+  m->fd = -1;
+#endif
+}
+
+bool fm_is_open(const FileMapping* m)
+{
+#ifdef _WIN32
+  return m->file != INVALID_HANDLE_VALUE;
+#else
+  return m->fd >= 0;
+#endif
+}
+
+bool fm_open(FileMapping* m, const char* path)
+{
+  fm_close(m);
+
+#ifdef _WIN32
+  HANDLE hFile = CreateFileA(path,
+                             GENERIC_READ,
+                             FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                             NULL,
+                             OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL,
+                             NULL);
+  if (hFile == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER liSize;
+  if (!GetFileSizeEx(hFile, &liSize) || liSize.QuadPart < 0)
+  {
+    CloseHandle(hFile);
+    return false;
+  }
+
+  if ((unsigned long long)liSize.QuadPart > (unsigned long long)(SIZE_MAX / 2))
+  {
+    CloseHandle(hFile);
+    return false;
+  }
+
+  m->file = hFile;
+  m->size = (uint64_t)liSize.QuadPart;
+
+  if (m->size == 0)
+    return true;
+
+  HANDLE hSection = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (!hSection)
+  {
+    fm_close(m);
+    return false;
+  }
+
+  void* view = MapViewOfFile(hSection, FILE_MAP_READ, 0, 0, 0);
+  if (!view)
+  {
+    CloseHandle(hSection);
+    fm_close(m);
+    return false;
+  }
+
+  m->section = hSection;
+  m->data = (uint8_t*)view;
+  return true;
+#else
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < 0)
+  {
+    close(fd);
+    return false;
+  }
+
+  uint64_t size = (uint64_t)st.st_size;
+  bool device = false;
+#if defined(__linux__)
+  if (S_ISBLK(st.st_mode))
+  {
+    unsigned long long bytes = 0;
+    if (ioctl(fd, BLKGETSIZE64, &bytes) != 0)
+    {
+      close(fd);
+      return false;
+    }
+    size = bytes;
+    device = true;
+  }
+#endif
+
+  if ((!device && !S_ISREG(st.st_mode)) || size > (unsigned long long)(SIZE_MAX / 2))
+  {
+    close(fd);
+    return false;
+  }
+
+  m->fd = fd;
+  m->size = size;
+  m->device = device;
+
+  if (m->size == 0)
+    return true;
+
+  void* view = mmap(nullptr, (size_t)m->size, PROT_READ, MAP_SHARED, fd, 0);
+  if (view == MAP_FAILED)
+  {
+    fm_close(m);
+    return false;
+  }
+
+  m->data = (uint8_t*)view;
+  return true;
+#endif
+}
+
+void fm_close(FileMapping* m)
+{
+#ifdef _WIN32
+  if (m->data)
+    UnmapViewOfFile(m->data);
+  if (m->section)
+    CloseHandle(m->section);
+  if (m->file != INVALID_HANDLE_VALUE)
+    CloseHandle(m->file);
+#else
+  if (m->data)
+    munmap(m->data, (size_t)m->size);
+  if (m->fd >= 0)
+    close(m->fd);
+#endif
+  fm_init(m);
+}
+
+bool fm_same_file(const FileMapping* m, const char* path)
+{
+  if (!fm_is_open(m) || !path)
+    return false;
+
+#ifdef _WIN32
+  HANDLE hOther = CreateFileA(path,
+                              0,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              NULL,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL,
+                              NULL);
+  if (hOther == INVALID_HANDLE_VALUE)
+    return false;
+
+  BY_HANDLE_FILE_INFORMATION a, b;
+  bool same = GetFileInformationByHandle((HANDLE)m->file, &a) &&
+              GetFileInformationByHandle(hOther, &b) &&
+              a.dwVolumeSerialNumber == b.dwVolumeSerialNumber &&
+              a.nFileIndexHigh == b.nFileIndexHigh &&
+              a.nFileIndexLow == b.nFileIndexLow;
+  CloseHandle(hOther);
+  return same;
+#else
+  struct stat a, b;
+  if (fstat(m->fd, &a) != 0 || stat(path, &b) != 0)
+    return false;
+  return a.st_dev == b.st_dev && a.st_ino == b.st_ino;
+#endif
+}
+
+bool fm_current_size(const FileMapping* m, uint64_t* outSize)
+{
+  if (!fm_is_open(m))
+    return false;
+
+#ifdef _WIN32
+  LARGE_INTEGER liSize;
+  if (!GetFileSizeEx((HANDLE)m->file, &liSize) || liSize.QuadPart < 0)
+    return false;
+  *outSize = (uint64_t)liSize.QuadPart;
+#else
+  if (m->device)
+  {
+    *outSize = m->size;
+    return true;
+  }
+
+  struct stat st;
+  if (fstat(m->fd, &st) != 0 || st.st_size < 0)
+    return false;
+  *outSize = (uint64_t)st.st_size;
+#endif
+  return true;
+}
+
+bool fm_data_extents(const FileMapping* m, Vector<ByteExtent>& out)
+{
+  out.clear();
+  if (!fm_is_open(m) || m->device || m->size == 0)
+    return false;
+
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+  off_t pos = 0;
+  off_t end = (off_t)m->size;
+  while (pos < end)
+  {
+    off_t dataStart = lseek(m->fd, pos, SEEK_DATA);
+    if (dataStart < 0)
+      break;
+
+    off_t holeStart = lseek(m->fd, dataStart, SEEK_HOLE);
+    if (holeStart < 0 || holeStart > end)
+      holeStart = end;
+
+    ByteExtent extent;
+    extent.offset = (uint64_t)dataStart;
+    extent.length = (uint64_t)(holeStart - dataStart);
+    out.push_back(extent);
+    pos = holeStart;
+  }
+
+  if (pos == 0 && out.empty() && lseek(m->fd, 0, SEEK_HOLE) < 0)
+    return false;
+
+  return !(out.size() == 1 && out[0].offset == 0 && out[0].length == m->size);
+#else
+  return false;
+#endif
+}
+
+#ifndef _WIN32
+// Touching a mapped page past the file's current end raises SIGBUS. Reads that
+// go through fm_read arm a per-thread jump target; any other SIGBUS is passed on.
+static __thread sigjmp_buf* t_faultJump = nullptr;
+static struct sigaction g_previousBus;
+static pthread_once_t g_busOnce = PTHREAD_ONCE_INIT;
+
+static void on_sigbus(int sig, siginfo_t* info, void* context)
+{
+  if (t_faultJump)
+    siglongjmp(*t_faultJump, 1);
+
+  if ((g_previousBus.sa_flags & SA_SIGINFO) && g_previousBus.sa_sigaction)
+  {
+    g_previousBus.sa_sigaction(sig, info, context);
+    return;
+  }
+  if (g_previousBus.sa_handler != SIG_DFL && g_previousBus.sa_handler != SIG_IGN)
+  {
+    g_previousBus.sa_handler(sig);
+    return;
+  }
+  signal(sig, SIG_DFL);
+  raise(sig);
+}
+
+static void install_sigbus()
+{
+  struct sigaction sa;
+  memSet(&sa, 0, sizeof(sa));
+  sa.sa_sigaction = on_sigbus;
+  // NODEFER keeps SIGBUS unblocked after the jump, so the jump need not save the mask.
+  sa.sa_flags = SA_SIGINFO | SA_NODEFER;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGBUS, &sa, &g_previousBus);
+}
+#endif
+
+uint64_t fm_read(const FileMapping* m, uint64_t offset, uint8_t* out, uint64_t length)
+{
+  uint64_t count = offset < m->size ? m->size - offset : 0;
+  if (count > length)
+    count = length;
+
+  uint64_t done = 0;
+  if (count > 0 && m->data)
+  {
+#ifdef _WIN32
+    // A file with a mapped view cannot be truncated on Windows.
+    memCopy(out, m->data + offset, (size_t)count);
+    done = count;
+#else
+    pthread_once(&g_busOnce, install_sigbus);
+
+    sigjmp_buf jump;
+    volatile uint64_t copied = 0;
+    if (sigsetjmp(jump, 0) == 0)
+    {
+      t_faultJump = &jump;
+      memCopy(out, m->data + offset, (size_t)count);
+      copied = count;
+    }
+    t_faultJump = nullptr;
+    done = copied;
+
+    // The file shrank or failed under the mapping; take whatever is still there.
+    while (done < count)
+    {
+      ssize_t n = pread(m->fd, out + done, (size_t)(count - done), (off_t)(offset + done));
+      if (n <= 0)
+        break;
+      done += (uint64_t)n;
+    }
+#endif
+  }
+
+  if (done < length)
+    memSet(out + done, 0, (size_t)(length - done));
+  return done;
+}
+
+bool fm_remap(FileMapping* m, uint64_t newSize)
+{
+  if (!fm_is_open(m) || newSize > (unsigned long long)(SIZE_MAX / 2))
+    return false;
+
+#ifdef _WIN32
+  HANDLE hSection = nullptr;
+  void* view = nullptr;
+  if (newSize > 0)
+  {
+    hSection = CreateFileMappingA((HANDLE)m->file, NULL, PAGE_READONLY,
+                                  (DWORD)(newSize >> 32), (DWORD)newSize, NULL);
+    if (!hSection)
+      return false;
+
+    view = MapViewOfFile(hSection, FILE_MAP_READ, 0, 0, (SIZE_T)newSize);
+    if (!view)
+    {
+      CloseHandle(hSection);
+      return false;
+    }
+  }
+
+  if (m->data)
+    UnmapViewOfFile(m->data);
+  if (m->section)
+    CloseHandle(m->section);
+  m->section = hSection;
+#else
+  void* view = nullptr;
+  if (newSize > 0)
+  {
+    view = mmap(nullptr, (size_t)newSize, PROT_READ, MAP_SHARED, m->fd, 0);
+    if (view == MAP_FAILED)
+      return false;
+  }
+
+  if (m->data)
+    munmap(m->data, (size_t)m->size);
+#endif
+
+  m->data = (uint8_t*)view;
+  m->size = newSize;
+  return true;
+}
+
+void fm_advise(FileMapping* m, uint64_t offset, uint64_t length, FileMapAdvice advice)
+{
+  if (!m->data || offset >= m->size || length == 0)
+    return;
+
+  if (length > m->size - offset)
+    length = m->size - offset;
+
+#ifdef _WIN32
+  // Unlocking pages that were never locked drops them from the working set.
+  if (advice == FM_ADVICE_DONTNEED)
+    VirtualUnlock(m->data + offset, (SIZE_T)length);
+#else
+  static long pageSize = 0;
+  if (pageSize <= 0)
+    pageSize = sysconf(_SC_PAGESIZE);
+  if (pageSize <= 0)
+    pageSize = 4096;
+
+  uint64_t alignedStart = offset & ~(uint64_t)(pageSize - 1);
+  length += offset - alignedStart;
+
+  int flag = MADV_NORMAL;
+  switch (advice)
+  {
+  case FM_ADVICE_SEQUENTIAL:
+    flag = MADV_SEQUENTIAL;
+    break;
+  case FM_ADVICE_RANDOM:
+    flag = MADV_RANDOM;
+    break;
+  case FM_ADVICE_WILLNEED:
+    flag = MADV_WILLNEED;
+    break;
+  case FM_ADVICE_DONTNEED:
+    flag = MADV_DONTNEED;
+    break;
+  default:
+    break;
+  }
+
+  madvise(m->data + alignedStart, (size_t)length, flag);
+#endif
+}
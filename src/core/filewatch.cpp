@@ -0,0 +1,182 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#endif
+
+#include "filewatch.h"
+
+static bool read_stamp(const char* path, uint64_t* size, uint64_t* time, uint64_t* id)
+{
+#ifdef _WIN32
+  WIN32_FILE_ATTRIBUTE_DATA info;
+  if (!GetFileAttributesExA(path, GetFileExInfoStandard, &info))
+    return false;
+  *size = ((uint64_t)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+  *time = ((uint64_t)info.ftLastWriteTime.dwHighDateTime << 32) | info.ftLastWriteTime.dwLowDateTime;
+  *id = ((uint64_t)info.ftCreationTime.dwHighDateTime << 32) | info.ftCreationTime.dwLowDateTime;
+#else
+  struct stat st;
+  if (stat(path, &st) != 0)
+    return false;
+  *size = (uint64_t)st.st_size;
+#if defined(__APPLE__)
+  *time = (uint64_t)st.st_mtimespec.tv_sec * 1000000000ull + (uint64_t)st.st_mtimespec.tv_nsec;
+#else
+  *time = (uint64_t)st.st_mtim.tv_sec * 1000000000ull + (uint64_t)st.st_mtim.tv_nsec;
+#endif
+  *id = (uint64_t)st.st_ino;
+#endif
+  return true;
+}
+
+static bool update_stamp(FileWatch* w)
+{
+  uint64_t size = 0, time = 0, id = 0;
+  read_stamp(w->path, &size, &time, &id);
+
+  bool changed = size != w->stampSize || time != w->stampTime || id != w->stampId;
+  w->stampSize = size;
+  w->stampTime = time;
+  w->stampId = id;
+  return changed;
+}
+
+void fw_init(FileWatch* w)
+{
+  w->path[0] = '\0';
+  w->active = false;
+#if defined(__linux__)
+  w->fd = -1;
+  w->wd = -1;
+  w->name = w->path;
+#endif
+  w->stampSize = 0;
+  w->stampTime = 0;
+  w->stampId = 0;
+}
+
+bool fw_start(FileWatch* w, const char* path)
+{
+  fw_stop(w);
+  if (!path || !path[0])
+    return false;
+
+  stringCopy(w->path, path, MAX_PATH_LEN);
+  update_stamp(w);
+
+#if defined(__linux__)
+  char dir[MAX_PATH_LEN];
+  strCopy(dir, w->path);
+
+  char* slash = nullptr;
+  for (char* p = dir; *p; p++)
+  {
+    if (*p == '/')
+      slash = p;
+  }
+
+  if (slash)
+  {
+    w->name = w->path + (slash - dir) + 1;
+    if (slash == dir)
+      slash[1] = '\0';
+    else
+      *slash = '\0';
+  }
+  else
+  {
+    w->name = w->path;
+    strCopy(dir, ".");
+  }
+
+  w->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (w->fd >= 0)
+  {
+    w->wd = inotify_add_watch(w->fd, dir, IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ATTRIB);
+    if (w->wd < 0)
+    {
+      close(w->fd);
+      w->fd = -1;
+    }
+  }
+#endif
+
+  w->active = true;
+  return true;
+}
+
+void fw_stop(FileWatch* w)
+{
+#if defined(__linux__)
+  if (w->fd >= 0)
+    close(w->fd);
+#endif
+  fw_init(w);
+}
+
+bool fw_is_watching(const FileWatch* w, const char* path)
+{
+  return w->active && path && strEquals(w->path, path);
+}
+
+bool fw_poll(FileWatch* w)
+{
+  if (!w->active)
+    return false;
+
+#if defined(__linux__)
+  if (w->fd >= 0)
+  {
+    bool hit = false;
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    for (;;)
+    {
+      ssize_t n = read(w->fd, buffer, sizeof(buffer));
+      if (n <= 0)
+        break;
+
+      for (char* p = buffer; p < buffer + n;)
+      {
+        const struct inotify_event* e = (const struct inotify_event*)p;
+        if (e->len > 0 && strEquals(e->name, w->name))
+          hit = true;
+        p += sizeof(struct inotify_event) + e->len;
+      }
+    }
+
+    if (hit)
+      update_stamp(w);
+    return hit;
+  }
+#endif
+
+  return update_stamp(w);
+}
+
+void fw_sync(FileWatch* w)
+{
+  if (!w->active)
+    return;
+
+#if defined(__linux__)
+  if (w->fd >= 0)
+  {
+    char buffer[4096];
+    while (read(w->fd, buffer, sizeof(buffer)) > 0)
+    {
+    }
+  }
+#endif
+
+  update_stamp(w);
+}
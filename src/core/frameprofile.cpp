@@ -0,0 +1,236 @@
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+#include "frameprofile.h"
+#include "scanreader.h"
+
+// Recording calls are no-ops while the profiler is disabled.
+
+// Phase timings are kept apart from the frame total; PHASE_COUNT selects it.
+static uint32_t sample_value(const FrameSample& s, int phase)
+{
+  return phase >= 0 && phase < PHASE_COUNT ? s.phaseUs[phase] : s.totalUs;
+}
+
+static void sort_values(uint32_t* values, int count)
+{
+  for (int gap = count / 2; gap > 0; gap /= 2)
+  {
+    for (int i = gap; i < count; i++)
+    {
+      uint32_t value = values[i];
+      int j = i;
+      while (j >= gap && values[j - gap] > value)
+      {
+        values[j] = values[j - gap];
+        j -= gap;
+      }
+      values[j] = value;
+    }
+  }
+}
+
+static uint32_t percentile_of(uint32_t* values, int count, int percentile)
+{
+  if (count == 0)
+    return 0;
+  sort_values(values, count);
+  int rank = (count * percentile + 99) / 100;
+  if (rank < 1)
+    rank = 1;
+  return values[rank - 1];
+}
+
+static void append_ms(char* out, uint32_t microseconds)
+{
+  char number[24];
+  itoaDec((long long)(microseconds / 1000), number, 24);
+  strCat(out, number);
+  strCat(out, ".");
+  uint32_t fraction = (microseconds % 1000) / 10;
+  if (fraction < 10)
+    strCat(out, "0");
+  itoaDec((long long)fraction, number, 24);
+  strCat(out, number);
+}
+
+void fp_init(FrameProfiler* p)
+{
+  memSet(p, 0, sizeof(*p));
+}
+
+void fp_begin_frame(FrameProfiler* p)
+{
+  if (!p->enabled)
+    return;
+  memSet(&p->current, 0, sizeof(p->current));
+  p->frameStart = sr_now_us();
+}
+
+void fp_begin_phase(FrameProfiler* p, int phase)
+{
+  if (!p->enabled)
+    return;
+  p->phaseStart[phase] = sr_now_us();
+}
+
+void fp_end_phase(FrameProfiler* p, int phase)
+{
+  if (!p->enabled)
+    return;
+  fp_add(p, phase, sr_now_us() - p->phaseStart[phase]);
+}
+
+void fp_add(FrameProfiler* p, int phase, uint64_t microseconds)
+{
+  if (!p->enabled)
+    return;
+  p->current.phaseUs[phase] += (uint32_t)microseconds;
+}
+
+void fp_end_frame(FrameProfiler* p, uint32_t drawCalls)
+{
+  if (!p->enabled)
+    return;
+  p->current.totalUs = (uint32_t)(sr_now_us() - p->frameStart);
+  p->current.drawCalls = drawCalls;
+  p->samples[p->next] = p->current;
+  p->next = (p->next + 1) % PROFILE_FRAMES;
+  if (p->count < PROFILE_FRAMES)
+    p->count++;
+}
+
+uint32_t fp_percentile(const FrameProfiler* p, int phase, int percentile)
+{
+  uint32_t values[PROFILE_FRAMES];
+  for (int i = 0; i < p->count; i++)
+    values[i] = sample_value(p->samples[i], phase);
+  return percentile_of(values, p->count, percentile);
+}
+
+uint32_t fp_draw_calls(const FrameProfiler* p, int percentile)
+{
+  uint32_t values[PROFILE_FRAMES];
+  for (int i = 0; i < p->count; i++)
+    values[i] = p->samples[i].drawCalls;
+  return percentile_of(values, p->count, percentile);
+}
+
+const char* fp_phase_name(int phase)
+{
+  switch (phase)
+  {
+  case PHASE_FORMAT:
+    return "format";
+  case PHASE_HEX:
+    return "hex";
+  case PHASE_PANELS:
+    return "panels";
+  case PHASE_MENU:
+    return "menu";
+  case PHASE_BLIT:
+    return "blit";
+  default:
+    return "frame";
+  }
+}
+
+static void format_timing(const FrameProfiler* p, int phase, char* out)
+{
+  strCopy(out, fp_phase_name(phase));
+  while (strLen(out) < 7)
+    strCat(out, " ");
+  strCat(out, "p50 ");
+  append_ms(out, fp_percentile(p, phase, 50));
+  strCat(out, "  p99 ");
+  append_ms(out, fp_percentile(p, phase, 99));
+  strCat(out, " ms");
+}
+
+int fp_format_hud(const FrameProfiler* p, char lines[][PROFILE_HUD_TEXT], int maxLines)
+{
+  int count = 0;
+  if (count < maxLines)
+    format_timing(p, PHASE_COUNT, lines[count++]);
+  for (int phase = 0; phase < PHASE_COUNT && count < maxLines; phase++)
+    format_timing(p, phase, lines[count++]);
+
+  if (count < maxLines)
+  {
+    char number[24];
+    strCopy(lines[count], "draws  p50 ");
+    itoaDec((long long)fp_draw_calls(p, 50), number, 24);
+    strCat(lines[count], number);
+    strCat(lines[count], "  p99 ");
+    itoaDec((long long)fp_draw_calls(p, 99), number, 24);
+    strCat(lines[count], number);
+    count++;
+  }
+  return count;
+}
+
+// One CSV row per recorded frame, oldest first, in microseconds.
+bool fp_dump(const FrameProfiler* p, const char* path)
+{
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+#else
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    return false;
+#endif
+
+  bool ok = true;
+  char line[256];
+  char number[24];
+  int first = p->count < PROFILE_FRAMES ? 0 : p->next;
+
+  for (int row = -1; row < p->count && ok; row++)
+  {
+    if (row < 0)
+    {
+      strCopy(line, "index");
+      for (int phase = 0; phase <= PHASE_COUNT; phase++)
+      {
+        strCat(line, ",");
+        strCat(line, fp_phase_name(phase));
+      }
+      strCat(line, ",draws\n");
+    }
+    else
+    {
+      const FrameSample& s = p->samples[(first + row) % PROFILE_FRAMES];
+      itoaDec((long long)row, line, 24);
+      for (int phase = 0; phase <= PHASE_COUNT; phase++)
+      {
+        strCat(line, ",");
+        itoaDec((long long)sample_value(s, phase), number, 24);
+        strCat(line, number);
+      }
+      strCat(line, ",");
+      itoaDec((long long)s.drawCalls, number, 24);
+      strCat(line, number);
+      strCat(line, "\n");
+    }
+
+#ifdef _WIN32
+    DWORD written = 0;
+    ok = WriteFile(file, line, (DWORD)strLen(line), &written, nullptr) && written == strLen(line);
+#else
+    ok = write(fd, line, strLen(line)) == (ssize_t)strLen(line);
+#endif
+  }
+
+#ifdef _WIN32
+  CloseHandle(file);
+#else
+  close(fd);
+#endif
+  return ok;
+}
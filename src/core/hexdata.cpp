@@ -12,7 +12,9 @@
 
 #include "hexdata.h"
 
-static bool read_file_all(const char *path, ByteBuffer *outBuffer)
+#define LOAD_FIRST_SCREEN (64ull * 1024)
+
+static bool query_file_size(const char *path, uint64_t *outSize)
 {
 #ifdef _WIN32
     HANDLE hFile = CreateFileA(path,
@@ -26,120 +28,314 @@ static bool read_file_all(const char *path, ByteBuffer *outBuffer)
         return false;
 
     LARGE_INTEGER liSize;
-    if (!GetFileSizeEx(hFile, &liSize))
-    {
-        CloseHandle(hFile);
+    bool ok = GetFileSizeEx(hFile, &liSize) && liSize.QuadPart >= 0;
+    CloseHandle(hFile);
+    if (!ok)
         return false;
-    }
 
-    if (liSize.QuadPart < 0 || liSize.QuadPart > 0x7FFFFFFFLL)
-    {
-        CloseHandle(hFile);
+    *outSize = (uint64_t)liSize.QuadPart;
+    return true;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
         return false;
-    }
 
-    size_t size = (size_t)liSize.QuadPart;
-    if (!bb_resize(outBuffer, size))
-    {
-        CloseHandle(hFile);
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0 && st.st_size >= 0;
+    close(fd);
+    if (!ok)
         return false;
+
+    *outSize = (uint64_t)st.st_size;
+    return true;
+#endif
+}
+
+#define SAVE_DETACH_LIMIT (64ull * 1024 * 1024)
+
+#ifdef _WIN32
+typedef HANDLE SaveHandle;
+#define SAVE_INVALID_HANDLE INVALID_HANDLE_VALUE
+#else
+typedef int SaveHandle;
+#define SAVE_INVALID_HANDLE (-1)
+#endif
+
+static SaveHandle open_for_save(const char *path, bool create)
+{
+#ifdef _WIN32
+    return CreateFileA(path,
+                       GENERIC_WRITE,
+                       FILE_SHARE_READ | FILE_SHARE_WRITE,
+                       NULL,
+                       create ? OPEN_ALWAYS : OPEN_EXISTING,
+                       FILE_ATTRIBUTE_NORMAL,
+                       NULL);
+#else
+    return open(path, create ? (O_WRONLY | O_CREAT) : O_WRONLY, 0644);
+#endif
+}
+
+static void close_save_handle(SaveHandle h)
+{
+#ifdef _WIN32
+    CloseHandle(h);
+#else
+    close(h);
+#endif
+}
+
+static bool set_save_size(SaveHandle h, uint64_t size)
+{
+#ifdef _WIN32
+    LARGE_INTEGER li;
+    li.QuadPart = (LONGLONG)size;
+    return SetFilePointerEx(h, li, NULL, FILE_BEGIN) && SetEndOfFile(h);
+#else
+    return ftruncate(h, (off_t)size) == 0;
+#endif
+}
+
+static bool sync_save_handle(SaveHandle h)
+{
+#ifdef _WIN32
+    return FlushFileBuffers(h) != 0;
+#else
+    return fsync(h) == 0;
+#endif
+}
+
+static bool write_at(SaveHandle h, uint64_t pos, const uint8_t *data, uint64_t length)
+{
+    while (length > 0)
+    {
+        uint64_t chunk = length > 0x40000000 ? 0x40000000 : length;
+
+#ifdef _WIN32
+        OVERLAPPED ov;
+        memSet(&ov, 0, sizeof(ov));
+        ov.Offset = (DWORD)pos;
+        ov.OffsetHigh = (DWORD)(pos >> 32);
+
+        DWORD w = 0;
+        if (!WriteFile(h, data, (DWORD)chunk, &w, &ov) || w == 0)
+            return false;
+#else
+        ssize_t w = pwrite(h, data, (size_t)chunk, (off_t)pos);
+        if (w <= 0)
+            return false;
+#endif
+        pos += (uint64_t)w;
+        data += w;
+        length -= (uint64_t)w;
     }
+    return true;
+}
 
-    DWORD readBytes = 0;
-    if (!ReadFile(hFile, outBuffer->data, (DWORD)size, &readBytes, NULL) ||
-        readBytes != size)
+#if defined(__linux__)
+static bool clone_range(int sourceFd, uint64_t sourcePos, int fd, uint64_t pos, uint64_t length)
+{
+    loff_t in = (loff_t)sourcePos;
+    loff_t out = (loff_t)pos;
+    while (length > 0)
     {
-        CloseHandle(hFile);
-        return false;
+        ssize_t n = copy_file_range(sourceFd, &in, fd, &out, (size_t)(length > 0x40000000 ? 0x40000000 : length), 0);
+        if (n <= 0)
+            return false;
+        length -= (uint64_t)n;
     }
+    return true;
+}
+#endif
 
-    CloseHandle(hFile);
+static bool write_piece_range(SaveHandle h, const PieceTable &pieces, uint64_t pos, uint64_t length, const FileMapping *source, bool sparse)
+{
+    static uint8_t fillBuffer[65536];
+    uint64_t end = pos + length;
+
+    while (pos < end)
+    {
+        Piece piece;
+        uint64_t offset;
+        if (!pieces.locate(pos, &piece, &offset))
+            return false;
+
+        uint64_t span = piece.length - offset;
+        if (span > end - pos)
+            span = end - pos;
+
+        if (piece.source == PIECE_ZERO && sparse)
+        {
+            pos += span;
+            continue;
+        }
+
+        const uint8_t* direct = pieces.sourceData(piece);
+        if (piece.source == PIECE_FILL || !direct)
+        {
+            for (uint64_t done = 0; done < span;)
+            {
+                uint64_t chunk = span - done;
+                if (chunk > sizeof(fillBuffer))
+                    chunk = sizeof(fillBuffer);
+                pieces.copyOut(piece, offset + done, fillBuffer, chunk);
+                if (!write_at(h, pos + done, fillBuffer, chunk))
+                    return false;
+                done += chunk;
+            }
+        }
+        else
+        {
+            bool cloned = false;
+#if defined(__linux__)
+            if (piece.source == PIECE_ORIGINAL && source && fm_is_open(source))
+                cloned = clone_range(source->fd, piece.start + offset, h, pos, span);
+#else
+            (void)source;
+#endif
+            if (!cloned && !write_at(h, pos, direct + offset, span))
+                return false;
+        }
+
+        pos += span;
+    }
     return true;
+}
+
+static bool write_all_pieces(SaveHandle h, const PieceTable &pieces, const FileMapping *source)
+{
+    return set_save_size(h, 0) &&
+           set_save_size(h, pieces.length()) &&
+           write_piece_range(h, pieces, 0, pieces.length(), source, true) &&
+           sync_save_handle(h);
+}
+
+static bool write_pieces(const char *path, const PieceTable &pieces, const FileMapping *source)
+{
+    SaveHandle h = open_for_save(path, true);
+    if (h == SAVE_INVALID_HANDLE)
+        return false;
+
+    bool ok = write_all_pieces(h, pieces, source);
+    close_save_handle(h);
+    return ok;
+}
+
+static bool write_extents(const char *path, const PieceTable &pieces, const Vector<ByteExtent> &extents)
+{
+    SaveHandle h = open_for_save(path, false);
+    if (h == SAVE_INVALID_HANDLE)
+        return false;
+
+    bool ok = true;
+    for (size_t i = 0; ok && i < extents.size(); i++)
+        ok = write_piece_range(h, pieces, extents[i].offset, extents[i].length, nullptr, false);
+
+    ok = ok && sync_save_handle(h);
+    close_save_handle(h);
+    return ok;
+}
+
+// Creates a temp file next to path that did not exist before, so a stale
+// temp or a planted symlink is never written through. On POSIX it takes the
+// owner and mode of path, or the default mode for a new file, before any
+// contents land in it.
+static SaveHandle create_temp_for_save(const char *path, char *tempPath)
+{
+#ifdef _WIN32
+    for (int attempt = 0; attempt < 16; attempt++)
+    {
+        stringCopy(tempPath, path, MAX_PATH_LEN - 12);
+        strCat(tempPath, ".hvtmp");
+        char suffix[4];
+        itoaDec(attempt, suffix, sizeof(suffix));
+        strCat(tempPath, suffix);
+
+        HANDLE h = CreateFileA(tempPath, GENERIC_WRITE, 0, NULL, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (h != INVALID_HANDLE_VALUE || GetLastError() != ERROR_FILE_EXISTS)
+            return h;
+    }
+    return INVALID_HANDLE_VALUE;
 #else
-    int fd = open(path, O_RDONLY);
+    stringCopy(tempPath, path, MAX_PATH_LEN - 12);
+    strCat(tempPath, ".hvXXXXXX");
+    int fd = mkstemp(tempPath);
     if (fd < 0)
-        return false;
+        return SAVE_INVALID_HANDLE;
 
     struct stat st;
-    if (fstat(fd, &st) != 0)
+    mode_t mode;
+    if (stat(path, &st) == 0)
     {
-        close(fd);
-        return false;
+        // Ownership first: chown clears set-id bits, so the mode goes on after.
+        if (fchown(fd, st.st_uid, st.st_gid) != 0)
+            fchown(fd, (uid_t)-1, st.st_gid);
+        mode = st.st_mode & 07777;
     }
-
-    if (st.st_size < 0)
+    else
     {
-        close(fd);
-        return false;
+        mode_t mask = umask(0);
+        umask(mask);
+        mode = 0666 & ~mask;
     }
 
-    size_t size = (size_t)st.st_size;
-    if (!bb_resize(outBuffer, size))
+    if (fchmod(fd, mode) != 0)
     {
         close(fd);
-        return false;
+        unlink(tempPath);
+        return SAVE_INVALID_HANDLE;
     }
+    return fd;
+#endif
+}
 
-    size_t totalRead = 0;
-    while (totalRead < size)
-    {
-        ssize_t r = read(fd, outBuffer->data + totalRead, size - totalRead);
-        if (r <= 0)
-        {
-            close(fd);
-            return false;
-        }
-        totalRead += (size_t)r;
-    }
+#ifndef _WIN32
+// The rename is only durable once the directory entry itself is on disk.
+static void sync_parent_dir(const char *path)
+{
+    char dir[MAX_PATH_LEN];
+    stringCopy(dir, path, MAX_PATH_LEN);
+    char *slash = strrchr(dir, '/');
+    if (!slash)
+        stringCopy(dir, ".", MAX_PATH_LEN);
+    else if (slash == dir)
+        dir[1] = '\0';
+    else
+        *slash = '\0';
 
+    int fd = open(dir, O_RDONLY | O_DIRECTORY);
+    if (fd < 0)
+        return;
+    fsync(fd);
     close(fd);
-    return true;
-#endif
 }
+#endif
 
-static bool write_file_all(const char *path, const uint8_t *data, size_t size)
+static bool replace_file_with_pieces(const char *path, const PieceTable &pieces, const FileMapping *source)
 {
-#ifdef _WIN32
-    HANDLE hFile = CreateFileA(path,
-                               GENERIC_WRITE,
-                               0,
-                               NULL,
-                               CREATE_ALWAYS,
-                               FILE_ATTRIBUTE_NORMAL,
-                               NULL);
-    if (hFile == INVALID_HANDLE_VALUE)
+    char tempPath[MAX_PATH_LEN];
+    SaveHandle h = create_temp_for_save(path, tempPath);
+    if (h == SAVE_INVALID_HANDLE)
         return false;
 
-    DWORD written = 0;
-    if (!WriteFile(hFile, data, (DWORD)size, &written, NULL) ||
-        written != size)
+    bool ok = write_all_pieces(h, pieces, source);
+    close_save_handle(h);
+
+#ifdef _WIN32
+    if (!ok || !MoveFileExA(tempPath, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
     {
-        CloseHandle(hFile);
+        DeleteFileA(tempPath);
         return false;
     }
-
-    CloseHandle(hFile);
-    return true;
 #else
-    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
-    if (fd < 0)
-        return false;
-
-    size_t totalWritten = 0;
-    while (totalWritten < size)
+    if (!ok || rename(tempPath, path) != 0)
     {
-        ssize_t w = write(fd, data + totalWritten, size - totalWritten);
-        if (w <= 0)
-        {
-            close(fd);
-            return false;
-        }
-        totalWritten += (size_t)w;
+        unlink(tempPath);
+        return false;
     }
-
-    close(fd);
-    return true;
+    sync_parent_dir(path);
 #endif
+    return true;
 }
 
 static int clamp_int(int v, int lo, int hi)
@@ -151,6 +347,8 @@ static int clamp_int(int v, int lo, int hi)
     return v;
 }
 
+static uint64_t g_NextContentId = 0;
+
 HexData::HexData()
   : currentBytesPerLine(16),
   modified(false),
@@ -161,11 +359,27 @@ HexData::HexData()
   csHandle(0),
   usePlugin(false),
   pluginCount(0),      
-  usePlugins(false)    
+  usePlugins(false),
+  editGeneration(0),
+  contentId(++g_NextContentId),
+  shiftCallback(nullptr),
+  loadReported(true),
+  streamLimit(STREAM_DEFAULT_LIMIT),
+  streamDropped(0),
+  lastViewOffset(0),
+  readAheadStart(0),
+  readAheadEnd(0),
+  disasmLines(nullptr)
 {
+  memSet(editHistory, 0, sizeof(editHistory));
+  scanStats.bytes = 0;
+  scanStats.microseconds = 0;
+  scanStats.backend = SCAN_BACKEND_NONE;
   bb_init(&fileData);
-  la_init(&hexLines);
-  la_init(&disassemblyLines);
+  fm_init(&fileMap);
+  fl_init(&loader);
+  st_init(&stream);
+  st_store_init(&streamStore);
   ss_init(&headerLine);
   pluginPath[0] = '\0';
   pba_init(&pluginAnnotations);
@@ -176,204 +390,859 @@ HexData::HexData()
   }
 }
 
-HexData::~HexData()
+HexData::~HexData()
+{
+    clear();
+    bb_free(&fileData);
+    fm_close(&fileMap);
+    if (disasmLines)
+        sysFree(disasmLines);
+    ss_free(&headerLine);
+    pba_free(&pluginAnnotations);
+}
+
+void HexData::addPlugin(const char* path)
+{
+  if (!path || !path[0] || pluginCount >= MAX_PLUGINS)
+    return;
+
+  for (int i = 0; i < pluginCount; i++)
+  {
+    if (strEquals(pluginPaths[i], path))
+      return;
+  }
+
+  int i = 0;
+  while (path[i] && i < 511)
+  {
+    pluginPaths[pluginCount][i] = path[i];
+    i++;
+  }
+  pluginPaths[pluginCount][i] = '\0';
+
+  pluginCount++;
+  usePlugins = true;
+
+  if (!isEmpty())
+  {
+    convertDataToHex(currentBytesPerLine);
+  }
+}
+
+void HexData::clearAllPlugins()
+{
+  pluginCount = 0;
+  usePlugins = false;
+
+  for (int i = 0; i < MAX_PLUGINS; i++)
+  {
+    pluginPaths[i][0] = '\0';
+  }
+
+  if (!isEmpty())
+  {
+    convertDataToHex(currentBytesPerLine);
+  }
+}
+
+bool HexData::hasPlugins() const
+{
+  return usePlugins && pluginCount > 0;
+}
+
+const char* HexData::getPluginPath(int index) const
+{
+  if (index < 0 || index >= pluginCount)
+    return nullptr;
+  return pluginPaths[index];
+}
+
+
+void HexData::setDisassemblyPlugin(const char* path)
+{
+  if (!path || !path[0])
+    return;
+
+  clearAllPlugins();
+  addPlugin(path);
+
+  int i = 0;
+  while (path[i] && i < 511)
+  {
+    pluginPath[i] = path[i];
+    i++;
+  }
+  pluginPath[i] = '\0';
+  usePlugin = true;
+}
+
+void HexData::clearDisassemblyPlugin()
+{
+  clearAllPlugins();
+
+  usePlugin = false;
+  pluginPath[0] = '\0';
+}
+
+bool HexData::hasDisassemblyPlugin() const
+{
+  return hasPlugins();
+}
+
+void HexData::generateDisassemblyFromPlugin(int /*bytesPerLine*/)
+{
+  clearDisassemblyCache();
+}
+
+void HexData::generateDisassembly(int bytesPerLine)
+{
+    if (usePlugin)
+    {
+        generateDisassemblyFromPlugin(bytesPerLine);
+        return;
+    }
+
+    clearDisassemblyCache();
+}
+
+bool HexData::initializeCapstone()
+{
+    return false;
+}
+
+void HexData::cleanupCapstone()
+{
+}
+
+void HexData::setArchitecture(int /*arch*/, int /*mode*/)
+{
+}
+
+void HexData::disassembleInstruction(size_t /*offset*/,
+                                     int &instructionLength,
+                                     SimpleString &outInstr)
+{
+    ss_clear(&outInstr);
+    instructionLength = 1;
+}
+
+bool HexData::loadFile(const char* filepath)
+{
+  if (st_is_stream_path(filepath))
+    return openStream(filepath);
+
+  FileMapping mapping;
+  fm_init(&mapping);
+
+  if (fm_open(&mapping, filepath))
+  {
+    clear();
+    fileMap = mapping;
+  }
+  else
+  {
+    uint64_t size;
+    if (!query_file_size(filepath, &size) || size > (uint64_t)(SIZE_MAX / 2))
+      return false;
+
+    ByteBuffer buffer;
+    bb_init(&buffer);
+    if (!bb_resize(&buffer, (size_t)size))
+    {
+      bb_free(&buffer);
+      return false;
+    }
+
+    clear();
+    fileData = buffer;
+  }
+
+  Vector<ByteExtent> dataExtents;
+  if (!fm_data_extents(&fileMap, dataExtents) || !pieces.resetExtents(baseData(), baseSize(), dataExtents))
+    pieces.reset(baseData(), baseSize());
+  if (fm_is_open(&fileMap))
+    pieces.setOriginalMapping(&fileMap);
+
+  convertDataToHex(16);
+  modified = false;
+
+  // Mapped files are paged in as they are viewed; only the first screen is hinted.
+  if (fm_is_open(&fileMap))
+  {
+    fm_advise(&fileMap, 0, LOAD_FIRST_SCREEN, FM_ADVICE_WILLNEED);
+    return true;
+  }
+
+  loadReported = false;
+  fl_start_read(&loader, filepath, fileData.data, fileData.size);
+  return true;
+}
+
+float HexData::getLoadProgress() const
+{
+  if (loader.total == 0)
+    return 1.0f;
+  return (float)((double)fl_done(&loader) / (double)loader.total);
+}
+
+uint64_t HexData::getLoadedSize() const
+{
+  if (loader.target && fl_state(&loader) == LOADER_RUNNING)
+    return fl_done(&loader);
+  return getFileSize();
+}
+
+static uint64_t read_stream_store(const void* context, uint64_t offset, uint8_t* out, uint64_t length)
+{
+  return st_store_read((const StreamStore*)context, offset, out, length);
+}
+
+bool HexData::openStream(const char* path)
+{
+  clear();
+  if (!st_open(&stream, path))
+    return false;
+
+  pieces.reset(nullptr, 0);
+  pieces.setOriginalReader(read_stream_store, &streamStore);
+  modified = false;
+  loadReported = false;
+  return true;
+}
+
+bool HexData::pollStream()
+{
+  size_t available = st_available(&stream);
+  if (available == 0)
+    return false;
+
+  uint64_t oldSize = getFileSize();
+  int oldDigits = getOffsetDigits();
+  uint64_t start = streamStore.end;
+  if (!st_store_append(&streamStore, &stream, available))
+    st_cancel(&stream);
+
+  // New bytes extend the last piece; lines already on screen stay valid.
+  Piece piece;
+  piece.source = PIECE_ORIGINAL;
+  piece.start = start;
+  piece.length = streamStore.end - start;
+  piece.patternLength = 0;
+  piece.phase = 0;
+  if (piece.length == 0 || !pieces.replacePieces(getFileSize(), 0, &piece, 1))
+    return false;
+
+  uint64_t drop = st_store_trim(&streamStore, streamLimit);
+  if (drop > 0)
+  {
+    pieces.replacePieces(0, drop, nullptr, 0);
+    streamDropped += drop;
+    editGeneration++;
+    clearDisassemblyCache();
+    shiftOffsets(0, drop, 0);
+  }
+
+  if (oldSize == 0 || getOffsetDigits() != oldDigits)
+  {
+    editGeneration++;
+    convertDataToHex(currentBytesPerLine);
+  }
+  return true;
+}
+
+bool HexData::pollLoad()
+{
+  if (isStream())
+  {
+    if (loadReported || st_state(&stream) == STREAM_RUNNING || st_available(&stream) > 0)
+      return false;
+    loadReported = true;
+    return true;
+  }
+
+  int state = fl_state(&loader);
+  if (state == LOADER_IDLE || state == LOADER_RUNNING || loadReported)
+    return false;
+
+  fl_wait(&loader);
+  loadReported = true;
+
+  if (loader.target && state != LOADER_DONE)
+  {
+    fileData.size = (size_t)fl_done(&loader);
+    pieces.reset(fileData.data, fileData.size);
+    editGeneration++;
+    clearDisassemblyCache();
+  }
+  return true;
+}
+
+void HexData::stopLoading()
+{
+  fl_cancel(&loader);
+  fl_wait(&loader);
+}
+
+ReloadResult HexData::reloadFromDisk(const char* filepath)
+{
+  if (!fm_is_open(&fileMap) || isLoading())
+    return RELOAD_NONE;
+  if (isModified())
+    return detachFromDisk(filepath);
+
+  uint64_t oldSize = getFileSize();
+  ReloadResult result;
+
+  if (!fm_same_file(&fileMap, filepath))
+  {
+    FileMapping mapping;
+    fm_init(&mapping);
+    if (!fm_open(&mapping, filepath))
+      return RELOAD_FAILED;
+
+    fm_close(&fileMap);
+    fileMap = mapping;
+    result = RELOAD_REPLACED;
+  }
+  else
+  {
+    uint64_t newSize;
+    if (!fm_current_size(&fileMap, &newSize))
+      return RELOAD_FAILED;
+
+    if (newSize != fileMap.size && !fm_remap(&fileMap, newSize))
+      return RELOAD_FAILED;
+
+    result = newSize > oldSize ? RELOAD_APPENDED : RELOAD_CHANGED;
+  }
+
+  journal.clear();
+  pieces.reset(fileMap.data, fileMap.size);
+  pieces.setOriginalMapping(&fileMap);
+  editGeneration++;
+  clearDisassemblyCache();
+  modified = false;
+  return result;
+}
+
+ReloadResult HexData::detachFromDisk(const char* filepath)
+{
+  // A replaced file leaves the old inode, and the mapping of it, untouched.
+  if (!fm_is_open(&fileMap) || isLoading() || !fm_same_file(&fileMap, filepath))
+    return RELOAD_NONE;
+
+  uint64_t newSize;
+  if (!fm_current_size(&fileMap, &newSize))
+    return RELOAD_FAILED;
+
+  // Stop mapping pages past the new end; pieces that pointed there read as zeros.
+  if (newSize < fileMap.size)
+  {
+    if (!fm_remap(&fileMap, newSize))
+      return RELOAD_FAILED;
+    pieces.setOriginalMapping(&fileMap);
+  }
+
+  // Copy what the pieces and the undo journal still reference out of the
+  // mapping, so later writes to the file cannot change them.
+  Vector<ByteExtent> all;
+  ByteExtent whole;
+  whole.offset = 0;
+  whole.length = fileMap.size;
+  all.push_back(whole);
+
+  uint64_t cost = pieces.detachCost(all) + journal.detachCost(pieces, all);
+  bool detached = cost <= SAVE_DETACH_LIMIT;
+  if (cost > 0 && detached)
+  {
+    if (!pieces.detachOriginal(all) || !journal.detachOriginal(pieces, all))
+      return RELOAD_FAILED;
+  }
+
+  editGeneration++;
+  clearDisassemblyCache();
+  return detached ? RELOAD_DETACHED : RELOAD_UNDETACHED;
+}
+
+bool HexData::loadBuffer(const uint8_t* data, size_t size)
+{
+  clear();
+
+  if (!bb_resize(&fileData, size))
+    return false;
+
+  memCopy(fileData.data, data, size);
+  pieces.reset(fileData.data, fileData.size);
+
+  convertDataToHex(16);
+  modified = false;
+  return true;
+}
+
+bool HexData::saveFile(const char *filepath)
+{
+    if (isFilling())
+        return false;
+    stopLoading();
+
+    bool sameFile = fm_same_file(&fileMap, filepath);
+    bool saved = false;
+
+    if (sameFile && getFileSize() == fileMap.size)
+        saved = saveInPlace(filepath);
+
+    if (!saved && sameFile && fileMap.device)
+        return false;
+
+    if (!saved)
+    {
+        saved = replace_file_with_pieces(filepath, pieces, &fileMap);
+        if (saved)
+            adoptSavedFile(filepath);
+    }
+
+    if (!saved && sameFile && detachBase())
+        saved = write_pieces(filepath, pieces, nullptr);
+    else if (!saved && !sameFile)
+        saved = write_pieces(filepath, pieces, &fileMap);
+
+    if (!saved)
+        return false;
+
+    setModified(false);
+    return true;
+}
+
+bool HexData::saveInPlace(const char *filepath)
+{
+    Vector<ByteExtent> dirty;
+    pieces.dirtyExtents(dirty);
+    if (dirty.empty())
+        return true;
+
+    if (pieces.detachCost(dirty) + journal.detachCost(pieces, dirty) > SAVE_DETACH_LIMIT)
+        return false;
+
+    if (!pieces.detachOriginal(dirty) || !journal.detachOriginal(pieces, dirty))
+        return false;
+
+    if (!write_extents(filepath, pieces, dirty))
+        return false;
+
+    journal.rebase(pieces);
+    return true;
+}
+
+// After a rename over the path the old mapping is an unlinked inode. Map the
+// new file instead so later saves can write in place and the old blocks are
+// released; undo records that still read the old file are copied out first.
+void HexData::adoptSavedFile(const char *filepath)
+{
+    // Streamed bytes live in the chunk store, which this does not retire.
+    if (isStream() || streamStore.end > 0)
+        return;
+
+    FileMapping mapping;
+    fm_init(&mapping);
+    if (!fm_open(&mapping, filepath))
+        return;
+
+    if (mapping.size != getFileSize())
+    {
+        fm_close(&mapping);
+        return;
+    }
+
+    Vector<ByteExtent> all;
+    ByteExtent whole;
+    whole.offset = 0;
+    whole.length = baseSize();
+    all.push_back(whole);
+
+    if (journal.detachCost(pieces, all) > SAVE_DETACH_LIMIT || !journal.detachOriginal(pieces, all))
+        journal.clear();
+
+    journal.rebase(pieces);
+    fm_close(&fileMap);
+    bb_free(&fileData);
+    fileMap = mapping;
+    pieces.setOriginalMapping(&fileMap);
+    clearDisassemblyCache();
+}
+
+bool HexData::detachBase()
+{
+    if (!fm_is_open(&fileMap))
+        return true;
+
+    ByteBuffer copy;
+    bb_init(&copy);
+    if (!bb_resize(&copy, (size_t)fileMap.size))
+        return false;
+
+    fm_read(&fileMap, 0, copy.data, fileMap.size);
+    fm_close(&fileMap);
+    bb_free(&fileData);
+    fileData = copy;
+    pieces.setOriginal(fileData.data);
+    return true;
+}
+
+bool HexData::editByte(uint64_t offset, uint8_t newValue)
 {
-    clear();
-    bb_free(&fileData);
-    la_free(&hexLines);
-    la_free(&disassemblyLines);
-    ss_free(&headerLine);
-    pba_free(&pluginAnnotations);
+    return writeBytes(offset, &newValue, 1, true);
 }
 
-void HexData::addPlugin(const char* path)
+uint64_t HexData::clipToEnd(uint64_t offset, uint64_t length) const
 {
-  if (!path || !path[0] || pluginCount >= MAX_PLUGINS)
-    return;
+    uint64_t size = getFileSize();
+    if (offset >= size)
+        return 0;
+    return length < size - offset ? length : size - offset;
+}
 
-  for (int i = 0; i < pluginCount; i++)
-  {
-    if (strEquals(pluginPaths[i], path))
-      return;
-  }
+void HexData::markEdited(uint64_t offset, uint64_t removed, uint64_t inserted)
+{
+    editGeneration++;
 
-  int i = 0;
-  while (path[i] && i < 511)
-  {
-    pluginPaths[pluginCount][i] = path[i];
-    i++;
-  }
-  pluginPaths[pluginCount][i] = '\0';
+    // A size change moves everything after the edit.
+    EditSpan& span = editHistory[editGeneration % EDIT_HISTORY];
+    span.generation = editGeneration;
+    span.offset = offset;
+    span.length = removed == inserted ? inserted : getFileSize() - offset;
 
-  pluginCount++;
-  usePlugins = true;
+    if (removed == inserted)
+    {
+        invalidateDisassembly(offset, inserted ? inserted : 1);
+        return;
+    }
 
-  if (!bb_empty(&fileData))
-  {
-    convertDataToHex(currentBytesPerLine);
-  }
+    clearDisassemblyCache();
+    shiftOffsets(offset, removed, inserted);
 }
 
-void HexData::clearAllPlugins()
+// Generations bumped by reloads, stream trims and the like record no span, so
+// a gap in the history means the caller has to start over.
+bool HexData::editedSince(uint64_t generation, Vector<ByteExtent>& out) const
 {
-  pluginCount = 0;
-  usePlugins = false;
+    out.clear();
+    if (generation > editGeneration || editGeneration - generation > EDIT_HISTORY)
+        return false;
 
-  for (int i = 0; i < MAX_PLUGINS; i++)
-  {
-    pluginPaths[i][0] = '\0';
-  }
+    for (uint64_t g = generation + 1; g <= editGeneration; g++)
+    {
+        const EditSpan& span = editHistory[g % EDIT_HISTORY];
+        if (span.generation != g)
+            return false;
 
-  if (!bb_empty(&fileData))
-  {
-    convertDataToHex(currentBytesPerLine);
-  }
+        ByteExtent extent;
+        extent.offset = span.offset;
+        extent.length = span.length;
+        out.push_back(extent);
+    }
+    return true;
 }
 
-bool HexData::hasPlugins() const
+void HexData::shiftOffsets(uint64_t offset, uint64_t removed, uint64_t inserted)
 {
-  return usePlugins && pluginCount > 0;
+    for (size_t i = 0; i < pluginAnnotations.count; i++)
+    {
+        PluginBookmark& bm = pluginAnnotations.bookmarks[i];
+        bm.offset = shift_offset(bm.offset, offset, removed, inserted);
+    }
+
+    if (shiftCallback)
+        shiftCallback(offset, removed, inserted);
 }
 
-const char* HexData::getPluginPath(int index) const
+bool HexData::writeBytes(uint64_t offset, const uint8_t* data, uint64_t length, bool mergeable)
 {
-  if (index < 0 || index >= pluginCount)
-    return nullptr;
-  return pluginPaths[index];
-}
+    if (isFilling())
+        return false;
 
+    length = clipToEnd(offset, length);
+    if (length == 0 || !data)
+        return false;
 
-void HexData::setDisassemblyPlugin(const char* path)
+    if (!journal.begin(pieces, offset, length, length, mergeable))
+        return false;
+
+    if (!pieces.replace(offset, length, data, length))
+    {
+        journal.cancel();
+        return false;
+    }
+
+    journal.commit(pieces);
+    markEdited(offset, length, length);
+    return true;
+}
+
+bool HexData::spliceBytes(uint64_t offset, uint64_t removeLength, const uint8_t* data, uint64_t length)
 {
-  if (!path || !path[0])
-    return;
+    if (isProcessMemory || isFilling() || offset > getFileSize())
+        return false;
 
-  clearAllPlugins();
-  addPlugin(path);
+    if (!journal.begin(pieces, offset, removeLength, length, false))
+        return false;
 
-  int i = 0;
-  while (path[i] && i < 511)
-  {
-    pluginPath[i] = path[i];
-    i++;
-  }
-  pluginPath[i] = '\0';
-  usePlugin = true;
+    if (!pieces.replace(offset, removeLength, data, length))
+    {
+        journal.cancel();
+        return false;
+    }
+
+    journal.commit(pieces);
+    markEdited(offset, removeLength, length);
+    return true;
 }
 
-void HexData::clearDisassemblyPlugin()
+bool HexData::insertBytes(uint64_t offset, const uint8_t* data, uint64_t length)
 {
-  clearAllPlugins();
+    if (length == 0 || !data)
+        return false;
+    return spliceBytes(offset, 0, data, length);
+}
 
-  usePlugin = false;
-  pluginPath[0] = '\0';
+bool HexData::deleteBytes(uint64_t offset, uint64_t length)
+{
+    length = clipToEnd(offset, length);
+    if (length == 0)
+        return false;
+    return spliceBytes(offset, length, nullptr, 0);
 }
 
-bool HexData::hasDisassemblyPlugin() const
+bool HexData::writeRange(uint64_t offset, const uint8_t* data, uint64_t length)
 {
-  return hasPlugins();
+    return writeBytes(offset, data, length, false);
 }
 
-void HexData::generateDisassemblyFromPlugin(int bytesPerLine)
+bool HexData::fillRange(uint64_t offset, uint64_t length, const uint8_t* pattern, uint32_t patternLength)
 {
-  la_clear(&disassemblyLines);
+    if (isFilling())
+        return false;
 
-  if (!hasPlugins())
-    return;
+    length = clipToEnd(offset, length);
+    if (length == 0 || !pattern || patternLength == 0)
+        return false;
 
-  size_t numLines = (fileData.size + bytesPerLine - 1) / bytesPerLine;
-  for (size_t i = 0; i < numLines; i++)
-  {
-    SimpleString line;
-    ss_init(&line);
-    la_push_back(&disassemblyLines, &line);
-    ss_free(&line);
-  }
+    if (!journal.begin(pieces, offset, length, length, false))
+        return false;
+
+    if (!pieces.fill(offset, length, length, pattern, patternLength))
+    {
+        journal.cancel();
+        return false;
+    }
+
+    journal.commit(pieces);
+    markEdited(offset, length, length);
+    return true;
 }
 
-void HexData::generateDisassembly(int bytesPerLine)
+bool HexData::copyRange(uint64_t srcOffset, uint64_t dstOffset, uint64_t length)
 {
-    if (usePlugin)
+    if (isFilling())
+        return false;
+
+    length = clipToEnd(srcOffset, length);
+    length = clipToEnd(dstOffset, length);
+    if (length == 0)
+        return false;
+
+    if (!journal.begin(pieces, dstOffset, length, length, false))
+        return false;
+
+    if (!pieces.copy(srcOffset, length, dstOffset, length))
     {
-        generateDisassemblyFromPlugin(bytesPerLine);
-        return;
+        journal.cancel();
+        return false;
     }
 
-    la_clear(&disassemblyLines);
+    journal.commit(pieces);
+    markEdited(dstOffset, length, length);
+    return true;
 }
 
-bool HexData::initializeCapstone()
+bool HexData::undo(uint64_t* outOffset)
 {
-    return false;
+    uint64_t offset, removed, inserted;
+    if (!journal.undo(pieces, &offset, &removed, &inserted))
+        return false;
+
+    markEdited(offset, removed, inserted);
+    if (outOffset)
+        *outOffset = offset;
+    return true;
 }
 
-void HexData::cleanupCapstone()
+bool HexData::redo(uint64_t* outOffset)
 {
+    uint64_t offset, removed, inserted;
+    if (!journal.redo(pieces, &offset, &removed, &inserted))
+        return false;
+
+    markEdited(offset, removed, inserted);
+    if (outOffset)
+        *outOffset = offset;
+    return true;
 }
 
-void HexData::setArchitecture(int /*arch*/, int /*mode*/)
+void HexData::setModified(bool mod)
 {
+    modified = mod;
+    if (!mod)
+        journal.markSaved();
 }
 
-void HexData::disassembleInstruction(size_t /*offset*/,
-                                     int &instructionLength,
-                                     SimpleString &outInstr)
+uint8_t HexData::getByte(uint64_t offset) const
 {
-    ss_clear(&outInstr);
-    instructionLength = 1;
+    return pieces.byteAt(offset);
 }
 
-bool HexData::loadFile(const char* filepath)
+void HexData::adviseAccess(uint64_t offset, uint64_t length, FileMapAdvice advice)
 {
-  if (!read_file_all(filepath, &fileData))
-  {
-    la_clear(&hexLines);
-    la_push_back_cstr(&hexLines, "Error: Failed to open or read file");
-    return false;
-  }
+    if (fm_is_open(&fileMap))
+        fm_advise(&fileMap, offset, length, advice);
+}
 
-  clearDisassemblyCache();
-  clearPluginAnnotations();
-  clearMemoryMap();
-  isProcessMemory = false;
+void HexData::readAhead(uint64_t viewOffset, uint64_t viewLength)
+{
+    if (!fm_is_open(&fileMap) || viewOffset == lastViewOffset)
+        return;
 
-  convertDataToHex(16);
-  modified = false;
-  return true;
+    bool forward = viewOffset > lastViewOffset;
+    lastViewOffset = viewOffset;
+
+    uint64_t size = fileMap.size;
+    uint64_t start;
+    uint64_t end;
+    if (forward)
+    {
+        start = viewOffset + viewLength;
+        end = start + READAHEAD_WINDOW;
+    }
+    else
+    {
+        end = viewOffset;
+        start = end > READAHEAD_WINDOW ? end - READAHEAD_WINDOW : 0;
+    }
+    if (end > size)
+        end = size;
+    if (start >= end)
+        return;
+
+    // Re-issue the hint only once the view has consumed half of the last window.
+    if (forward && start >= readAheadStart && start + READAHEAD_WINDOW / 2 <= readAheadEnd)
+        return;
+    if (!forward && end <= readAheadEnd && end >= readAheadStart + READAHEAD_WINDOW / 2)
+        return;
+
+    fm_advise(&fileMap, start, end - start, FM_ADVICE_WILLNEED);
+    readAheadStart = start;
+    readAheadEnd = end;
 }
 
-bool HexData::saveFile(const char *filepath)
+// Only memory this process owns counts; pages of a mapped file belong to the
+// page cache and are reclaimed by the kernel without our help.
+uint64_t HexData::memoryUsage() const
+{
+    uint64_t usage = fileData.capacity + pieces.memoryUsage() + journal.memoryUsage() +
+        (uint64_t)streamStore.count * STREAM_STORE_CHUNK;
+    if (disasmLines)
+        usage += sizeof(DisasmLine) * DISASM_CACHE_LINES;
+    return usage;
+}
+
+uint64_t HexData::releaseCaches(uint64_t keepOffset, uint64_t keepLength)
 {
-    if (!write_file_all(filepath, fileData.data, fileData.size))
+    uint64_t released = 0;
+    if (disasmLines && keepLength == 0)
     {
-        return false;
+        sysFree(disasmLines);
+        disasmLines = nullptr;
+        released += sizeof(DisasmLine) * DISASM_CACHE_LINES;
     }
-    modified = false;
-    return true;
+
+    if (!fm_is_open(&fileMap) || isLoading())
+        return released;
+
+    // Unmap our view of the rest of the file; the page cache itself is left alone.
+    uint64_t keepEnd = keepOffset + keepLength;
+    if (keepEnd > fileMap.size)
+        keepEnd = fileMap.size;
+    if (keepOffset > 0)
+        fm_advise(&fileMap, 0, keepOffset, FM_ADVICE_DONTNEED);
+    if (keepEnd < fileMap.size)
+        fm_advise(&fileMap, keepEnd, fileMap.size - keepEnd, FM_ADVICE_DONTNEED);
+
+    readAheadStart = 0;
+    readAheadEnd = 0;
+    return released;
 }
 
-bool HexData::editByte(size_t offset, uint8_t newValue)
+bool HexData::scanRange(uint64_t offset, uint64_t length, ScanChunkCallback callback, void* context)
 {
-    if (offset >= fileData.size)
+    uint64_t size = getFileSize();
+    if (offset > size || isFilling())
         return false;
-    fileData.data[offset] = newValue;
-    modified = true;
-    regenerateHexLines(currentBytesPerLine);
-    return true;
-}
+    if (length > size - offset)
+        length = size - offset;
 
-uint8_t HexData::getByte(size_t offset) const
-{
-    if (offset >= fileData.size)
-        return 0;
-    return fileData.data[offset];
+    if (fm_is_open(&fileMap) && pieces.isPristine() && pieces.length() == fileMap.size)
+    {
+        ScanStats stats;
+        bool ok = sr_scan_file(&fileMap, offset, length, callback, context, &stats);
+        if (ok || stats.bytes > 0)
+        {
+            scanStats = stats;
+            return ok;
+        }
+    }
+
+    ByteBuffer chunk;
+    bb_init(&chunk);
+    if (!bb_resize(&chunk, SCAN_CHUNK))
+        return false;
+
+    uint64_t start = sr_now_us();
+    uint64_t done = 0;
+    while (done < length)
+    {
+        uint64_t n = length - done;
+        if (n > SCAN_CHUNK)
+            n = SCAN_CHUNK;
+        pieces.read(offset + done, chunk.data, n);
+        done += n;
+        if (!callback(context, offset + done - n, chunk.data, (size_t)n))
+            break;
+    }
+    bb_free(&chunk);
+
+    scanStats.bytes = done;
+    scanStats.microseconds = sr_now_us() - start;
+    scanStats.backend = SCAN_BACKEND_MEMORY;
+    return true;
 }
 
 void HexData::clear()
 {
-  bb_resize(&fileData, 0);
-  la_clear(&hexLines);
-  la_clear(&disassemblyLines);
+  fl_cancel(&loader);
+  fl_wait(&loader);
+  fl_init(&loader);
+  st_close(&stream);
+  st_store_free(&streamStore);
+  streamDropped = 0;
+  loadReported = true;
+  lastViewOffset = 0;
+  readAheadStart = 0;
+  readAheadEnd = 0;
+  pieces.clear();
+  journal.clear();
+  editGeneration++;
+  contentId = ++g_NextContentId;
+  fm_close(&fileMap);
+  bb_free(&fileData);
   ss_clear(&headerLine);
   clearDisassemblyCache();
   clearMemoryMap();
@@ -384,32 +1253,46 @@ void HexData::clear()
 
 void HexData::regenerateHexLines(int bytesPerLine)
 {
-    if (!bb_empty(&fileData))
+    if (!isEmpty())
     {
         convertDataToHex(bytesPerLine);
     }
 }
 
-bool HexData::isRangeDisassembled(size_t startOffset, size_t endOffset)
+bool HexData::isRangeDisassembled(uint64_t startOffset, uint64_t endOffset)
 {
     if (!hasDisassemblyPlugin())
     {
         return true;
     }
 
-    for (size_t i = 0; i < disasmRanges.size(); i++)
+    if (!disasmLines || endOffset <= startOffset)
+        return disasmLines != nullptr;
+
+    uint64_t startLine = startOffset / currentBytesPerLine;
+    uint64_t endLine = (endOffset - 1) / currentBytesPerLine;
+
+    for (uint64_t lineIdx = startLine; lineIdx <= endLine; lineIdx++)
     {
-        if (disasmRanges[i].valid &&
-            disasmRanges[i].startOffset <= startOffset &&
-            disasmRanges[i].endOffset >= endOffset)
-        {
-            return true;
-        }
+        const DisasmLine& entry = disasmLines[lineIdx % DISASM_CACHE_LINES];
+        if (!entry.valid || entry.lineIndex != lineIdx)
+            return false;
     }
-    return false;
+    return true;
+}
+
+const char* HexData::getDisassemblyLine(uint64_t lineIndex) const
+{
+    if (!disasmLines)
+        return nullptr;
+
+    const DisasmLine& entry = disasmLines[lineIndex % DISASM_CACHE_LINES];
+    if (!entry.valid || entry.lineIndex != lineIndex)
+        return nullptr;
+    return entry.text;
 }
 
-void HexData::disassembleRange(size_t offset, size_t size)
+void HexData::disassembleRange(uint64_t offset, uint64_t size)
 {
   if (!hasPlugins() || size == 0)
     return;
@@ -421,18 +1304,35 @@ void HexData::disassembleRange(size_t offset, size_t size)
     size_t offset,
     LineArray * outLines);
 
-  size_t startLine = offset / currentBytesPerLine;
-  size_t endLine = (offset + size) / currentBytesPerLine;
+  uint64_t startLine = offset / currentBytesPerLine;
+  uint64_t endLine = (offset + size) / currentBytesPerLine;
+
+  if (!disasmLines)
+  {
+    disasmLines = (DisasmLine*)sysAlloc(sizeof(DisasmLine) * DISASM_CACHE_LINES);
+    if (!disasmLines)
+      return;
+    clearDisassemblyCache();
+  }
+
+  uint64_t dataSize = getFileSize();
+  uint8_t chunk[64];
 
-  for (size_t lineIdx = startLine; lineIdx <= endLine && lineIdx < hexLines.count; lineIdx++)
+  for (uint64_t lineIdx = startLine; lineIdx <= endLine && lineIdx < getLineCount(); lineIdx++)
   {
-    size_t byteOffset = lineIdx * currentBytesPerLine;
+    uint64_t byteOffset = lineIdx * currentBytesPerLine;
 
-    if (byteOffset >= fileData.size)
+    if (byteOffset >= dataSize)
       break;
 
-    size_t remaining = fileData.size - byteOffset;
-    size_t chunkSize = remaining < (size_t)currentBytesPerLine ? remaining : (size_t)currentBytesPerLine;
+    uint64_t remaining = dataSize - byteOffset;
+    size_t chunkSize = remaining < (uint64_t)currentBytesPerLine ? (size_t)remaining : (size_t)currentBytesPerLine;
+    chunkSize = pieces.read(byteOffset, chunk, chunkSize);
+
+    DisasmLine& entry = disasmLines[lineIdx % DISASM_CACHE_LINES];
+    entry.lineIndex = lineIdx;
+    entry.valid = true;
+    entry.text[0] = '\0';
 
     LineArray tempLines;
     la_init(&tempLines);
@@ -444,20 +1344,14 @@ void HexData::disassembleRange(size_t offset, size_t size)
       {
         if (ExecutePythonDisassembly(
           pluginPaths[pluginIdx],
-          fileData.data + byteOffset,
+          chunk,
           chunkSize,
-          byteOffset,
+          (size_t)byteOffset,
           &tempLines))
         {
-          if (lineIdx < disassemblyLines.count)
+          if (tempLines.count > 0 && tempLines.lines[0].length > 0)
           {
-            ss_free(&disassemblyLines.lines[lineIdx]);
-            ss_init(&disassemblyLines.lines[lineIdx]);
-
-            if (tempLines.count > 0 && tempLines.lines[0].length > 0)
-            {
-              ss_append_cstr(&disassemblyLines.lines[lineIdx], tempLines.lines[0].data);
-            }
+            stringCopy(entry.text, tempLines.lines[0].data, DISASM_LINE_LEN);
           }
           disassembled = true;
         }
@@ -466,23 +1360,41 @@ void HexData::disassembleRange(size_t offset, size_t size)
 
     la_free(&tempLines);
   }
-
-  DisasmCache cache;
-  cache.startOffset = offset;
-  cache.endOffset = offset + size;
-  cache.valid = true;
-  disasmRanges.push_back(cache);
 }
 
 void HexData::clearDisassemblyCache()
 {
-    disasmRanges.clear();
+    if (!disasmLines)
+        return;
+
+    for (int i = 0; i < DISASM_CACHE_LINES; i++)
+        disasmLines[i].valid = false;
+}
+
+void HexData::invalidateDisassembly(uint64_t offset, uint64_t length)
+{
+    if (!disasmLines || length == 0)
+        return;
+
+    uint64_t startLine = offset / currentBytesPerLine;
+    uint64_t endLine = (offset + length - 1) / currentBytesPerLine;
+
+    for (uint64_t lineIdx = startLine; lineIdx <= endLine && lineIdx - startLine < DISASM_CACHE_LINES; lineIdx++)
+    {
+        DisasmLine& entry = disasmLines[lineIdx % DISASM_CACHE_LINES];
+        if (entry.lineIndex == lineIdx)
+            entry.valid = false;
+    }
 }
 
 void HexData::generateHeader(int bytesPerLine)
 {
     ss_clear(&headerLine);
-    ss_append_cstr(&headerLine, "Offset    ");
+    ss_append_cstr(&headerLine, "Offset  ");
+    for (int i = 8; i < getOffsetDigits() + 2; ++i)
+    {
+        ss_append_char(&headerLine, ' ');
+    }
     for (int i = 0; i < bytesPerLine; ++i)
     {
         ss_append_dec2(&headerLine, (unsigned int)i);
@@ -494,11 +1406,8 @@ void HexData::generateHeader(int bytesPerLine)
 
 void HexData::convertDataToHex(int bytesPerLine)
 {
-  la_clear(&hexLines);
-
-  if (bb_empty(&fileData))
+  if (isEmpty())
   {
-    la_push_back_cstr(&hexLines, "No data to display");
     ss_clear(&headerLine);
     return;
   }
@@ -508,24 +1417,13 @@ void HexData::convertDataToHex(int bytesPerLine)
 
   generateHeader(bytesPerLine);
   generateDisassembly(bytesPerLine);
-
-  size_t lineCount = (fileData.size + bytesPerLine - 1) / bytesPerLine;
-
-  hexLines.count = lineCount;
-  hexLines.capacity = lineCount;
-  hexLines.lines = (SimpleString*)memAlloc(sizeof(SimpleString) * lineCount);
-
-  for (size_t i = 0; i < lineCount; i++)
-  {
-    ss_init(&hexLines.lines[i]);
-  }
 }
 
 void HexData::executeBookmarkPlugins()
 {
   clearPluginAnnotations();
 
-  if (bb_empty(&fileData) || !hasPlugins())
+  if (isEmpty() || !hasPlugins())
     return;
 
   extern bool ExecutePluginBookmarks(
@@ -535,6 +1433,18 @@ void HexData::executeBookmarkPlugins()
     PluginBookmarkArray * outBookmarks,
     const Vector<MemoryRegion>*memoryMap);
 
+  const uint8_t* data = baseData();
+  ByteBuffer snapshot;
+  bb_init(&snapshot);
+
+  if (!pieces.isPristine())
+  {
+    if (!bb_resize(&snapshot, getFileSize()))
+      return;
+    pieces.read(0, snapshot.data, snapshot.size);
+    data = snapshot.data;
+  }
+
   for (int i = 0; i < pluginCount; i++)
   {
     if (!CanPluginGenerateBookmarks(pluginPaths[i]))
@@ -549,11 +1459,13 @@ void HexData::executeBookmarkPlugins()
 
     ExecutePluginBookmarks(
       pluginPaths[i],
-      fileData.data,
-      fileData.size,
+      data,
+      getFileSize(),
       &pluginAnnotations,
       mapPtr);
   }
+
+  bb_free(&snapshot);
 }
 
 bool HexData::virtualAddressToOffset(uint64_t virtualAddress, size_t* outOffset) const
@@ -583,30 +1495,57 @@ void HexData::clearPluginAnnotations()
   pba_init(&pluginAnnotations);
 }
 
-void HexData::getHexLine(size_t lineIndex, char* outBuffer, size_t bufferSize) const
+size_t HexData::formatHex(uint64_t offset, uint64_t length, char* out) const
+{
+  uint8_t chunk[4096];
+  size_t written = 0;
+  while (length > 0)
+  {
+    size_t want = length < sizeof(chunk) ? (size_t)length : sizeof(chunk);
+    size_t got = pieces.read(offset, chunk, want);
+    if (got == 0)
+      break;
+    hf_hex(chunk, got, out + written);
+    written += got * 3;
+    offset += got;
+    length -= got;
+  }
+  return written;
+}
+
+void HexData::getHexLine(uint64_t lineIndex, char* outBuffer, size_t bufferSize) const
 {
   if (!outBuffer || bufferSize < 128)
     return;
 
-  size_t byteOffset = lineIndex * currentBytesPerLine;
+  uint64_t byteOffset = lineIndex * currentBytesPerLine;
+  uint64_t dataSize = getFileSize();
 
-  if (byteOffset >= fileData.size)
+  if (byteOffset >= dataSize)
   {
     outBuffer[0] = 0;
     return;
   }
 
+  uint8_t data[64];
+  size_t lineBytes = pieces.read(byteOffset, data, currentBytesPerLine);
+
+  uint64_t loadedSize = getLoadedSize();
+  size_t loadedBytes = byteOffset >= loadedSize ? 0 :
+    (loadedSize - byteOffset < lineBytes ? (size_t)(loadedSize - byteOffset) : lineBytes);
+
   char* ptr = outBuffer;
   size_t remaining = bufferSize;
 
-  if (remaining > 10)
+  int digits = getOffsetDigits();
+  if (remaining > (size_t)digits + 2)
   {
-    char hex8[8];
-    uintToHex8((unsigned int)byteOffset, hex8);
+    char hex16[16];
+    uintToHex16((unsigned long long)byteOffset, hex16);
 
-    for (int i = 0; i < 8 && remaining > 1; i++)
+    for (int i = 16 - digits; i < 16 && remaining > 1; i++)
     {
-      *ptr++ = hex8[i];
+      *ptr++ = hex16[i];
       remaining--;
     }
 
@@ -618,17 +1557,44 @@ void HexData::getHexLine(size_t lineIndex, char* outBuffer, size_t bufferSize) c
     }
   }
 
+  // Whole rows that fit the buffer go through the vector kernels.
+  if (loadedBytes == lineBytes && remaining > (size_t)currentBytesPerLine * 4 + 1)
+  {
+    hf_hex(data, lineBytes, ptr);
+    ptr += lineBytes * 3;
+    size_t pad = ((size_t)currentBytesPerLine - lineBytes) * 3;
+    memSet(ptr, ' ', pad);
+    ptr += pad;
+    *ptr++ = ' ';
+    hf_ascii(data, lineBytes, ptr);
+    ptr += lineBytes;
+    remaining = bufferSize - (size_t)(ptr - outBuffer);
+
+    while (remaining > 1 && (ptr - outBuffer) < 120 + digits - 8)
+    {
+      *ptr++ = ' ';
+      remaining--;
+    }
+    *ptr = 0;
+    return;
+  }
+
   for (int j = 0; j < currentBytesPerLine; ++j)
   {
     if (remaining < 3)
       break;
 
-    size_t idx = byteOffset + j;
-
-    if (idx < fileData.size)
+    if ((size_t)j >= loadedBytes && (size_t)j < lineBytes)
+    {
+      *ptr++ = '?';
+      *ptr++ = '?';
+      *ptr++ = ' ';
+      remaining -= 3;
+    }
+    else if ((size_t)j < lineBytes)
     {
       char hx[2];
-      byteToHex(fileData.data[idx], hx);
+      byteToHex(data[j], hx);
 
       *ptr++ = hx[0];
       *ptr++ = hx[1];
@@ -655,16 +1621,15 @@ void HexData::getHexLine(size_t lineIndex, char* outBuffer, size_t bufferSize) c
     if (remaining < 2)
       break;
 
-    size_t idx = byteOffset + j;
-    if (idx >= fileData.size)
+    if ((size_t)j >= lineBytes)
       break;
 
-    uint8_t b = fileData.data[idx];
-    *ptr++ = (b >= 32 && b != 127) ? (char)b : '.';
+    uint8_t b = data[j];
+    *ptr++ = (size_t)j >= loadedBytes ? ' ' : (b >= 32 && b != 127) ? (char)b : '.';
     remaining--;
   }
 
-  while (remaining > 1 && (ptr - outBuffer) < 120)
+  while (remaining > 1 && (ptr - outBuffer) < 120 + digits - 8)
   {
     *ptr++ = ' ';
     remaining--;
@@ -0,0 +1,312 @@
+#include "hexformat.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define HEXFORMAT_X86 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#include <immintrin.h>
+#define HF_TARGET(x)
+#else
+#include <immintrin.h>
+#include <cpuid.h>
+#define HF_TARGET(x) __attribute__((target(x)))
+#endif
+#endif
+
+static const char kHexDigits[] = "0123456789ABCDEF";
+
+#define Z BYTE_CLASS_ZERO
+#define P BYTE_CLASS_PRINTABLE
+#define W BYTE_CLASS_WHITESPACE
+#define C BYTE_CLASS_CONTROL
+#define H BYTE_CLASS_HIGH
+
+const uint8_t hf_byte_class[256] =
+{
+  Z, C, C, C, C, C, C, C, C, W, W, W, W, W, C, C,
+  C, C, C, C, C, C, C, C, C, C, C, C, C, C, C, C,
+  W, P, P, P, P, P, P, P, P, P, P, P, P, P, P, P,
+  P, P, P, P, P, P, P, P, P, P, P, P, P, P, P, P,
+  P, P, P, P, P, P, P, P, P, P, P, P, P, P, P, P,
+  P, P, P, P, P, P, P, P, P, P, P, P, P, P, P, P,
+  P, P, P, P, P, P, P, P, P, P, P, P, P, P, P, P,
+  P, P, P, P, P, P, P, P, P, P, P, P, P, P, P, C,
+  H, H, H, H, H, H, H, H, H, H, H, H, H, H, H, H,
+  H, H, H, H, H, H, H, H, H, H, H, H, H, H, H, H,
+  H, H, H, H, H, H, H, H, H, H, H, H, H, H, H, H,
+  H, H, H, H, H, H, H, H, H, H, H, H, H, H, H, H,
+  H, H, H, H, H, H, H, H, H, H, H, H, H, H, H, H,
+  H, H, H, H, H, H, H, H, H, H, H, H, H, H, H, H,
+  H, H, H, H, H, H, H, H, H, H, H, H, H, H, H, H,
+  H, H, H, H, H, H, H, H, H, H, H, H, H, H, H, H,
+};
+
+#undef Z
+#undef P
+#undef W
+#undef C
+#undef H
+
+static void hex_scalar(const uint8_t* src, size_t count, char* out)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    out[0] = kHexDigits[src[i] >> 4];
+    out[1] = kHexDigits[src[i] & 0x0F];
+    out[2] = ' ';
+    out += 3;
+  }
+}
+
+static void ascii_scalar(const uint8_t* src, size_t count, char* out)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    uint8_t b = src[i];
+    out[i] = (b >= 32 && b != 127) ? (char)b : '.';
+  }
+}
+
+#ifdef HEXFORMAT_X86
+
+// pshufb masks that spread 16 interleaved digit pairs into 48 "XX " columns.
+// Pairs for bytes 0-7 come from the low unpack, bytes 8-15 from the high one.
+static const uint8_t kLayoutLo[3][16] =
+{
+  { 0x00, 0x01, 0x80, 0x02, 0x03, 0x80, 0x04, 0x05, 0x80, 0x06, 0x07, 0x80, 0x08, 0x09, 0x80, 0x0A },
+  { 0x0B, 0x80, 0x0C, 0x0D, 0x80, 0x0E, 0x0F, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 }
+};
+
+static const uint8_t kLayoutHi[3][16] =
+{
+  { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x01, 0x80, 0x02, 0x03, 0x80, 0x04, 0x05 },
+  { 0x80, 0x06, 0x07, 0x80, 0x08, 0x09, 0x80, 0x0A, 0x0B, 0x80, 0x0C, 0x0D, 0x80, 0x0E, 0x0F, 0x80 }
+};
+
+static const uint8_t kLayoutSpace[3][16] =
+{
+  { 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00 },
+  { 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00 },
+  { 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20 }
+};
+
+HF_TARGET("ssse3")
+static inline void layout16(__m128i hiDigits, __m128i loDigits, char* out)
+{
+  __m128i a = _mm_unpacklo_epi8(hiDigits, loDigits);
+  __m128i b = _mm_unpackhi_epi8(hiDigits, loDigits);
+
+  __m128i r0 = _mm_or_si128(_mm_shuffle_epi8(a, _mm_loadu_si128((const __m128i*)kLayoutLo[0])),
+                            _mm_loadu_si128((const __m128i*)kLayoutSpace[0]));
+  __m128i r1 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, _mm_loadu_si128((const __m128i*)kLayoutLo[1])),
+                                         _mm_shuffle_epi8(b, _mm_loadu_si128((const __m128i*)kLayoutHi[1]))),
+                            _mm_loadu_si128((const __m128i*)kLayoutSpace[1]));
+  __m128i r2 = _mm_or_si128(_mm_shuffle_epi8(b, _mm_loadu_si128((const __m128i*)kLayoutHi[2])),
+                            _mm_loadu_si128((const __m128i*)kLayoutSpace[2]));
+
+  _mm_storeu_si128((__m128i*)out, r0);
+  _mm_storeu_si128((__m128i*)(out + 16), r1);
+  _mm_storeu_si128((__m128i*)(out + 32), r2);
+}
+
+HF_TARGET("ssse3")
+static void hex_ssse3(const uint8_t* src, size_t count, char* out)
+{
+  const __m128i lut = _mm_loadu_si128((const __m128i*)kHexDigits);
+  const __m128i mask = _mm_set1_epi8(0x0F);
+
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+    __m128i lo = _mm_and_si128(v, mask);
+    layout16(_mm_shuffle_epi8(lut, hi), _mm_shuffle_epi8(lut, lo), out + i * 3);
+  }
+  hex_scalar(src + i, count - i, out + i * 3);
+}
+
+HF_TARGET("ssse3")
+static void ascii_ssse3(const uint8_t* src, size_t count, char* out)
+{
+  const __m128i space = _mm_set1_epi8(32);
+  const __m128i del = _mm_set1_epi8(127);
+  const __m128i dot = _mm_set1_epi8('.');
+
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+    __m128i printable = _mm_andnot_si128(_mm_cmpeq_epi8(v, del),
+                                         _mm_cmpeq_epi8(_mm_max_epu8(v, space), v));
+    __m128i r = _mm_or_si128(_mm_and_si128(printable, v), _mm_andnot_si128(printable, dot));
+    _mm_storeu_si128((__m128i*)(out + i), r);
+  }
+  ascii_scalar(src + i, count - i, out + i);
+}
+
+HF_TARGET("avx2")
+static void hex_avx2(const uint8_t* src, size_t count, char* out)
+{
+  if (count < 32)
+  {
+    hex_ssse3(src, count, out);
+    return;
+  }
+
+  const __m256i lut = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)kHexDigits));
+  const __m256i mask = _mm256_set1_epi8(0x0F);
+
+  size_t i = 0;
+  for (; i + 32 <= count; i += 32)
+  {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+    __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), mask));
+    __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, mask));
+    layout16(_mm256_castsi256_si128(hi), _mm256_castsi256_si128(lo), out + i * 3);
+    layout16(_mm256_extracti128_si256(hi, 1), _mm256_extracti128_si256(lo, 1), out + i * 3 + 48);
+  }
+  // The tail runs legacy SSE code; clear the upper halves to avoid transition stalls.
+  _mm256_zeroupper();
+  hex_ssse3(src + i, count - i, out + i * 3);
+}
+
+HF_TARGET("avx2")
+static void ascii_avx2(const uint8_t* src, size_t count, char* out)
+{
+  if (count < 32)
+  {
+    ascii_ssse3(src, count, out);
+    return;
+  }
+
+  const __m256i space = _mm256_set1_epi8(32);
+  const __m256i del = _mm256_set1_epi8(127);
+  const __m256i dot = _mm256_set1_epi8('.');
+
+  size_t i = 0;
+  for (; i + 32 <= count; i += 32)
+  {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+    __m256i printable = _mm256_andnot_si256(_mm256_cmpeq_epi8(v, del),
+                                            _mm256_cmpeq_epi8(_mm256_max_epu8(v, space), v));
+    _mm256_storeu_si256((__m256i*)(out + i), _mm256_blendv_epi8(dot, v, printable));
+  }
+  _mm256_zeroupper();
+  ascii_ssse3(src + i, count - i, out + i);
+}
+
+static int detect_backend()
+{
+  int ecx1 = 0, ebx7 = 0;
+  bool osAvx = false;
+#if defined(_MSC_VER) && !defined(__clang__)
+  int regs[4];
+  __cpuid(regs, 0);
+  int maxLeaf = regs[0];
+  __cpuid(regs, 1);
+  ecx1 = regs[2];
+  if (maxLeaf >= 7)
+  {
+    __cpuidex(regs, 7, 0);
+    ebx7 = regs[1];
+  }
+  if (ecx1 & (1 << 27))
+    osAvx = (_xgetbv(0) & 6) == 6;
+#else
+  unsigned int a, b, c, d;
+  if (!__get_cpuid(1, &a, &b, &c, &d))
+    return HEXFORMAT_SCALAR;
+  ecx1 = (int)c;
+  if (__get_cpuid_count(7, 0, &a, &b, &c, &d))
+    ebx7 = (int)b;
+  if (ecx1 & (1 << 27))
+  {
+    unsigned int lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    osAvx = (lo & 6) == 6;
+  }
+#endif
+
+  if (osAvx && (ebx7 & (1 << 5)))
+    return HEXFORMAT_AVX2;
+  if (ecx1 & (1 << 9))
+    return HEXFORMAT_SSSE3;
+  return HEXFORMAT_SCALAR;
+}
+
+#else
+
+static int detect_backend()
+{
+  return HEXFORMAT_SCALAR;
+}
+
+#endif
+
+static int g_HexFormatBackend = -1;
+
+int hf_backend()
+{
+  if (g_HexFormatBackend < 0)
+    g_HexFormatBackend = detect_backend();
+  return g_HexFormatBackend;
+}
+
+// Lets the benchmark compare kernels; requests above what the CPU supports are clamped.
+void hf_set_backend(int backend)
+{
+  int best = detect_backend();
+  g_HexFormatBackend = backend < best ? backend : best;
+}
+
+const char* hf_backend_name(int backend)
+{
+  switch (backend)
+  {
+  case HEXFORMAT_AVX2:
+    return "AVX2";
+  case HEXFORMAT_SSSE3:
+    return "SSSE3";
+  default:
+    return "Scalar";
+  }
+}
+
+void hf_hex(const uint8_t* src, size_t count, char* out)
+{
+#ifdef HEXFORMAT_X86
+  switch (hf_backend())
+  {
+  case HEXFORMAT_AVX2:
+    hex_avx2(src, count, out);
+    return;
+  case HEXFORMAT_SSSE3:
+    hex_ssse3(src, count, out);
+    return;
+  default:
+    break;
+  }
+#endif
+  hex_scalar(src, count, out);
+}
+
+void hf_ascii(const uint8_t* src, size_t count, char* out)
+{
+#ifdef HEXFORMAT_X86
+  switch (hf_backend())
+  {
+  case HEXFORMAT_AVX2:
+    ascii_avx2(src, count, out);
+    return;
+  case HEXFORMAT_SSSE3:
+    ascii_ssse3(src, count, out);
+    return;
+  default:
+    break;
+  }
+#endif
+  ascii_scalar(src, count, out);
+}
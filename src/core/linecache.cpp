@@ -0,0 +1,146 @@
+#include "linecache.h"
+#include "hexdata.h"
+
+void fa_init(FrameArena* a)
+{
+  a->data = nullptr;
+  a->capacity = 0;
+  a->used = 0;
+}
+
+void fa_reset(FrameArena* a)
+{
+  a->used = 0;
+}
+
+void* fa_alloc(FrameArena* a, size_t size)
+{
+  if (!a->data)
+  {
+    a->data = (uint8_t*)sysAlloc(FRAME_ARENA_SIZE);
+    if (!a->data)
+      return nullptr;
+    a->capacity = FRAME_ARENA_SIZE;
+  }
+
+  size = (size + 7) & ~(size_t)7;
+  if (size > a->capacity - a->used)
+    return nullptr;
+
+  void* p = a->data + a->used;
+  a->used += size;
+  return p;
+}
+
+void fa_free(FrameArena* a)
+{
+  if (a->data)
+    sysFree(a->data);
+  fa_init(a);
+}
+
+void lc_init(LineCache* c)
+{
+  c->text = nullptr;
+  fa_init(&c->arena);
+  c->data = nullptr;
+  c->clock = 0;
+  c->hits = 0;
+  c->misses = 0;
+  lc_invalidate(c);
+}
+
+void lc_free(LineCache* c)
+{
+  if (c->text)
+    sysFree(c->text);
+  fa_free(&c->arena);
+  lc_init(c);
+}
+
+void lc_invalidate(LineCache* c)
+{
+  for (int i = 0; i < LINE_CACHE_SETS * LINE_CACHE_WAYS; i++)
+    c->slots[i].valid = false;
+}
+
+static const char* fetch_line(void* context, uint64_t line)
+{
+  return lc_get_line((LineCache*)context, line);
+}
+
+LineProvider lc_begin_frame(LineCache* c, const HexData* data, uint64_t firstLine, size_t count)
+{
+  fa_reset(&c->arena);
+  c->data = data;
+
+  LineProvider provider;
+  provider.fetch = fetch_line;
+  provider.context = c;
+  provider.firstLine = firstLine;
+  provider.count = count;
+  return provider;
+}
+
+// Lines are cached per document, edit generation and line width, so any edit,
+// reload or stream append simply stops matching instead of being tracked.
+const char* lc_get_line(LineCache* c, uint64_t line)
+{
+  const HexData* data = c->data;
+  if (!data)
+    return "";
+
+  int bytesPerLine = data->getCurrentBytesPerLine();
+  uint64_t lineEnd = (line + 1) * (uint64_t)bytesPerLine;
+
+  // Rows still being filled by the loader would be cached with placeholders.
+  if (data->isLoading() && lineEnd > data->getLoadedSize())
+  {
+    char* buf = (char*)fa_alloc(&c->arena, LINE_TEXT_SIZE);
+    if (!buf)
+      return "";
+    data->getHexLine(line, buf, LINE_TEXT_SIZE);
+    return buf;
+  }
+
+  if (!c->text)
+  {
+    c->text = (char*)sysAlloc((size_t)LINE_CACHE_SETS * LINE_CACHE_WAYS * LINE_TEXT_SIZE);
+    if (!c->text)
+      return "";
+  }
+
+  uint64_t generation = data->getEditGeneration();
+  int base = (int)(line % LINE_CACHE_SETS) * LINE_CACHE_WAYS;
+  int victim = base;
+  c->clock++;
+
+  for (int i = base; i < base + LINE_CACHE_WAYS; i++)
+  {
+    LineCacheSlot& slot = c->slots[i];
+    if (slot.valid && slot.line == line && slot.owner == data &&
+        slot.generation == generation && slot.bytesPerLine == bytesPerLine)
+    {
+      slot.lastUse = c->clock;
+      c->hits++;
+      return c->text + (size_t)i * LINE_TEXT_SIZE;
+    }
+
+    if (!c->slots[victim].valid)
+      continue;
+    if (!slot.valid || slot.lastUse < c->slots[victim].lastUse)
+      victim = i;
+  }
+
+  LineCacheSlot& slot = c->slots[victim];
+  char* text = c->text + (size_t)victim * LINE_TEXT_SIZE;
+  data->getHexLine(line, text, LINE_TEXT_SIZE);
+  slot.owner = data;
+  slot.generation = generation;
+  slot.line = line;
+  slot.lastUse = c->clock;
+  slot.bytesPerLine = bytesPerLine;
+  slot.valid = true;
+  c->misses++;
+  return text;
+}
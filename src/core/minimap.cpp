@@ -0,0 +1,266 @@
+#include "minimap.h"
+#include "hexdata.h"
+#include "hexformat.h"
+#include "scanreader.h"
+
+void mm_init(Minimap* m)
+{
+  m->owner = nullptr;
+  m->generation = 0;
+  m->fileSize = 0;
+  m->leafBytes = 0;
+  m->leafCount = 0;
+  m->built = 0;
+  m->stale = 0;
+  m->staleFrom = 0;
+  m->levelCount = 0;
+  m->nodes = nullptr;
+  m->nodeCapacity = 0;
+}
+
+void mm_free(Minimap* m)
+{
+  if (m->nodes)
+    sysFree(m->nodes);
+  mm_init(m);
+}
+
+static bool reset(Minimap* m, const HexData* data)
+{
+  m->owner = data;
+  m->generation = data->getEditGeneration();
+  m->fileSize = data->getFileSize();
+  m->built = 0;
+  m->stale = 0;
+  m->staleFrom = 0;
+  m->leafCount = 0;
+  m->levelCount = 0;
+  if (m->fileSize == 0)
+    return true;
+
+  m->leafBytes = MINIMAP_MIN_LEAF;
+  while (m->fileSize / m->leafBytes >= MINIMAP_MAX_LEAVES)
+    m->leafBytes <<= 1;
+  m->leafCount = (uint32_t)((m->fileSize + m->leafBytes - 1) / m->leafBytes);
+
+  uint32_t total = 0;
+  uint32_t size = m->leafCount;
+  while (m->levelCount < MINIMAP_LEVELS)
+  {
+    m->levelStart[m->levelCount] = total;
+    m->levelSize[m->levelCount] = size;
+    m->levelCount++;
+    total += size;
+    if (size == 1)
+      break;
+    size = (size + 1) / 2;
+  }
+
+  if (total > m->nodeCapacity)
+  {
+    if (m->nodes)
+      sysFree(m->nodes);
+    m->nodes = (MinimapNode*)sysAlloc(total * sizeof(MinimapNode));
+    m->nodeCapacity = m->nodes ? total : 0;
+    if (!m->nodes)
+    {
+      m->leafCount = 0;
+      m->levelCount = 0;
+      return false;
+    }
+  }
+  memSet(m->nodes, 0, total * sizeof(MinimapNode));
+  return true;
+}
+
+// Large leaves are sampled at a few evenly spaced spans, so building costs at
+// most MINIMAP_SAMPLE_SPANS * MINIMAP_SAMPLE_SPAN reads per leaf whatever the
+// file size.
+static int classify_leaf(const Minimap* m, const HexData* data, uint32_t leaf)
+{
+  uint8_t buffer[MINIMAP_SAMPLE_SPAN];
+  uint32_t histogram[256];
+  uint32_t classes[BYTE_CLASS_COUNT];
+  memSet(histogram, 0, sizeof(histogram));
+  memSet(classes, 0, sizeof(classes));
+
+  uint64_t start = (uint64_t)leaf * m->leafBytes;
+  uint64_t length = m->leafBytes;
+  if (length > m->fileSize - start)
+    length = m->fileSize - start;
+
+  int spans = length > (uint64_t)MINIMAP_SAMPLE_SPANS * MINIMAP_SAMPLE_SPAN ? MINIMAP_SAMPLE_SPANS : 1;
+  uint64_t stride = length / spans;
+  uint64_t n = 0;
+
+  for (int s = 0; s < spans; s++)
+  {
+    uint64_t offset = start + stride * s;
+    uint64_t remaining = spans == 1 ? length : MINIMAP_SAMPLE_SPAN;
+    while (remaining > 0)
+    {
+      size_t want = remaining > sizeof(buffer) ? sizeof(buffer) : (size_t)remaining;
+      size_t got = data->readBytes(offset, buffer, want);
+      if (got == 0)
+        break;
+      for (size_t i = 0; i < got; i++)
+      {
+        histogram[buffer[i]]++;
+        classes[hf_byte_class[buffer[i]]]++;
+      }
+      offset += got;
+      remaining -= got;
+      n += got;
+    }
+  }
+
+  if (n == 0)
+    return MINIMAP_ZERO;
+  if (histogram[0] * 4 >= n * 3)
+    return MINIMAP_ZERO;
+  if ((classes[BYTE_CLASS_PRINTABLE] + classes[BYTE_CLASS_WHITESPACE]) * 10 >= n * 9)
+    return MINIMAP_TEXT;
+
+  // Collision probability instead of Shannon entropy: uniform bytes give
+  // 256 * sum(h^2) / n^2 close to 1 + 256 / n, structured data far above it.
+  uint64_t collisions = 0;
+  for (int i = 0; i < 256; i++)
+    collisions += (uint64_t)histogram[i] * histogram[i];
+  if (collisions * 256 * 4 < n * n * 5 + n * 256 * 4)
+    return MINIMAP_ENTROPY;
+
+  return MINIMAP_OTHER;
+}
+
+static void count_leaf(Minimap* m, uint32_t leaf, int cls, int delta)
+{
+  uint32_t index = leaf;
+  for (int level = 0; level < m->levelCount; level++)
+  {
+    m->nodes[m->levelStart[level] + index].counts[cls] += delta;
+    index >>= 1;
+  }
+}
+
+// Same-size edits only flag the leaves they touched; leaves not built yet
+// will see the new bytes anyway.
+static bool mark_edits(Minimap* m, const HexData* data)
+{
+  Vector<ByteExtent> edits;
+  if (!data->editedSince(m->generation, edits))
+    return false;
+
+  for (size_t i = 0; i < edits.size(); i++)
+  {
+    if (edits[i].offset >= m->fileSize || edits[i].length == 0)
+      continue;
+    uint64_t end = edits[i].offset + edits[i].length;
+    if (end > m->fileSize || end < edits[i].offset)
+      end = m->fileSize;
+
+    uint32_t first = (uint32_t)(edits[i].offset / m->leafBytes);
+    uint32_t last = (uint32_t)((end - 1) / m->leafBytes);
+    for (uint32_t leaf = first; leaf <= last && leaf < m->built; leaf++)
+    {
+      if (m->leaves[leaf] & MINIMAP_STALE)
+        continue;
+      if (m->stale == 0 || leaf < m->staleFrom)
+        m->staleFrom = leaf;
+      m->leaves[leaf] |= MINIMAP_STALE;
+      m->stale++;
+    }
+  }
+
+  m->generation = data->getEditGeneration();
+  return true;
+}
+
+bool mm_step(Minimap* m, const HexData* data, uint64_t budgetUs)
+{
+  if (!data || data->isLoading())
+    return false;
+
+  if (m->owner != data || m->fileSize != data->getFileSize() ||
+      (m->generation != data->getEditGeneration() && !mark_edits(m, data)))
+  {
+    if (!reset(m, data))
+      return false;
+  }
+
+  if (!mm_is_building(m))
+    return false;
+
+  uint64_t start = sr_now_us();
+  do
+  {
+    if (m->stale > 0)
+    {
+      while (!(m->leaves[m->staleFrom] & MINIMAP_STALE))
+        m->staleFrom++;
+
+      uint32_t leaf = m->staleFrom;
+      int old = m->leaves[leaf] & ~MINIMAP_STALE;
+      int cls = classify_leaf(m, data, leaf);
+      if (cls != old)
+      {
+        count_leaf(m, leaf, old, -1);
+        count_leaf(m, leaf, cls, 1);
+      }
+      m->leaves[leaf] = (uint8_t)cls;
+      m->stale--;
+      continue;
+    }
+
+    int cls = classify_leaf(m, data, m->built);
+    count_leaf(m, m->built, cls, 1);
+    m->leaves[m->built] = (uint8_t)cls;
+    m->built++;
+  } while (mm_is_building(m) && sr_now_us() - start < budgetUs);
+
+  return true;
+}
+
+bool mm_is_building(const Minimap* m)
+{
+  return m->built < m->leafCount || m->stale > 0;
+}
+
+int mm_class_at(const Minimap* m, uint64_t start, uint64_t end)
+{
+  if (m->leafCount == 0 || start >= m->fileSize)
+    return MINIMAP_UNKNOWN;
+  if (end > m->fileSize)
+    end = m->fileSize;
+  if (end <= start)
+    end = start + 1;
+
+  int level = 0;
+  while (level + 1 < m->levelCount && (m->leafBytes << (level + 1)) <= end - start)
+    level++;
+
+  uint64_t blockBytes = m->leafBytes << level;
+  uint32_t first = (uint32_t)(start / blockBytes);
+  uint32_t last = (uint32_t)((end - 1) / blockBytes);
+  if (last >= m->levelSize[level])
+    last = m->levelSize[level] - 1;
+
+  uint32_t counts[MINIMAP_CLASSES] = { 0, 0, 0, 0 };
+  for (uint32_t i = first; i <= last; i++)
+  {
+    const MinimapNode& node = m->nodes[m->levelStart[level] + i];
+    for (int c = 0; c < MINIMAP_CLASSES; c++)
+      counts[c] += node.counts[c];
+  }
+
+  int best = MINIMAP_UNKNOWN;
+  uint32_t bestCount = 0;
+  for (int c = 0; c < MINIMAP_CLASSES; c++)
+  {
+    if (counts[c] > bestCount)
+    {
+      best = c;
+      bestCount = counts[c];
+    }
+  }
+  return best;
+}
@@ -18,13 +18,13 @@ extern MenuBar g_MenuBar;
 extern DIEDatabaseManager  g_DIEDatabase;
 extern long long cursorBytePos;
 extern int cursorNibblePos;
-extern int g_ScrollY;
+extern long long g_ScrollY;
 extern int g_LinesPerPage;
 extern char g_CurrentFilePath[260];
 extern char g_DIEExecutablePath[260];
 const int PANEL_TITLE_HEIGHT = 28;
-extern HexData g_HexData;
-BookmarksState g_Bookmarks = { {}, -1, -1 }; 
+extern HexData* g_HexData;
+BookmarksState g_Bookmarks = { {}, -1, -1, {}, true }; 
 ByteStatistics g_ByteStats = {{0}, 0, 0, 0, 0, 0, 0.0, false};
 DetectItEasyState g_DIEState = {};
 PatternSearchState g_PatternSearch = { "", -1, false };
@@ -43,6 +43,77 @@ void PatternSearch_Run()
     g_PatternSearch.lastMatch = -1;
 }
 
+struct PatternScan
+{
+    const uint8_t* pattern;
+    int patternLength;
+    uint8_t carry[256];
+    int carryLength;
+    long long match;
+};
+
+static long long PatternScan_Find(const PatternScan* scan, const uint8_t* data, size_t length, size_t limit)
+{
+    int patLen = scan->patternLength;
+    if (length < (size_t)patLen)
+        return -1;
+
+    for (size_t i = 0; i < limit && i <= length - patLen; i++)
+    {
+        if (data[i] != scan->pattern[0])
+            continue;
+
+        int j = 1;
+        while (j < patLen && data[i + j] == scan->pattern[j])
+            j++;
+        if (j == patLen)
+            return (long long)i;
+    }
+    return -1;
+}
+
+static bool PatternScan_Chunk(void* context, uint64_t offset, const uint8_t* data, size_t length)
+{
+    PatternScan* scan = (PatternScan*)context;
+    int keep = scan->patternLength - 1;
+
+    if (scan->carryLength > 0)
+    {
+        int extra = length < (size_t)keep ? (int)length : keep;
+        memCopy(scan->carry + scan->carryLength, data, extra);
+
+        long long hit = PatternScan_Find(scan, scan->carry, scan->carryLength + extra, scan->carryLength);
+        if (hit >= 0)
+        {
+            scan->match = (long long)offset - scan->carryLength + hit;
+            return false;
+        }
+    }
+
+    long long hit = PatternScan_Find(scan, data, length, length);
+    if (hit >= 0)
+    {
+        scan->match = (long long)offset + hit;
+        return false;
+    }
+
+    if (length >= (size_t)keep)
+    {
+        memCopy(scan->carry, data + length - keep, keep);
+        scan->carryLength = keep;
+    }
+    else
+    {
+        memCopy(scan->carry + scan->carryLength, data, length);
+        int total = scan->carryLength + (int)length;
+        int drop = total > keep ? total - keep : 0;
+        for (int i = drop; i < total; i++)
+            scan->carry[i - drop] = scan->carry[i];
+        scan->carryLength = total - drop;
+    }
+    return true;
+}
+
 void PatternSearch_findNext()
 {
     uint8_t pattern[128];
@@ -50,7 +121,7 @@ void PatternSearch_findNext()
     if (patLen <= 0)
         return;
 
-    long long fileSize = (long long)g_HexData.getFileSize();
+    long long fileSize = (long long)g_HexData->getFileSize();
     if (fileSize <= 0)
         return;
 
@@ -58,38 +129,35 @@ void PatternSearch_findNext()
                           ? g_PatternSearch.lastMatch + 1
                           : 0;
 
-    for (long long i = start; i <= fileSize - patLen; i++)
-    {
-        bool match = true;
-        for (int j = 0; j < patLen; j++)
-        {
-            if (g_HexData.getByte((size_t)(i + j)) != pattern[j])
-            {
-                match = false;
-                break;
-            }
-        }
+    PatternScan scan;
+    scan.pattern = pattern;
+    scan.patternLength = patLen;
+    scan.carryLength = 0;
+    scan.match = -1;
 
-        if (match)
-        {
-            g_PatternSearch.lastMatch = i;
+    if (start <= fileSize - patLen)
+        g_HexData->scanRange((uint64_t)start, (uint64_t)(fileSize - start), PatternScan_Chunk, &scan);
 
-            cursorBytePos = i;
-            cursorNibblePos = 0;
+    long long i = scan.match;
+    if (i >= 0)
+    {
+        g_PatternSearch.lastMatch = i;
 
-            long long line = i / 16;
-            if (line < g_ScrollY || line >= g_ScrollY + g_LinesPerPage)
-            {
-                g_ScrollY = (int)line;
+        cursorBytePos = i;
+        cursorNibblePos = 0;
+
+        long long line = i / 16;
+        if (line < g_ScrollY || line >= g_ScrollY + g_LinesPerPage)
+        {
+            g_ScrollY = (long long)line;
 
 #ifdef _WIN32
-                SetScrollPos(g_Hwnd, SB_VERT, g_ScrollY, TRUE);
+            SetScrollPos(g_Hwnd, SB_VERT, (int)g_ScrollY, TRUE);
 #endif
-            }
-
-            InvalidateWindow();
-            return;
         }
+
+        InvalidateWindow();
+        return;
     }
 
     g_PatternSearch.lastMatch = -1;
@@ -102,7 +170,7 @@ void PatternSearch_findPrev()
     if (patLen <= 0)
         return;
 
-    long long fileSize = (long long)g_HexData.getFileSize();
+    long long fileSize = (long long)g_HexData->getFileSize();
     if (fileSize <= 0)
         return;
 
@@ -115,7 +183,7 @@ void PatternSearch_findPrev()
         bool match = true;
         for (int j = 0; j < patLen; j++)
         {
-            if (g_HexData.getByte((size_t)(i + j)) != pattern[j])
+            if (g_HexData->getByte((size_t)(i + j)) != pattern[j])
             {
                 match = false;
                 break;
@@ -132,10 +200,10 @@ void PatternSearch_findPrev()
             long long line = i / 16;
             if (line < g_ScrollY || line >= g_ScrollY + g_LinesPerPage)
             {
-                g_ScrollY = (int)line;
+                g_ScrollY = (long long)line;
 
 #ifdef _WIN32
-                SetScrollPos(g_Hwnd, SB_VERT, g_ScrollY, TRUE);
+                SetScrollPos(g_Hwnd, SB_VERT, (int)g_ScrollY, TRUE);
 #endif
             }
 
@@ -247,9 +315,9 @@ void Bookmarks_Add(long long byteOffset, const char* name, Color color)
   bm.color = color;
   bm.description[0] = '\0';
 
-  if (byteOffset >= 0 && byteOffset < (long long)g_HexData.getFileSize())
+  if (byteOffset >= 0 && byteOffset < (long long)g_HexData->getFileSize())
   {
-    bm.byteValue = g_HexData.getByte((size_t)byteOffset);
+    bm.byteValue = g_HexData->getByte((size_t)byteOffset);
   }
   else
   {
@@ -257,6 +325,7 @@ void Bookmarks_Add(long long byteOffset, const char* name, Color color)
   }
 
   g_Bookmarks.bookmarks.push_back(bm);
+  Bookmarks_Invalidate();
   InvalidateWindow();
 }
 
@@ -265,6 +334,7 @@ void Bookmarks_Remove(int index)
     if (index >= 0 && index < (int)g_Bookmarks.bookmarks.size())
     {
         g_Bookmarks.bookmarks.remove(index);
+        Bookmarks_Invalidate();
 
         if (g_Bookmarks.selectedIndex == index)
         {
@@ -289,11 +359,11 @@ void Bookmarks_JumpTo(int index)
         long long line = cursorBytePos / 16;
         if (line < g_ScrollY || line >= g_ScrollY + g_LinesPerPage)
         {
-            g_ScrollY = (int)line;
+            g_ScrollY = (long long)line;
 
 #ifdef _WIN32
             extern HWND g_Hwnd;
-            SetScrollPos(g_Hwnd, SB_VERT, g_ScrollY, TRUE);
+            SetScrollPos(g_Hwnd, SB_VERT, (int)g_ScrollY, TRUE);
 #endif
         }
 
@@ -305,28 +375,101 @@ void Bookmarks_clear()
 {
     g_Bookmarks.bookmarks.clear();
     g_Bookmarks.selectedIndex = -1;
+    Bookmarks_Invalidate();
     InvalidateWindow();
 }
 
+void Bookmarks_ShiftOffsets(uint64_t offset, uint64_t removed, uint64_t inserted)
+{
+  for (size_t i = 0; i < g_Bookmarks.bookmarks.size(); i++)
+  {
+    Bookmark& bm = g_Bookmarks.bookmarks[i];
+    if (bm.byteOffset >= 0)
+      bm.byteOffset = (long long)shift_offset((uint64_t)bm.byteOffset, offset, removed, inserted);
+  }
+  Bookmarks_Invalidate();
+  Bookmarks_UpdateValues();
+}
+
 void Bookmarks_UpdateValues()
 {
   for (size_t i = 0; i < g_Bookmarks.bookmarks.size(); i++)
   {
     Bookmark& bm = g_Bookmarks.bookmarks[i];
-    if (bm.byteOffset >= 0 && bm.byteOffset < (long long)g_HexData.getFileSize())
+    if (bm.byteOffset >= 0 && bm.byteOffset < (long long)g_HexData->getFileSize())
     {
-      bm.byteValue = g_HexData.getByte((size_t)bm.byteOffset);
+      bm.byteValue = g_HexData->getByte((size_t)bm.byteOffset);
     }
   }
 }
 
+void Bookmarks_Invalidate()
+{
+  g_Bookmarks.indexDirty = true;
+}
+
+// Orders by offset, then by list position so equal offsets resolve to the
+// bookmark that was added first.
+static bool bookmark_before(int a, int b)
+{
+  long long offsetA = g_Bookmarks.bookmarks[a].byteOffset;
+  long long offsetB = g_Bookmarks.bookmarks[b].byteOffset;
+  return offsetA < offsetB || (offsetA == offsetB && a < b);
+}
+
+static void Bookmarks_RebuildIndex()
+{
+  int count = (int)g_Bookmarks.bookmarks.size();
+  g_Bookmarks.byOffset.clear();
+  for (int i = 0; i < count; i++)
+    g_Bookmarks.byOffset.push_back(i);
+
+  int* order = count > 0 ? &g_Bookmarks.byOffset[0] : nullptr;
+  for (int gap = count / 2; gap > 0; gap /= 2)
+  {
+    for (int i = gap; i < count; i++)
+    {
+      int value = order[i];
+      int j = i;
+      while (j >= gap && bookmark_before(value, order[j - gap]))
+      {
+        order[j] = order[j - gap];
+        j -= gap;
+      }
+      order[j] = value;
+    }
+  }
+  g_Bookmarks.indexDirty = false;
+}
+
+// Position in g_Bookmarks.byOffset of the first bookmark at or after byteOffset.
+int Bookmarks_LowerBound(long long byteOffset)
+{
+  if (g_Bookmarks.indexDirty || g_Bookmarks.byOffset.size() != g_Bookmarks.bookmarks.size())
+    Bookmarks_RebuildIndex();
+
+  int lo = 0;
+  int hi = (int)g_Bookmarks.byOffset.size();
+  while (lo < hi)
+  {
+    int mid = lo + (hi - lo) / 2;
+    if (g_Bookmarks.bookmarks[g_Bookmarks.byOffset[mid]].byteOffset < byteOffset)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
 int Bookmarks_findAtOffset(long long byteOffset)
 {
-    for (int i = 0; i < (int)g_Bookmarks.bookmarks.size(); i++)
+    int pos = Bookmarks_LowerBound(byteOffset);
+    if (pos < (int)g_Bookmarks.byOffset.size())
     {
-        if (g_Bookmarks.bookmarks[i].byteOffset == byteOffset)
+        int index = g_Bookmarks.byOffset[pos];
+        if (g_Bookmarks.bookmarks[index].byteOffset == byteOffset)
         {
-            return i;
+            return index;
         }
     }
     return -1;
@@ -334,14 +477,17 @@ int Bookmarks_findAtOffset(long long byteOffset)
 
 const Bookmark* Bookmarks_GetAtOffset(long long byteOffset)
 {
-  for (int i = 0; i < (int)g_Bookmarks.bookmarks.size(); i++)
-  {
-    if (g_Bookmarks.bookmarks[i].byteOffset == byteOffset)
-    {
-      return &g_Bookmarks.bookmarks[i];
-    }
-  }
-  return nullptr;
+  int index = Bookmarks_findAtOffset(byteOffset);
+  return index >= 0 ? &g_Bookmarks.bookmarks[index] : nullptr;
+}
+
+static bool ByteStats_AddChunk(void* context, uint64_t offset, const uint8_t* data, size_t length)
+{
+    (void)offset;
+    int* histogram = (int*)context;
+    for (size_t i = 0; i < length; i++)
+        histogram[data[i]]++;
+    return true;
 }
 
 void ByteStats_Compute(HexData &hexData)
@@ -355,10 +501,10 @@ void ByteStats_Compute(HexData &hexData)
         return;
     }
 
-    for (uint64_t i = 0; i < fileSize; i++)
+    if (!hexData.scanRange(0, fileSize, ByteStats_AddChunk, g_ByteStats.histogram))
     {
-        uint8_t b = hexData.getByte((size_t)i);
-        g_ByteStats.histogram[b]++;
+        g_ByteStats.computed = false;
+        return;
     }
 
     g_ByteStats.mostCommonCount = 0;
@@ -383,15 +529,16 @@ void ByteStats_Compute(HexData &hexData)
 
     g_ByteStats.nullByteCount = g_ByteStats.histogram[0];
 
-    int distinct = 0;
+    double entropy = 0.0;
     for (int i = 0; i < 256; i++)
     {
         if (g_ByteStats.histogram[i] > 0)
-            distinct++;
+        {
+            double p = (double)g_ByteStats.histogram[i] / (double)fileSize;
+            entropy -= p * fast_log2(p);
+        }
     }
 
-    double entropy = (double)distinct * (8.0 / 256.0);
-
     g_ByteStats.entropy = entropy;
 
     g_ByteStats.computed = true;
@@ -415,7 +562,7 @@ Rect GetDIEButtonRect(const Rect& panelBounds)
   int itemSpacing = 4;
   int sectionSpacing = 10;
 
-  long long fileSize = (long long)g_HexData.getFileSize();
+  long long fileSize = (long long)g_HexData->getFileSize();
 
   currentY += headerHeight + sectionSpacing;
   currentY += rowHeight + itemSpacing;
@@ -475,7 +622,7 @@ Rect GetPluginAnnotationRect(int annotationIndex, const Rect& panelBounds)
   int itemSpacing = 4;
   int sectionSpacing = 10;
 
-  long long fileSize = (long long)g_HexData.getFileSize();
+  long long fileSize = (long long)g_HexData->getFileSize();
 
   currentY += headerHeight + sectionSpacing;
   currentY += (rowHeight + itemSpacing) * 2;
@@ -542,7 +689,7 @@ Rect GetPluginAnnotationRect(int annotationIndex, const Rect& panelBounds)
 
   currentY += headerHeight + sectionSpacing;
 
-  PluginBookmarkArray* pluginAnnotations = g_HexData.getPluginAnnotations();
+  PluginBookmarkArray* pluginAnnotations = g_HexData->getPluginAnnotations();
 
   for (int i = 0; i < annotationIndex && i < (int)pluginAnnotations->count; i++)
   {
@@ -572,7 +719,7 @@ Rect GetBookmarkRect(int bookmarkIndex, const Rect& panelBounds)
   currentY += 8;
 
   currentY += headerHeight + sectionSpacing;
-  if (cursorBytePos >= 0 && cursorBytePos < (long long)g_HexData.getFileSize())
+  if (cursorBytePos >= 0 && cursorBytePos < (long long)g_HexData->getFileSize())
   {
     currentY += (rowHeight + itemSpacing) * 5;
     currentY += 8;
@@ -621,7 +768,7 @@ static void DIEAnalyzeWorker()
 
 void DIE_Analyze()
 {
-  if (g_HexData.getFileSize() == 0 || g_CurrentFilePath[0] == '\0')
+  if (g_HexData->getFileSize() == 0 || g_CurrentFilePath[0] == '\0')
     return;
 
 #ifdef _WIN32
@@ -944,7 +1091,7 @@ bool HandleLeftPanelContentClick(int x, int y, int windowWidth, int windowHeight
   int itemSpacing = 4;
   int sectionSpacing = 10;
 
-  long long fileSize = (long long)g_HexData.getFileSize();
+  long long fileSize = (long long)g_HexData->getFileSize();
 
   currentY += headerHeight + sectionSpacing;
   currentY += (rowHeight + itemSpacing) * 2;
@@ -995,53 +1142,7 @@ bool HandleLeftPanelContentClick(int x, int y, int windowWidth, int windowHeight
     if (x >= computeRect.x && x <= computeRect.x + computeRect.width &&
       y >= computeRect.y && y <= computeRect.y + computeRect.height)
     {
-      g_ByteStats.computed = true;
-
-      for (int i = 0; i < 256; i++)
-        g_ByteStats.histogram[i] = 0;
-
-      for (size_t i = 0; i < g_HexData.getFileSize(); i++)
-      {
-        uint8_t byte = g_HexData.getByte(i);
-        g_ByteStats.histogram[byte]++;
-      }
-
-      g_ByteStats.mostCommonByte = 0;
-      g_ByteStats.mostCommonCount = g_ByteStats.histogram[0];
-      g_ByteStats.leastCommonByte = 0;
-      g_ByteStats.leastCommonCount = g_ByteStats.histogram[0];
-
-      for (int i = 1; i < 256; i++)
-      {
-        if (g_ByteStats.histogram[i] > g_ByteStats.mostCommonCount)
-        {
-          g_ByteStats.mostCommonByte = (uint8_t)i;
-          g_ByteStats.mostCommonCount = g_ByteStats.histogram[i];
-        }
-        if (g_ByteStats.histogram[i] < g_ByteStats.leastCommonCount)
-        {
-          g_ByteStats.leastCommonByte = (uint8_t)i;
-          g_ByteStats.leastCommonCount = g_ByteStats.histogram[i];
-        }
-      }
-
-      g_ByteStats.nullByteCount = g_ByteStats.histogram[0];
-
-      g_ByteStats.entropy = 0.0;
-      long long total = (long long)g_HexData.getFileSize();
-
-      if (total > 0)
-      {
-        for (int i = 0; i < 256; i++)
-        {
-          if (g_ByteStats.histogram[i] > 0)
-          {
-            double p = (double)g_ByteStats.histogram[i] / (double)total;
-            g_ByteStats.entropy -= p * fast_log2(p);
-          }
-        }
-      }
-
+      ByteStats_Compute(*g_HexData);
       return true;
     }
 
@@ -1074,7 +1175,7 @@ bool HandleLeftPanelContentClick(int x, int y, int windowWidth, int windowHeight
 
   currentY += headerHeight + sectionSpacing;
 
-  PluginBookmarkArray* pluginAnnotations = g_HexData.getPluginAnnotations();
+  PluginBookmarkArray* pluginAnnotations = g_HexData->getPluginAnnotations();
 
   if (pluginAnnotations && pluginAnnotations->count > 0)
   {
@@ -1094,10 +1195,10 @@ bool HandleLeftPanelContentClick(int x, int y, int windowWidth, int windowHeight
         long long line = cursorBytePos / 16;
         if (line < g_ScrollY || line >= g_ScrollY + g_LinesPerPage)
         {
-          g_ScrollY = (int)line;
+          g_ScrollY = (long long)line;
 
 #ifdef _WIN32
-          SetScrollPos(g_Hwnd, SB_VERT, g_ScrollY, TRUE);
+          SetScrollPos(g_Hwnd, SB_VERT, (int)g_ScrollY, TRUE);
 #endif
         }
 
@@ -0,0 +1,797 @@
+#include "piecetable.h"
+
+static void advancePiece(Piece& piece, uint64_t n)
+{
+  if (piece.source == PIECE_FILL)
+    piece.phase = (uint32_t)((piece.phase + n) % piece.patternLength);
+  else
+    piece.start += n;
+  piece.length -= n;
+}
+
+static void fillPattern(uint8_t* out, uint64_t len, const uint8_t* pattern, uint32_t patternLength, uint32_t phase)
+{
+  if (patternLength == 1)
+  {
+    memSet(out, pattern[0], (size_t)len);
+    return;
+  }
+
+  uint64_t head = len < patternLength ? len : patternLength;
+  for (uint64_t i = 0; i < head; i++)
+    out[i] = pattern[(phase + i) % patternLength];
+
+  if (len <= patternLength)
+    return;
+
+  if (8 % patternLength == 0)
+  {
+    uint64_t word;
+    for (int i = 0; i < 8; i++)
+      ((uint8_t*)&word)[i] = out[i % patternLength];
+
+    uint64_t i = 0;
+    for (; i + 8 <= len; i += 8)
+      memCopy(out + i, &word, 8);
+    for (; i < len; i++)
+      out[i] = out[i % patternLength];
+    return;
+  }
+
+  uint64_t filled = patternLength;
+  while (filled < len)
+  {
+    uint64_t chunk = filled < len - filled ? filled : len - filled;
+    memCopy(out + filled, out, (size_t)chunk);
+    filled += chunk;
+  }
+}
+
+PieceTable::PieceTable()
+  : original(nullptr),
+  originalRead(nullptr),
+  originalContext(nullptr),
+  originalSize(0),
+  nodes(nullptr),
+  nodeCapacity(0),
+  nodeCount(0),
+  freeList(-1),
+  liveNodes(0),
+  root(-1),
+  seed(0x9E3779B9u)
+{
+  bb_init(&addBuffer);
+}
+
+PieceTable::~PieceTable()
+{
+  clear();
+}
+
+void PieceTable::clear()
+{
+  if (nodes)
+    sysFree(nodes);
+  nodes = nullptr;
+  nodeCapacity = 0;
+  nodeCount = 0;
+  freeList = -1;
+  liveNodes = 0;
+  root = -1;
+  original = nullptr;
+  originalRead = nullptr;
+  originalContext = nullptr;
+  originalSize = 0;
+  bb_free(&addBuffer);
+}
+
+static uint64_t read_mapping(const void* context, uint64_t offset, uint8_t* out, uint64_t length)
+{
+  return fm_read((const FileMapping*)context, offset, out, length);
+}
+
+void PieceTable::setOriginalMapping(const FileMapping* mapping)
+{
+  original = mapping->data;
+  originalRead = read_mapping;
+  originalContext = mapping;
+}
+
+void PieceTable::reset(const uint8_t* data, uint64_t size)
+{
+  clear();
+  original = data;
+  originalSize = size;
+
+  if (size > 0)
+  {
+    Piece piece;
+    piece.source = PIECE_ORIGINAL;
+    piece.start = 0;
+    piece.length = size;
+    piece.patternLength = 0;
+    piece.phase = 0;
+    root = allocNode(piece);
+  }
+}
+
+bool PieceTable::resetExtents(const uint8_t* data, uint64_t size, const Vector<ByteExtent>& dataExtents)
+{
+  clear();
+  original = data;
+  originalSize = size;
+
+  Piece piece;
+  piece.patternLength = 0;
+  piece.phase = 0;
+
+  uint64_t pos = 0;
+  for (size_t i = 0; i <= dataExtents.size() && pos < size; i++)
+  {
+    uint64_t dataStart = i < dataExtents.size() ? dataExtents[i].offset : size;
+    uint64_t dataEnd = i < dataExtents.size() ? dataExtents[i].offset + dataExtents[i].length : size;
+    if (dataStart > size)
+      dataStart = size;
+    if (dataEnd > size)
+      dataEnd = size;
+    if (dataStart < pos)
+      dataStart = pos;
+
+    for (int kind = 0; kind < 2; kind++)
+    {
+      uint64_t end = kind == 0 ? dataStart : dataEnd;
+      if (end <= pos)
+        continue;
+
+      piece.source = kind == 0 ? PIECE_ZERO : PIECE_ORIGINAL;
+      piece.start = pos;
+      piece.length = end - pos;
+
+      int node = allocNode(piece);
+      if (node < 0)
+        return false;
+      root = merge(root, node);
+      pos = end;
+    }
+  }
+  return true;
+}
+
+bool PieceTable::isPristine() const
+{
+  if (root < 0)
+    return originalSize == 0;
+  if (length() != originalSize)
+    return false;
+
+  const PieceNode& n = nodes[root];
+  if (n.left < 0 && n.right < 0)
+    return n.piece.source == PIECE_ORIGINAL && n.piece.start == 0;
+
+  Vector<ByteExtent> dirty;
+  dirtyTree(root, 0, dirty);
+  return dirty.empty();
+}
+
+uint32_t PieceTable::nextPriority()
+{
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+bool PieceTable::reserveNodes(int extra)
+{
+  if (nodeCount + extra <= nodeCapacity)
+    return true;
+
+  int newCapacity = nodeCapacity ? nodeCapacity : 64;
+  while (newCapacity < nodeCount + extra)
+    newCapacity *= 2;
+
+  PieceNode* newNodes = (PieceNode*)sysRealloc(nodes, sizeof(PieceNode) * (size_t)newCapacity);
+  if (!newNodes)
+    return false;
+  nodes = newNodes;
+  nodeCapacity = newCapacity;
+  return true;
+}
+
+int PieceTable::allocNode(const Piece& piece)
+{
+  int index;
+  if (freeList >= 0)
+  {
+    index = freeList;
+    freeList = nodes[index].left;
+  }
+  else
+  {
+    if (!reserveNodes(1))
+      return -1;
+    index = nodeCount++;
+  }
+
+  PieceNode& n = nodes[index];
+  n.piece = piece;
+  n.subtreeLength = piece.length;
+  n.priority = nextPriority();
+  n.left = -1;
+  n.right = -1;
+  liveNodes++;
+  return index;
+}
+
+void PieceTable::releaseTree(int t)
+{
+  if (t < 0)
+    return;
+  releaseTree(nodes[t].left);
+  releaseTree(nodes[t].right);
+  nodes[t].left = freeList;
+  freeList = t;
+  liveNodes--;
+}
+
+void PieceTable::update(int t)
+{
+  PieceNode& n = nodes[t];
+  n.subtreeLength = lengthOf(n.left) + n.piece.length + lengthOf(n.right);
+}
+
+void PieceTable::split(int t, uint64_t pos, int& outLeft, int& outRight)
+{
+  if (t < 0)
+  {
+    outLeft = -1;
+    outRight = -1;
+    return;
+  }
+
+  uint64_t leftLength = lengthOf(nodes[t].left);
+  uint64_t pieceLength = nodes[t].piece.length;
+
+  if (pos <= leftLength)
+  {
+    int l, r;
+    split(nodes[t].left, pos, l, r);
+    nodes[t].left = r;
+    update(t);
+    outLeft = l;
+    outRight = t;
+  }
+  else if (pos >= leftLength + pieceLength)
+  {
+    int l, r;
+    split(nodes[t].right, pos - leftLength - pieceLength, l, r);
+    nodes[t].right = l;
+    update(t);
+    outLeft = t;
+    outRight = r;
+  }
+  else
+  {
+    uint64_t cut = pos - leftLength;
+
+    Piece tail = nodes[t].piece;
+    advancePiece(tail, cut);
+
+    int m = allocNode(tail);
+    if (m < 0)
+    {
+      outLeft = t;
+      outRight = -1;
+      return;
+    }
+
+    nodes[m].priority = nodes[t].priority;
+    nodes[m].right = nodes[t].right;
+    nodes[t].right = -1;
+    nodes[t].piece.length = cut;
+    update(t);
+    update(m);
+
+    outLeft = t;
+    outRight = m;
+  }
+}
+
+int PieceTable::merge(int a, int b)
+{
+  if (a < 0)
+    return b;
+  if (b < 0)
+    return a;
+
+  if (nodes[a].priority >= nodes[b].priority)
+  {
+    nodes[a].right = merge(nodes[a].right, b);
+    update(a);
+    return a;
+  }
+
+  nodes[b].left = merge(a, nodes[b].left);
+  update(b);
+  return b;
+}
+
+bool PieceTable::extendRightmost(int t, const Piece& piece)
+{
+  if (t < 0)
+    return false;
+
+  if (nodes[t].right >= 0)
+  {
+    if (!extendRightmost(nodes[t].right, piece))
+      return false;
+    update(t);
+    return true;
+  }
+
+  Piece& last = nodes[t].piece;
+  if ((piece.source != PIECE_ADD && piece.source != PIECE_ORIGINAL) ||
+    last.source != piece.source || last.start + last.length != piece.start)
+    return false;
+
+  last.length += piece.length;
+  update(t);
+  return true;
+}
+
+const uint8_t* PieceTable::sourceData(const Piece& piece) const
+{
+  if (piece.source == PIECE_ZERO)
+    return nullptr;
+  if (piece.source == PIECE_ADD || piece.source == PIECE_FILL)
+    return addBuffer.data + piece.start;
+  return original ? original + piece.start : nullptr;
+}
+
+void PieceTable::copyOut(const Piece& piece, uint64_t offset, uint8_t* out, uint64_t len) const
+{
+  if (piece.source == PIECE_ZERO)
+  {
+    memSet(out, 0, (size_t)len);
+    return;
+  }
+
+  if (piece.source == PIECE_FILL)
+  {
+    uint32_t phase = (uint32_t)((piece.phase + offset) % piece.patternLength);
+    fillPattern(out, len, sourceData(piece), piece.patternLength, phase);
+    return;
+  }
+
+  if (piece.source == PIECE_ORIGINAL && originalRead)
+  {
+    originalRead(originalContext, piece.start + offset, out, len);
+    return;
+  }
+
+  memCopy(out, sourceData(piece) + offset, (size_t)len);
+}
+
+bool PieceTable::collect(uint64_t pos, uint64_t len, Vector<Piece>& out) const
+{
+  uint64_t total = length();
+  if (pos > total)
+    return false;
+  if (len > total - pos)
+    len = total - pos;
+
+  uint64_t done = 0;
+  while (done < len)
+  {
+    Piece piece;
+    uint64_t offset;
+    if (!locate(pos + done, &piece, &offset))
+      return false;
+
+    advancePiece(piece, offset);
+    if (piece.length > len - done)
+      piece.length = len - done;
+
+    out.push_back(piece);
+    done += piece.length;
+  }
+  return true;
+}
+
+bool PieceTable::findDataStart(uint64_t pos, bool forward, uint64_t* outPos) const
+{
+  Vector<Piece> all;
+  if (!collect(0, length(), all))
+    return false;
+
+  bool found = false;
+  bool previousZero = true;
+  uint64_t at = 0;
+  for (size_t i = 0; i < all.size(); i++)
+  {
+    bool zero = all[i].source == PIECE_ZERO;
+    if (!zero && previousZero)
+    {
+      if (forward && at > pos)
+      {
+        *outPos = at;
+        return true;
+      }
+      if (!forward && at < pos)
+      {
+        *outPos = at;
+        found = true;
+      }
+    }
+    previousZero = zero;
+    at += all[i].length;
+  }
+  return found;
+}
+
+bool PieceTable::locate(uint64_t pos, Piece* outPiece, uint64_t* outOffsetInPiece) const
+{
+  int t = root;
+  while (t >= 0)
+  {
+    const PieceNode& n = nodes[t];
+    uint64_t leftLength = lengthOf(n.left);
+
+    if (pos < leftLength)
+    {
+      t = n.left;
+      continue;
+    }
+
+    pos -= leftLength;
+    if (pos < n.piece.length)
+    {
+      *outPiece = n.piece;
+      *outOffsetInPiece = pos;
+      return true;
+    }
+
+    pos -= n.piece.length;
+    t = n.right;
+  }
+  return false;
+}
+
+uint8_t PieceTable::byteAt(uint64_t pos) const
+{
+  Piece piece;
+  uint64_t offset;
+  if (!locate(pos, &piece, &offset) || piece.source == PIECE_ZERO)
+    return 0;
+  if (piece.source == PIECE_FILL)
+    return sourceData(piece)[(piece.phase + offset) % piece.patternLength];
+
+  uint8_t value;
+  copyOut(piece, offset, &value, 1);
+  return value;
+}
+
+uint64_t PieceTable::read(uint64_t pos, uint8_t* out, uint64_t len) const
+{
+  uint64_t total = length();
+  if (pos >= total)
+    return 0;
+  if (len > total - pos)
+    len = total - pos;
+
+  uint64_t done = 0;
+  while (done < len)
+  {
+    Piece piece;
+    uint64_t offset;
+    if (!locate(pos + done, &piece, &offset))
+      break;
+
+    uint64_t chunk = piece.length - offset;
+    if (chunk > len - done)
+      chunk = len - done;
+
+    copyOut(piece, offset, out + done, chunk);
+    done += chunk;
+  }
+  return done;
+}
+
+bool PieceTable::replacePieces(uint64_t pos, uint64_t removeLength, const Piece* inserted, int count)
+{
+  uint64_t total = length();
+  if (pos > total)
+    return false;
+  if (removeLength > total - pos)
+    removeLength = total - pos;
+
+  if (!reserveNodes(count + 2))
+    return false;
+
+  int left, middle, right;
+  split(root, pos, left, right);
+  split(right, removeLength, middle, right);
+  releaseTree(middle);
+
+  for (int i = 0; i < count; i++)
+  {
+    if (inserted[i].length == 0)
+      continue;
+    if (i == 0 && extendRightmost(left, inserted[i]))
+      continue;
+    left = merge(left, allocNode(inserted[i]));
+  }
+
+  root = merge(left, right);
+  return true;
+}
+
+bool PieceTable::replace(uint64_t pos, uint64_t removeLength, const uint8_t* data, uint64_t dataLength)
+{
+  if (pos > length())
+    return false;
+
+  Piece inserted;
+  inserted.source = PIECE_ADD;
+  inserted.start = addBuffer.size;
+  inserted.length = dataLength;
+  inserted.patternLength = 0;
+  inserted.phase = 0;
+
+  if (dataLength > 0)
+  {
+    if (!bb_resize(&addBuffer, addBuffer.size + (size_t)dataLength))
+      return false;
+    memCopy(addBuffer.data + inserted.start, data, (size_t)dataLength);
+  }
+
+  return replacePieces(pos, removeLength, &inserted, dataLength > 0 ? 1 : 0);
+}
+
+bool PieceTable::fill(uint64_t pos, uint64_t removeLength, uint64_t fillLength, const uint8_t* pattern, uint32_t patternLength)
+{
+  if (pos > length() || (fillLength > 0 && patternLength == 0))
+    return false;
+
+  if (fillLength <= patternLength)
+    return replace(pos, removeLength, pattern, fillLength);
+
+  Piece inserted;
+  inserted.source = PIECE_FILL;
+  inserted.start = addBuffer.size;
+  inserted.length = fillLength;
+  inserted.patternLength = patternLength;
+  inserted.phase = 0;
+
+  if (!bb_resize(&addBuffer, addBuffer.size + patternLength))
+    return false;
+  memCopy(addBuffer.data + inserted.start, pattern, patternLength);
+
+  return replacePieces(pos, removeLength, &inserted, 1);
+}
+
+bool PieceTable::copy(uint64_t srcPos, uint64_t copyLength, uint64_t dstPos, uint64_t removeLength)
+{
+  Vector<Piece> source;
+  if (!collect(srcPos, copyLength, source))
+    return false;
+
+  return replacePieces(dstPos, removeLength, source.empty() ? nullptr : &source[0], (int)source.size());
+}
+
+void PieceTable::dirtyTree(int t, uint64_t base, Vector<ByteExtent>& out) const
+{
+  if (t < 0)
+    return;
+
+  const PieceNode& n = nodes[t];
+  dirtyTree(n.left, base, out);
+
+  uint64_t pos = base + lengthOf(n.left);
+  bool identity = (n.piece.source == PIECE_ORIGINAL || n.piece.source == PIECE_ZERO) &&
+    n.piece.start == pos;
+  if (!identity)
+  {
+    if (!out.empty() && out[out.size() - 1].offset + out[out.size() - 1].length == pos)
+    {
+      out[out.size() - 1].length += n.piece.length;
+    }
+    else
+    {
+      ByteExtent extent;
+      extent.offset = pos;
+      extent.length = n.piece.length;
+      out.push_back(extent);
+    }
+  }
+
+  dirtyTree(n.right, pos + n.piece.length, out);
+}
+
+void PieceTable::dirtyExtents(Vector<ByteExtent>& out) const
+{
+  out.clear();
+  dirtyTree(root, 0, out);
+}
+
+bool PieceTable::overlapsOriginal(const Piece& piece, const Vector<ByteExtent>& extents) const
+{
+  if (piece.source != PIECE_ORIGINAL || piece.length == 0 || extents.empty())
+    return false;
+
+  size_t lo = 0;
+  size_t hi = extents.size();
+  while (lo < hi)
+  {
+    size_t mid = lo + (hi - lo) / 2;
+    if (extents[mid].offset + extents[mid].length <= piece.start)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo < extents.size() && extents[lo].offset < piece.start + piece.length;
+}
+
+bool PieceTable::detachPiece(Piece& piece)
+{
+  uint64_t start = addBuffer.size;
+  if (!bb_resize(&addBuffer, addBuffer.size + (size_t)piece.length))
+    return false;
+
+  copyOut(piece, 0, addBuffer.data + start, piece.length);
+  piece.source = PIECE_ADD;
+  piece.start = start;
+  return true;
+}
+
+uint64_t PieceTable::detachCostTree(int t, const Vector<ByteExtent>& extents) const
+{
+  if (t < 0)
+    return 0;
+
+  const PieceNode& n = nodes[t];
+  uint64_t cost = overlapsOriginal(n.piece, extents) ? n.piece.length : 0;
+  return cost + detachCostTree(n.left, extents) + detachCostTree(n.right, extents);
+}
+
+uint64_t PieceTable::detachCost(const Vector<ByteExtent>& extents) const
+{
+  return detachCostTree(root, extents);
+}
+
+bool PieceTable::detachTree(int t, const Vector<ByteExtent>& extents)
+{
+  if (t < 0)
+    return true;
+
+  PieceNode& n = nodes[t];
+  if (overlapsOriginal(n.piece, extents) && !detachPiece(n.piece))
+    return false;
+
+  return detachTree(n.left, extents) && detachTree(n.right, extents);
+}
+
+bool PieceTable::detachOriginal(const Vector<ByteExtent>& extents)
+{
+  return detachTree(root, extents);
+}
+
+struct AddRange
+{
+  uint64_t offset;
+  uint64_t length;
+  uint64_t moved;
+};
+
+static void sort_ranges(Vector<AddRange>& ranges)
+{
+  int count = (int)ranges.size();
+  for (int gap = count / 2; gap > 0; gap /= 2)
+  {
+    for (int i = gap; i < count; i++)
+    {
+      AddRange value = ranges[i];
+      int j = i;
+      while (j >= gap && ranges[j - gap].offset > value.offset)
+      {
+        ranges[j] = ranges[j - gap];
+        j -= gap;
+      }
+      ranges[j] = value;
+    }
+  }
+}
+
+// After a save the file holds every byte, so the tree collapses to one
+// ORIGINAL piece and the add buffer keeps only what the retained pieces (the
+// undo journal's) still reference; their starts are moved to match.
+void PieceTable::rebase(Piece* retained, size_t count)
+{
+  uint64_t total = length();
+  releaseTree(root);
+  root = -1;
+  originalSize = total;
+
+  if (total > 0)
+  {
+    Piece piece;
+    piece.source = PIECE_ORIGINAL;
+    piece.start = 0;
+    piece.length = total;
+    piece.patternLength = 0;
+    piece.phase = 0;
+    root = allocNode(piece);
+  }
+
+  Vector<AddRange> ranges;
+  for (size_t i = 0; i < count; i++)
+  {
+    const Piece& p = retained[i];
+    if (p.source != PIECE_ADD && p.source != PIECE_FILL)
+      continue;
+    AddRange range;
+    range.offset = p.start;
+    range.length = p.source == PIECE_FILL ? p.patternLength : p.length;
+    range.moved = 0;
+    ranges.push_back(range);
+  }
+
+  if (ranges.empty())
+  {
+    bb_free(&addBuffer);
+    return;
+  }
+
+  sort_ranges(ranges);
+  size_t merged = 0;
+  uint64_t kept = 0;
+  for (size_t i = 0; i < ranges.size(); i++)
+  {
+    AddRange& last = ranges[merged > 0 ? merged - 1 : 0];
+    if (merged > 0 && ranges[i].offset <= last.offset + last.length)
+    {
+      uint64_t end = ranges[i].offset + ranges[i].length;
+      if (end > last.offset + last.length)
+      {
+        kept += end - (last.offset + last.length);
+        last.length = end - last.offset;
+      }
+      continue;
+    }
+    ranges[merged] = ranges[i];
+    ranges[merged].moved = kept;
+    kept += ranges[i].length;
+    merged++;
+  }
+
+  ByteBuffer compact;
+  bb_init(&compact);
+  if (!bb_resize(&compact, (size_t)kept))
+    return;
+
+  for (size_t i = 0; i < merged; i++)
+    memCopy(compact.data + ranges[i].moved, addBuffer.data + ranges[i].offset, (size_t)ranges[i].length);
+
+  for (size_t i = 0; i < count; i++)
+  {
+    Piece& p = retained[i];
+    if (p.source != PIECE_ADD && p.source != PIECE_FILL)
+      continue;
+
+    size_t lo = 0;
+    size_t hi = merged;
+    while (hi - lo > 1)
+    {
+      size_t mid = lo + (hi - lo) / 2;
+      if (ranges[mid].offset <= p.start)
+        lo = mid;
+      else
+        hi = mid;
+    }
+    p.start = ranges[lo].moved + (p.start - ranges[lo].offset);
+  }
+
+  bb_free(&addBuffer);
+  addBuffer = compact;
+}
@@ -18,11 +18,12 @@ static ULONG_PTR g_gdiplusToken = 0;
 #include "platform_die.h"
 
 extern AppOptions g_Options;
-extern HexData g_HexData;
+extern HexData* g_HexData;
 extern BookmarksState g_Bookmarks;
 extern ByteStatistics g_ByteStats;
 extern DetectItEasyState g_DIEState;
 extern LeftPanelState g_LeftPanel;
+extern Minimap g_Minimap;
 void InvalidateWindow();
 
 char buf[256];
@@ -32,6 +33,13 @@ extern long long cursorBytePos;
 int fontSize = g_Options.fontSize;
 const int PANEL_TITLE_HEIGHT = 28;
 
+#if !defined(_WIN32) && !defined(__APPLE__)
+static inline uint32_t to_argb(const Color& color)
+{
+  return ((uint32_t)color.a << 24) | ((uint32_t)color.r << 16) | ((uint32_t)color.g << 8) | color.b;
+}
+#endif
+
 RenderManager::RenderManager()
     : window(NATIVE_WINDOW_NULL),
   _disasmColumnWidth(300),
@@ -45,10 +53,17 @@ RenderManager::RenderManager()
       context(nullptr), backBuffer(nullptr)
 #else
       ,
-      display(nullptr), gc(nullptr), backBuffer(0), fontInfo(nullptr)
+      display(nullptr), gc(nullptr), fontInfo(nullptr)
 #endif
 {
   currentTheme = Theme::Dark();
+  damage.count = 0;
+  clipping = false;
+  drawCalls = 0;
+#if !defined(_WIN32) && !defined(__APPLE__)
+  xc_init(&canvas);
+  ga_init(&atlas);
+#endif
 }
 
 RenderManager::~RenderManager()
@@ -104,6 +119,7 @@ bool RenderManager::initialize(NativeWindow win)
   if (fontInfo)
   {
     XSetFont(display, gc, fontInfo->fid);
+    ga_build(&atlas, display, x11Window, fontInfo);
   }
 
   return true;
@@ -147,11 +163,8 @@ void RenderManager::cleanup()
   }
 
 #else
-  if (backBuffer)
-  {
-    XFreePixmap(display, backBuffer);
-    backBuffer = 0;
-  }
+  xc_free(&canvas);
+  ga_free(&atlas);
 
   if (fontInfo)
   {
@@ -191,6 +204,7 @@ void RenderManager::resize(int width, int height)
 
   windowWidth = width;
   windowHeight = height;
+  invalidateAll();
 
 #ifdef _WIN32
   if (memBitmap)
@@ -218,13 +232,7 @@ void RenderManager::resize(int width, int height)
   backBuffer = platformAlloc(width * height * 4);
 
 #else
-  if (backBuffer)
-  {
-    XFreePixmap(display, backBuffer);
-  }
-  Window x11Window = (Window)(uintptr_t)this->window;
-  backBuffer = XCreatePixmap(display, x11Window, width, height,
-                             DefaultDepth(display, DefaultScreen(display)));
+  xc_resize(&canvas, display, width, height);
 
 #endif
 }
@@ -267,7 +275,8 @@ void RenderManager::UpdateHexMetrics(int leftPanelWidth, int menuBarHeight)
   _charWidth = (int)layout.charWidth;
   _charHeight = (int)layout.lineHeight;
 
-  _hexAreaX = leftPanelWidth + (int)(layout.margin + (10 * layout.charWidth));
+  extern HexData* g_HexData;
+  _hexAreaX = leftPanelWidth + (int)(layout.margin + ((g_HexData->getOffsetDigits() + 2) * layout.charWidth));
   _hexAreaY = menuBarHeight + (int)(layout.margin + layout.headerHeight + 2);
 }
 
@@ -348,11 +357,124 @@ void RenderManager::endFrame(NativeDrawContext ctx)
 
   Window x11Window = (Window)(uintptr_t)window;
 
-  XCopyArea(display, backBuffer, x11Window, gc,
-            0, 0, windowWidth, windowHeight, 0, 0);
+  if (damage.count == 0)
+  {
+    xc_present(&canvas, x11Window, gc);
+  }
+  for (int i = 0; i < damage.count; i++)
+  {
+    const Rect& r = damage.rects[i];
+    xc_present_rect(&canvas, x11Window, gc, r.x, r.y, r.width, r.height);
+  }
 
-  XFlush(display);
+  xc_finish(&canvas);
 #endif
+  damage.count = 0;
+}
+
+static bool rects_overlap(const Rect& a, const Rect& b)
+{
+  return a.x < b.x + b.width && b.x < a.x + a.width &&
+         a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+static Rect rect_union(const Rect& a, const Rect& b)
+{
+  int left = a.x < b.x ? a.x : b.x;
+  int top = a.y < b.y ? a.y : b.y;
+  int right = a.x + a.width > b.x + b.width ? a.x + a.width : b.x + b.width;
+  int bottom = a.y + a.height > b.y + b.height ? a.y + a.height : b.y + b.height;
+  return Rect(left, top, right - left, bottom - top);
+}
+
+static long long rect_area(const Rect& r)
+{
+  return (long long)r.width * r.height;
+}
+
+// Overlapping rectangles are merged so every pixel is painted and presented
+// once; when the list is full the pair whose union grows least is folded.
+void RenderManager::invalidate(const Rect& rect)
+{
+  int left = rect.x < 0 ? 0 : rect.x;
+  int top = rect.y < 0 ? 0 : rect.y;
+  int right = rect.x + rect.width > windowWidth ? windowWidth : rect.x + rect.width;
+  int bottom = rect.y + rect.height > windowHeight ? windowHeight : rect.y + rect.height;
+  if (left >= right || top >= bottom)
+    return;
+
+  Rect added(left, top, right - left, bottom - top);
+  for (int i = 0; i < damage.count;)
+  {
+    if (rects_overlap(damage.rects[i], added))
+    {
+      added = rect_union(damage.rects[i], added);
+      damage.rects[i] = damage.rects[--damage.count];
+      i = 0;
+      continue;
+    }
+    i++;
+  }
+
+  if (damage.count == MAX_DAMAGE_RECTS)
+  {
+    int best = 0;
+    long long bestGrowth = -1;
+    for (int i = 0; i < damage.count; i++)
+    {
+      Rect merged = rect_union(damage.rects[i], added);
+      long long growth = rect_area(merged) - rect_area(damage.rects[i]) - rect_area(added);
+      if (bestGrowth < 0 || growth < bestGrowth)
+      {
+        best = i;
+        bestGrowth = growth;
+      }
+    }
+    Rect merged = rect_union(damage.rects[best], added);
+    damage.rects[best] = damage.rects[--damage.count];
+    invalidate(merged);
+    return;
+  }
+
+  damage.rects[damage.count++] = added;
+}
+
+void RenderManager::invalidateAll()
+{
+  damage.count = 0;
+  invalidate(Rect(0, 0, windowWidth, windowHeight));
+}
+
+bool RenderManager::isDamaged(const Rect& rect) const
+{
+  for (int i = 0; i < damage.count; i++)
+  {
+    if (rects_overlap(damage.rects[i], rect))
+      return true;
+  }
+  return false;
+}
+
+void RenderManager::setClip(const Rect& rect)
+{
+  clipRect = rect;
+  clipping = true;
+#if !defined(_WIN32) && !defined(__APPLE__)
+  xc_set_clip(&canvas, rect.x, rect.y, rect.width, rect.height);
+#endif
+}
+
+void RenderManager::resetClip()
+{
+  clipping = false;
+#if !defined(_WIN32) && !defined(__APPLE__)
+  xc_reset_clip(&canvas);
+#endif
+}
+
+bool RenderManager::isClipped(const Rect& rect) const
+{
+  return clipping && !rects_overlap(clipRect, rect);
 }
 
 void RenderManager::clear(const Color &color)
@@ -372,8 +494,7 @@ void RenderManager::clear(const Color &color)
   }
 
 #else
-  XSetForeground(display, gc, (color.r << 16) | (color.g << 8) | color.b);
-  XFillRectangle(display, backBuffer, gc, 0, 0, windowWidth, windowHeight);
+  xc_fill_rect(&canvas, 0, 0, windowWidth, windowHeight, 0xFF000000 | to_argb(color));
 #endif
 }
 
@@ -397,6 +518,7 @@ void RenderManager::setColor(const Color& color)
 
 void RenderManager::drawRect(const Rect &rect, const Color &color, bool filled)
 {
+  drawCalls++;
 #ifdef _WIN32
   {
     Gdiplus::Graphics g(memDC);
@@ -446,30 +568,21 @@ void RenderManager::drawRect(const Rect &rect, const Color &color, bool filled)
     }
   }
 #else
-  Color blended = color;
-  if (color.a < 255)
-  {
-    const Color& bg = currentTheme.windowBackground;
-    float a = color.a / 255.0f;
-    blended.r = (uint8_t)(color.r * a + bg.r * (1.0f - a));
-    blended.g = (uint8_t)(color.g * a + bg.g * (1.0f - a));
-    blended.b = (uint8_t)(color.b * a + bg.b * (1.0f - a));
-  }
-
-  XSetForeground(display, gc, (blended.r << 16) | (blended.g << 8) | blended.b);
+  uint32_t pixel = to_argb(color);
   if (filled)
   {
-    XFillRectangle(display, backBuffer, gc, rect.x, rect.y, rect.width, rect.height);
+    xc_fill_rect(&canvas, rect.x, rect.y, rect.width, rect.height, pixel);
   }
   else
   {
-    XDrawRectangle(display, backBuffer, gc, rect.x, rect.y, rect.width, rect.height);
+    xc_frame_rect(&canvas, rect.x, rect.y, rect.width, rect.height, pixel);
   }
 #endif
 }
 
 void RenderManager::drawLine(int x1, int y1, int x2, int y2, const Color &color)
 {
+  drawCalls++;
 #ifdef _WIN32
   Gdiplus::Graphics g(memDC);
   g.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
@@ -494,18 +607,7 @@ void RenderManager::drawLine(int x1, int y1, int x2, int y2, const Color &color)
     CGContextStrokePath(ctx);
   }
 #else
-  Color blended = color;
-  if (color.a < 255)
-  {
-    const Color& bg = currentTheme.windowBackground;
-    float a = color.a / 255.0f;
-    blended.r = (uint8_t)(color.r * a + bg.r * (1.0f - a));
-    blended.g = (uint8_t)(color.g * a + bg.g * (1.0f - a));
-    blended.b = (uint8_t)(color.b * a + bg.b * (1.0f - a));
-  }
-
-  XSetForeground(display, gc, (blended.r << 16) | (blended.g << 8) | blended.b);
-  XDrawLine(display, backBuffer, gc, x1, y1, x2, y2);
+  xc_line(&canvas, x1, y1, x2, y2, to_argb(color));
 #endif
 }
 
@@ -513,6 +615,7 @@ void RenderManager::drawText(const char *text, int x, int y, const Color &color)
 {
   if (!text)
     return;
+  drawCalls++;
 
 #ifdef _WIN32
   setColor(color);
@@ -559,8 +662,7 @@ void RenderManager::drawText(const char *text, int x, int y, const Color &color)
 
   CGContextRestoreGState(ctx);
 #else
-  XSetForeground(display, gc, (color.r << 16) | (color.g << 8) | color.b);
-  XDrawString(display, backBuffer, gc, x, y + 12, text, strLen(text));
+  xc_text(&canvas, &atlas, text, x, y + 12, to_argb(color));
 #endif
 }
 
@@ -922,22 +1024,18 @@ void RenderManager::drawModernRadioButton(const WidgetState &state, const Theme
   int centerY = state.rect.y + state.rect.height / 2;
   int outerRadius = state.rect.width / 2;
 
-  XSetForeground(display, gc, (bgColor.r << 16) | (bgColor.g << 8) | bgColor.b);
-  XFillArc(display, backBuffer, gc, state.rect.x, state.rect.y,
-           state.rect.width, state.rect.height, 0, 360 * 64);
-
-  XSetForeground(display, gc, (borderColor.r << 16) | (borderColor.g << 8) | borderColor.b);
-  XDrawArc(display, backBuffer, gc, state.rect.x, state.rect.y,
-           state.rect.width, state.rect.height, 0, 360 * 64);
+  xc_fill_ellipse(&canvas, state.rect.x, state.rect.y, state.rect.width, state.rect.height,
+                  to_argb(bgColor));
+  xc_frame_ellipse(&canvas, state.rect.x, state.rect.y, state.rect.width, state.rect.height,
+                   to_argb(borderColor));
 
   if (selected)
   {
     int innerRadius = outerRadius - 4;
     Color dotColor = theme.controlCheck;
 
-    XSetForeground(display, gc, (dotColor.r << 16) | (dotColor.g << 8) | dotColor.b);
-    XFillArc(display, backBuffer, gc, centerX - innerRadius, centerY - innerRadius,
-             innerRadius * 2, innerRadius * 2, 0, 360 * 64);
+    xc_fill_ellipse(&canvas, centerX - innerRadius, centerY - innerRadius,
+                    innerRadius * 2, innerRadius * 2, to_argb(dotColor));
   }
 #endif
 }
@@ -1167,7 +1265,7 @@ BytePositionInfo RenderManager::GetHexBytePositionInfo(Point screenPoint)
 
   long long bytePos = _startByte + ((long long)row * _bytesPerLine) + column;
 
-  long long maxPos = (long long)g_HexData.getFileSize() - 1;
+  long long maxPos = (long long)g_HexData->getFileSize() - 1;
   if (maxPos < 0)
   {
     maxPos = 0;
@@ -1225,12 +1323,12 @@ long long RenderManager::ScreenToByteIndex(int mouseX, int mouseY)
 {
   BytePositionInfo info = GetHexBytePositionInfo(Point(mouseX, mouseY));
 
-  extern HexData g_HexData;
+  extern HexData* g_HexData;
   if (info.Index < 0)
     return 0;
-  if (info.Index >= (long long)g_HexData.getFileSize())
+  if (info.Index >= (long long)g_HexData->getFileSize())
   {
-    return g_HexData.getFileSize() - 1;
+    return g_HexData->getFileSize() - 1;
   }
 
   return info.Index;
@@ -1260,11 +1358,13 @@ void RenderManager::drawImage(void *image, int width, int height, int x, int y)
 #ifdef __linux__
 void RenderManager::drawX11Pixmap(Pixmap pixmap, int width, int height, int x, int y)
 {
-  if (!display || !backBuffer || !pixmap)
+  if (!display || !pixmap)
+    return;
+  XImage* image = XGetImage(display, pixmap, 0, 0, width, height, AllPlanes, ZPixmap);
+  if (!image)
     return;
-  GC tempGC = XCreateGC(display, backBuffer, 0, nullptr);
-  XCopyArea(display, pixmap, backBuffer, tempGC, 0, 0, width, height, x, y);
-  XFreeGC(display, tempGC);
+  xc_blit(&canvas, image, width, height, x, y);
+  XDestroyImage(image);
 }
 #endif
 
@@ -1316,6 +1416,20 @@ void RenderManager::drawProgressBar(const Rect &rect, float progress, const Them
   drawRoundedRect(rect, radius, borderColor, false);
 }
 
+void RenderManager::drawDocumentTabs(const DocumentTab* tabs, int count, int activeIndex, const Theme& theme)
+{
+  int charHeight = getCharHeight();
+  for (int i = 0; i < count; i++)
+  {
+    const Rect& r = tabs[i].bounds;
+    if (i == activeIndex)
+      drawRect(r, theme.menuHover, true);
+    drawLine(r.x, r.y + 4, r.x, r.y + r.height - 4, theme.separator);
+    drawText(tabs[i].label, r.x + 10, r.y + (r.height - charHeight) / 2,
+             i == activeIndex ? theme.textColor : theme.disabledText);
+  }
+}
+
 void RenderManager::drawLeftPanel(
   const LeftPanelState& state,
   const Theme& theme,
@@ -1397,7 +1511,7 @@ void RenderManager::drawLeftPanel(
   int itemSpacing = 4;
   int sectionSpacing = 10;
 
-  long long fileSize = (long long)g_HexData.getFileSize();
+  long long fileSize = (long long)g_HexData->getFileSize();
 
   Color faded;
   Color halfText;
@@ -1465,10 +1579,10 @@ void RenderManager::drawLeftPanel(
   const char* typeStr = "Unknown";
   if (fileSize >= 4)
   {
-    uint8_t b0 = g_HexData.getByte(0);
-    uint8_t b1 = g_HexData.getByte(1);
-    uint8_t b2 = g_HexData.getByte(2);
-    uint8_t b3 = g_HexData.getByte(3);
+    uint8_t b0 = g_HexData->getByte(0);
+    uint8_t b1 = g_HexData->getByte(1);
+    uint8_t b2 = g_HexData->getByte(2);
+    uint8_t b3 = g_HexData->getByte(3);
 
     typeStr = "Binary Data";
     if (b0 == 0x4D && b1 == 0x5A)
@@ -1487,6 +1601,18 @@ void RenderManager::drawLeftPanel(
   drawText(typeStr, contentX + 85, currentY, accentColor);
   currentY += rowHeight + itemSpacing;
 
+  const ScanStats& scan = g_HexData->getScanStats();
+  if (scan.bytes > 0)
+  {
+    itoaDec((long long)(sr_throughput(&scan) / (1024 * 1024)), buf, 200);
+    strCat(buf, " MB/s (");
+    strCat(buf, sr_backend_name(scan.backend));
+    strCat(buf, ")");
+    drawText("Read:", contentX, currentY, faded);
+    drawText(buf, contentX + 85, currentY, theme.textColor);
+    currentY += rowHeight + itemSpacing;
+  }
+
   currentY += 8;
 
   drawText("Data Inspector", contentX, currentY, theme.headerColor);
@@ -1494,7 +1620,7 @@ void RenderManager::drawLeftPanel(
 
   if (cursorBytePos >= 0 && cursorBytePos < fileSize)
   {
-    uint8_t byteVal = g_HexData.getByte((size_t)cursorBytePos);
+    uint8_t byteVal = g_HexData->getByte((size_t)cursorBytePos);
 
     Color highlightColor = isDarkTheme ? Color(100, 150, 255) : Color(50, 100, 200);
 
@@ -1561,7 +1687,7 @@ void RenderManager::drawLeftPanel(
       Bookmark& bm = g_Bookmarks.bookmarks[i];
       if (bm.byteOffset >= 0 && bm.byteOffset < fileSize)
       {
-        bm.byteValue = g_HexData.getByte((size_t)bm.byteOffset);
+        bm.byteValue = g_HexData->getByte((size_t)bm.byteOffset);
       }
     }
 
@@ -1717,7 +1843,7 @@ void RenderManager::drawLeftPanel(
   drawText("Plugin Annotations", contentX, currentY, theme.headerColor);
   currentY += headerHeight + sectionSpacing;
 
-  PluginBookmarkArray* pluginAnnotations = g_HexData.getPluginAnnotations();
+  PluginBookmarkArray* pluginAnnotations = g_HexData->getPluginAnnotations();
 
   if (!pluginAnnotations || pluginAnnotations->count == 0)
   {
@@ -2334,6 +2460,45 @@ bool RenderManager::isPointInContextMenu(
          mouseY <= state.y + totalHeight;
 }
 
+Rect RenderManager::getContextMenuBounds(const ContextMenuState &state)
+{
+  if (!state.visible || state.items.empty())
+    return Rect(0, 0, 0, 0);
+
+  const int itemHeight = 32;
+  const int separatorHeight = 9;
+  const int padding = 4;
+  const int shadow = 5;
+
+  int totalHeight = padding * 2;
+  for (size_t i = 0; i < state.items.size(); i++)
+    totalHeight += state.items[i].separator ? separatorHeight : itemHeight;
+
+  int menuWidth = state.width > 0 ? state.width : 220;
+  Rect bounds(state.x, state.y, menuWidth + shadow, totalHeight + shadow);
+
+  if (state.openSubmenuIndex >= 0 &&
+      state.openSubmenuIndex < (int)state.items.size() &&
+      !state.items[state.openSubmenuIndex].submenu.empty())
+  {
+    const Vector<ContextMenuItem> &submenu = state.items[state.openSubmenuIndex].submenu;
+
+    int submenuY = state.y + padding;
+    for (int i = 0; i < state.openSubmenuIndex; i++)
+      submenuY += state.items[i].separator ? separatorHeight : itemHeight;
+
+    int submenuHeight = padding * 2;
+    for (size_t i = 0; i < submenu.size(); i++)
+      submenuHeight += submenu[i].separator ? separatorHeight : itemHeight;
+
+    submenuY = clamp(submenuY, state.y + padding, state.y + totalHeight - submenuHeight - padding);
+    bounds = rect_union(bounds, Rect(state.x + menuWidth - 2, submenuY,
+                                     menuWidth + shadow, submenuHeight + shadow));
+  }
+
+  return bounds;
+}
+
 int RenderManager::getContextMenuHoveredItem(
     int mouseX, int mouseY,
     const ContextMenuState &state)
@@ -2879,7 +3044,7 @@ void RenderManager::drawByteStatsContent(
 
 bool RenderManager::isPointInDisasmResizeHandle(int mouseX, int mouseY, int menuBarHeight)
 {
-  int separatorX = windowWidth - 16 - _disasmColumnWidth;
+  int separatorX = windowWidth - 16 - MINIMAP_WIDTH - _disasmColumnWidth;
   int handleWidth = 6;
 
   return mouseX >= separatorX - handleWidth / 2 &&
@@ -2912,11 +3077,138 @@ void RenderManager::endDisasmResize()
   _resizingDisasmColumn = false;
 }
 
+static inline int hex_digit(char c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  return -1;
+}
+
+// One draw per byte class present on the line rather than one per cell: each
+// pass keeps the hex and ASCII columns of its class and blanks the rest, so a
+// line costs at most BYTE_CLASS_COUNT + 1 text draws whatever the data. The
+// class is recovered from the formatted hex, so "??" cells of a file that is
+// still loading keep the plain text color.
+void RenderManager::drawByteClassLine(const char* line, int x, int y)
+{
+  int hexCol = g_HexData->getOffsetDigits() + 2;
+  int asciiCol = hexCol + _bytesPerLine * 3 + 1;
+  int length = (int)strLen(line);
+
+  char run[256];
+  if (length <= hexCol || length >= (int)sizeof(run) || _bytesPerLine > 64)
+  {
+    drawText(line, x, y, currentTheme.textColor);
+    return;
+  }
+
+  uint8_t cellClass[64];
+  uint32_t present = 0;
+  int cells = 0;
+  for (; cells < _bytesPerLine && hexCol + cells * 3 + 1 < length; cells++)
+  {
+    const char* hex = line + hexCol + cells * 3;
+    int hi = hex_digit(hex[0]);
+    int lo = hex_digit(hex[1]);
+    uint8_t cls = (hi < 0 || lo < 0) ? (uint8_t)BYTE_CLASS_COUNT : hf_byte_class[(hi << 4) | lo];
+    cellClass[cells] = cls;
+    present |= 1u << cls;
+  }
+
+  // The offset column is drawn with the unclassified cells.
+  present |= 1u << BYTE_CLASS_COUNT;
+
+  for (int cls = 0; cls <= BYTE_CLASS_COUNT; cls++)
+  {
+    if (!(present & (1u << cls)))
+      continue;
+
+    memSet(run, ' ', length);
+    int first = length;
+    int last = -1;
+    if (cls == BYTE_CLASS_COUNT)
+    {
+      memCopy(run, line, hexCol);
+      first = 0;
+      last = hexCol - 1;
+    }
+
+    for (int i = 0; i < cells; i++)
+    {
+      if (cellClass[i] != cls)
+        continue;
+
+      int h = hexCol + i * 3;
+      run[h] = line[h];
+      run[h + 1] = line[h + 1];
+      if (h < first)
+        first = h;
+      if (h + 1 > last)
+        last = h + 1;
+
+      int a = asciiCol + i;
+      if (a < length)
+      {
+        run[a] = line[a];
+        if (a > last)
+          last = a;
+      }
+    }
+
+    if (last < first)
+      continue;
+
+    run[last + 1] = '\0';
+    const Color& color = cls == BYTE_CLASS_COUNT ? currentTheme.textColor : currentTheme.byteColors[cls];
+    drawText(run + first, x + first * _charWidth, y, color);
+  }
+}
+
+// Consecutive rows of the same class are merged into one rect, so a file made
+// of a few large regions costs a handful of draws however tall the strip is.
+void RenderManager::drawMinimap(const Rect& bounds)
+{
+  uint64_t fileSize = g_HexData->getFileSize();
+  if (bounds.height <= 0 || fileSize == 0 || isClipped(bounds))
+    return;
+
+  drawRect(bounds, currentTheme.scrollbarBg, true);
+  if (g_Minimap.owner != g_HexData || g_Minimap.fileSize != fileSize)
+    return;
+
+  int runStart = 0;
+  int runClass = MINIMAP_UNKNOWN;
+  for (int row = 0; row <= bounds.height; row++)
+  {
+    int cls = MINIMAP_UNKNOWN;
+    if (row < bounds.height)
+    {
+      uint64_t start = fileSize * row / bounds.height;
+      uint64_t end = fileSize * (row + 1) / bounds.height;
+      cls = mm_class_at(&g_Minimap, start, end);
+      if (cls == runClass)
+        continue;
+    }
+
+    if (runClass != MINIMAP_UNKNOWN)
+    {
+      Rect run(bounds.x + 2, bounds.y + runStart, bounds.width - 4, row - runStart);
+      drawRect(run, currentTheme.overviewColors[runClass], true);
+    }
+    runStart = row;
+    runClass = cls;
+  }
+}
+
 void RenderManager::renderHexViewer(
-  const Vector<char*>& hexLines,
+  const LineProvider& lines,
   const char* headerLine,
-  int scrollPos,
-  int maxScrollPos,
+  long long scrollPos,
+  long long maxScrollPos,
   bool scrollbarHovered,
   bool scrollbarPressed,
   const Rect& scrollbarRect,
@@ -3000,7 +3292,7 @@ void RenderManager::renderHexViewer(
       menuBarHeight + (int)layout.margin,
       currentTheme.headerColor);
 
-    int disasmX = windowWidth - (int)layout.scrollbarWidth - _disasmColumnWidth + 10;
+    int disasmX = windowWidth - (int)layout.scrollbarWidth - MINIMAP_WIDTH - _disasmColumnWidth + 10;
     drawText("Disassembly",
       disasmX,
       menuBarHeight + (int)layout.margin,
@@ -3013,7 +3305,7 @@ void RenderManager::renderHexViewer(
       currentTheme.separator);
   }
 
-  int separatorX = windowWidth - (int)layout.scrollbarWidth - _disasmColumnWidth;
+  int separatorX = windowWidth - (int)layout.scrollbarWidth - MINIMAP_WIDTH - _disasmColumnWidth;
   drawLine(separatorX,
     menuBarHeight + (int)(layout.margin + layout.headerHeight),
     separatorX,
@@ -3039,10 +3331,10 @@ void RenderManager::renderHexViewer(
   _visibleLines = (int)maxVisibleLines;
 
   size_t actualStartLine = (size_t)scrollPos;
-  size_t actualEndLine = actualStartLine + hexLines.size();
+  size_t actualEndLine = actualStartLine + lines.count;
 
-  extern HexData g_HexData;
-  const LineArray& disasmLines = g_HexData.getDisassemblyLines();
+  extern HexData* g_HexData;
+  g_HexData->readAhead((uint64_t)_startByte, (uint64_t)_bytesPerLine * _visibleLines);
 
   extern SelectionState g_Selection;
   if (g_Selection.active)
@@ -3052,17 +3344,16 @@ void RenderManager::renderHexViewer(
 
     long long firstLine = selMin / _bytesPerLine;
     long long lastLine = selMax / _bytesPerLine;
+    if (firstLine < (long long)actualStartLine)
+      firstLine = (long long)actualStartLine;
+    if (lastLine >= (long long)actualEndLine)
+      lastLine = (long long)actualEndLine - 1;
 
     Color highlightColor = currentTheme.controlCheck;
     highlightColor.a = 80;
 
     for (long long line = firstLine; line <= lastLine; line++)
     {
-      if (line < (long long)actualStartLine)
-        continue;
-      if (line >= (long long)actualEndLine)
-        break;
-
       int displayLine = (int)(line - actualStartLine);
       int yPos = contentY + displayLine * _charHeight;
 
@@ -3092,14 +3383,16 @@ void RenderManager::renderHexViewer(
 
   if (g_Options.bookmarkHighlights && !g_Bookmarks.bookmarks.empty())
   {
-    for (size_t i = 0; i < g_Bookmarks.bookmarks.size(); i++)
+    long long viewStart = (long long)actualStartLine * _bytesPerLine;
+    long long viewEnd = (long long)actualEndLine * _bytesPerLine;
+
+    for (int pos = Bookmarks_LowerBound(viewStart); pos < (int)g_Bookmarks.byOffset.size(); pos++)
     {
-      const Bookmark& bm = g_Bookmarks.bookmarks[i];
+      const Bookmark& bm = g_Bookmarks.bookmarks[g_Bookmarks.byOffset[pos]];
+      if (bm.byteOffset >= viewEnd)
+        break;
       long long bmLine = bm.byteOffset / _bytesPerLine;
 
-      if (bmLine < (long long)actualStartLine || bmLine >= (long long)actualEndLine)
-        continue;
-
       int displayLine = (int)(bmLine - actualStartLine);
       int yPos = contentY + displayLine * _charHeight;
 
@@ -3122,24 +3415,31 @@ void RenderManager::renderHexViewer(
     }
   }
 
-  for (size_t i = 0; i < hexLines.size(); i++)
+  for (size_t i = 0; i < lines.count; i++)
   {
     int y = contentY + (int)(i * layout.lineHeight);
-    const char* line = hexLines[i];
+    if (isClipped(Rect(contentArea.x, y, contentArea.width, _charHeight)))
+      continue;
 
-    drawText(line,
-      leftPanelWidth + (int)layout.margin,
-      y,
-      currentTheme.textColor);
+    const char* line = lines.fetch(lines.context, lines.firstLine + i);
 
-    size_t actualLineIndex = actualStartLine + i;
-    if (actualLineIndex < disasmLines.count && disasmLines.lines[actualLineIndex].data != nullptr)
+    if (g_Options.byteClassColors)
     {
-      if (disasmLines.lines[actualLineIndex].length > 0)
-      {
-        int disasmX = separatorX + 10;
-        drawText(disasmLines.lines[actualLineIndex].data, disasmX, y, currentTheme.disassemblyColor);
-      }
+      drawByteClassLine(line, leftPanelWidth + (int)layout.margin, y);
+    }
+    else
+    {
+      drawText(line,
+        leftPanelWidth + (int)layout.margin,
+        y,
+        currentTheme.textColor);
+    }
+
+    const char* disasm = g_HexData->getDisassemblyLine(actualStartLine + i);
+    if (disasm && disasm[0])
+    {
+      int disasmX = separatorX + 10;
+      drawText(disasm, disasmX, y, currentTheme.disassemblyColor);
     }
   }
 
@@ -3149,13 +3449,55 @@ void RenderManager::renderHexViewer(
     DrawCaret();
   }
 
+  if (g_HexData->isLoading() && g_HexData->isStream())
+  {
+    char status[96];
+    char number[32];
+    itoaDec((long long)(g_HexData->getStreamReceived() / 1024), number, 32);
+    strCopy(status, "Streaming: ");
+    strCat(status, number);
+    strCat(status, " KB received");
+    if (g_HexData->getStreamDropped() > 0)
+    {
+      itoaDec((long long)(g_HexData->getStreamDropped() / 1024), number, 32);
+      strCat(status, ", ");
+      strCat(status, number);
+      strCat(status, " KB dropped");
+    }
+    strCat(status, " (Esc to stop)");
+    drawText(status, contentArea.x + 10, contentArea.y + contentArea.height - _charHeight - 10, currentTheme.textColor);
+  }
+  else if (g_HexData->isLoading())
+  {
+    int barHeight = _charHeight + 8;
+    int barWidth = contentArea.width - (int)layout.scrollbarWidth - 20;
+    if (barWidth > 400)
+      barWidth = 400;
+    Rect barRect(contentArea.x + 10, contentArea.y + contentArea.height - barHeight - 10, barWidth, barHeight);
+    drawProgressBar(barRect, g_HexData->getLoadProgress(), currentTheme);
+
+    char status[64];
+    char percent[16];
+    itoaDec((long long)(g_HexData->getLoadProgress() * 100.0f), percent, 16);
+    strCopy(status, "Loading ");
+    strCat(status, percent);
+    strCat(status, "% (Esc to cancel)");
+    drawText(status, barRect.x + barRect.width + 10, barRect.y + 4, currentTheme.textColor);
+  }
+
+  _minimapRect = Rect(windowWidth - (int)layout.scrollbarWidth - MINIMAP_WIDTH,
+    menuBarHeight + (int)(layout.margin + layout.headerHeight),
+    MINIMAP_WIDTH,
+    contentHeight);
+  drawMinimap(_minimapRect);
+
   if (maxScrollPos > 0)
   {
     extern ScrollbarState g_MainScrollbar;
 
     if (maxScrollPos > 0)
     {
-      g_MainScrollbar.position = (float)scrollPos / (float)maxScrollPos;
+      g_MainScrollbar.position = (float)((double)scrollPos / (double)maxScrollPos);
     }
     else
     {
@@ -3171,9 +3513,8 @@ void RenderManager::renderHexViewer(
     g_MainScrollbar.pressed = scrollbarPressed;
     g_MainScrollbar.thumbHovered = scrollbarHovered;
 
-    extern HexData g_HexData;
-    const LineArray& allLines = g_HexData.getHexLines();
-    int totalContentHeight = (int)allLines.count * _charHeight;
+    extern HexData* g_HexData;
+    double totalContentHeight = (double)g_HexData->getLineCount() * _charHeight;
     int viewportHeight = contentHeight;
 
     int scrollbarX = windowWidth - 16;
@@ -0,0 +1,618 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/types.h>
+#endif
+
+#if defined(__linux__) && defined(HEXVIEWER_IO_URING)
+#define SCAN_HAVE_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+#include "scanreader.h"
+
+struct ScanSlot
+{
+  uint8_t* data;
+  uint64_t chunk;
+  uint64_t length;
+  uint64_t filled;
+  bool ready;
+};
+
+struct ScanRing
+{
+  ByteBuffer buffer;
+  ScanSlot slots[SCAN_DEPTH];
+  int depth;
+  uint64_t offset;
+  uint64_t length;
+  uint64_t chunks;
+};
+
+static bool ring_init(ScanRing* r, uint64_t offset, uint64_t length)
+{
+  r->offset = offset;
+  r->length = length;
+  r->chunks = (length + SCAN_CHUNK - 1) / SCAN_CHUNK;
+  r->depth = r->chunks < SCAN_DEPTH ? (int)r->chunks : SCAN_DEPTH;
+
+  bb_init(&r->buffer);
+  if (!bb_resize(&r->buffer, (size_t)r->depth * SCAN_CHUNK))
+    return false;
+
+  for (int i = 0; i < r->depth; i++)
+  {
+    r->slots[i].data = r->buffer.data + (size_t)i * SCAN_CHUNK;
+    r->slots[i].chunk = 0;
+    r->slots[i].length = 0;
+    r->slots[i].filled = 0;
+    r->slots[i].ready = false;
+  }
+  return true;
+}
+
+static uint64_t chunk_length(const ScanRing* r, uint64_t chunk)
+{
+  uint64_t pos = chunk * SCAN_CHUNK;
+  uint64_t len = r->length - pos;
+  return len < SCAN_CHUNK ? len : SCAN_CHUNK;
+}
+
+#ifdef SCAN_HAVE_URING
+
+struct Uring
+{
+  int fd;
+  uint8_t* sqRing;
+  size_t sqRingSize;
+  uint8_t* cqRing;
+  size_t cqRingSize;
+  io_uring_sqe* sqes;
+  size_t sqesSize;
+  unsigned* sqTail;
+  unsigned sqMask;
+  unsigned* sqArray;
+  unsigned* cqHead;
+  unsigned* cqTail;
+  unsigned cqMask;
+  io_uring_cqe* cqes;
+  unsigned pending;
+};
+
+static bool uring_open(Uring* u, unsigned entries)
+{
+  io_uring_params p;
+  memSet(&p, 0, sizeof(p));
+
+  u->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+  if (u->fd < 0)
+    return false;
+
+  u->sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  u->cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+  bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single)
+  {
+    if (u->cqRingSize > u->sqRingSize)
+      u->sqRingSize = u->cqRingSize;
+    u->cqRingSize = u->sqRingSize;
+  }
+
+  void* sq = mmap(nullptr, u->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQ_RING);
+  if (sq == MAP_FAILED)
+  {
+    close(u->fd);
+    return false;
+  }
+
+  void* cq = sq;
+  if (!single)
+  {
+    cq = mmap(nullptr, u->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_CQ_RING);
+    if (cq == MAP_FAILED)
+    {
+      munmap(sq, u->sqRingSize);
+      close(u->fd);
+      return false;
+    }
+  }
+
+  u->sqesSize = p.sq_entries * sizeof(io_uring_sqe);
+  void* sqes = mmap(nullptr, u->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED)
+  {
+    if (cq != sq)
+      munmap(cq, u->cqRingSize);
+    munmap(sq, u->sqRingSize);
+    close(u->fd);
+    return false;
+  }
+
+  u->sqRing = (uint8_t*)sq;
+  u->cqRing = (uint8_t*)cq;
+  u->sqes = (io_uring_sqe*)sqes;
+  u->sqTail = (unsigned*)(u->sqRing + p.sq_off.tail);
+  u->sqMask = *(unsigned*)(u->sqRing + p.sq_off.ring_mask);
+  u->sqArray = (unsigned*)(u->sqRing + p.sq_off.array);
+  u->cqHead = (unsigned*)(u->cqRing + p.cq_off.head);
+  u->cqTail = (unsigned*)(u->cqRing + p.cq_off.tail);
+  u->cqMask = *(unsigned*)(u->cqRing + p.cq_off.ring_mask);
+  u->cqes = (io_uring_cqe*)(u->cqRing + p.cq_off.cqes);
+  u->pending = 0;
+  return true;
+}
+
+static void uring_close(Uring* u)
+{
+  munmap(u->sqes, u->sqesSize);
+  if (u->cqRing != u->sqRing)
+    munmap(u->cqRing, u->cqRingSize);
+  munmap(u->sqRing, u->sqRingSize);
+  close(u->fd);
+}
+
+static void uring_prep_read(Uring* u, int fd, uint8_t* buf, uint64_t len, uint64_t pos, uint64_t userData)
+{
+  unsigned tail = *u->sqTail;
+  unsigned index = tail & u->sqMask;
+
+  io_uring_sqe* sqe = &u->sqes[index];
+  memSet(sqe, 0, sizeof(*sqe));
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = fd;
+  sqe->addr = (uint64_t)(uintptr_t)buf;
+  sqe->len = (uint32_t)len;
+  sqe->off = pos;
+  sqe->user_data = userData;
+
+  u->sqArray[index] = index;
+  __atomic_store_n(u->sqTail, tail + 1, __ATOMIC_RELEASE);
+  u->pending++;
+}
+
+static bool uring_enter(Uring* u, unsigned waitFor)
+{
+  for (;;)
+  {
+    long r = syscall(__NR_io_uring_enter, u->fd, u->pending, waitFor,
+                     waitFor ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+    if (r >= 0)
+    {
+      u->pending -= (unsigned)r;
+      return true;
+    }
+    if (errno != EINTR)
+      return false;
+  }
+}
+
+// Returns -1 when io_uring is unavailable before any data was delivered, so the
+// caller can fall back to the thread pool.
+static int uring_scan(ScanRing* r, int fd, ScanChunkCallback callback, void* context, ScanStats* stats)
+{
+  Uring u;
+  if (!uring_open(&u, SCAN_DEPTH))
+    return -1;
+
+  uint64_t next = 0;
+  uint64_t delivered = 0;
+  unsigned inflight = 0;
+  bool stop = false;
+  bool failed = false;
+
+  while (delivered < r->chunks && !stop)
+  {
+    while (next < r->chunks && next - delivered < (uint64_t)r->depth)
+    {
+      int index = (int)(next % r->depth);
+      ScanSlot* slot = &r->slots[index];
+      slot->chunk = next;
+      slot->length = chunk_length(r, next);
+      slot->filled = 0;
+      slot->ready = false;
+      uring_prep_read(&u, fd, slot->data, slot->length, r->offset + next * SCAN_CHUNK, (uint64_t)index);
+      inflight++;
+      next++;
+    }
+
+    if (!uring_enter(&u, r->slots[delivered % r->depth].ready ? 0 : 1))
+    {
+      failed = true;
+      break;
+    }
+
+    unsigned head = *u.cqHead;
+    while (head != __atomic_load_n(u.cqTail, __ATOMIC_ACQUIRE))
+    {
+      io_uring_cqe* cqe = &u.cqes[head & u.cqMask];
+      head++;
+      inflight--;
+
+      ScanSlot* slot = &r->slots[cqe->user_data];
+      if (cqe->res <= 0)
+      {
+        failed = true;
+        stop = true;
+        continue;
+      }
+
+      slot->filled += (uint64_t)cqe->res;
+      if (slot->filled < slot->length && !stop)
+      {
+        uring_prep_read(&u, fd, slot->data + slot->filled, slot->length - slot->filled,
+                        r->offset + slot->chunk * SCAN_CHUNK + slot->filled, cqe->user_data);
+        inflight++;
+      }
+      else if (slot->filled == slot->length)
+      {
+        slot->ready = true;
+      }
+    }
+    __atomic_store_n(u.cqHead, head, __ATOMIC_RELEASE);
+
+    while (!stop && delivered < r->chunks)
+    {
+      ScanSlot* slot = &r->slots[delivered % r->depth];
+      if (!slot->ready || slot->chunk != delivered)
+        break;
+
+      slot->ready = false;
+      if (!callback(context, r->offset + delivered * SCAN_CHUNK, slot->data, (size_t)slot->length))
+        stop = true;
+      stats->bytes += slot->length;
+      delivered++;
+    }
+  }
+
+  while (inflight > 0 && uring_enter(&u, 1))
+  {
+    unsigned head = *u.cqHead;
+    while (head != __atomic_load_n(u.cqTail, __ATOMIC_ACQUIRE))
+    {
+      head++;
+      inflight--;
+    }
+    __atomic_store_n(u.cqHead, head, __ATOMIC_RELEASE);
+  }
+
+  uring_close(&u);
+
+  if (failed && stats->bytes == 0)
+    return -1;
+  return failed ? 0 : 1;
+}
+
+#endif
+
+struct ThreadScan
+{
+  ScanRing* ring;
+  const FileMapping* mapping;
+  uint64_t next;
+  uint64_t delivered;
+  bool stop;
+  bool failed;
+#ifdef _WIN32
+  CRITICAL_SECTION lock;
+  CONDITION_VARIABLE changed;
+#else
+  pthread_mutex_t lock;
+  pthread_cond_t changed;
+#endif
+};
+
+static void scan_lock(ThreadScan* s)
+{
+#ifdef _WIN32
+  EnterCriticalSection(&s->lock);
+#else
+  pthread_mutex_lock(&s->lock);
+#endif
+}
+
+static void scan_unlock(ThreadScan* s)
+{
+#ifdef _WIN32
+  LeaveCriticalSection(&s->lock);
+#else
+  pthread_mutex_unlock(&s->lock);
+#endif
+}
+
+static void scan_wait(ThreadScan* s)
+{
+#ifdef _WIN32
+  SleepConditionVariableCS(&s->changed, &s->lock, INFINITE);
+#else
+  pthread_cond_wait(&s->changed, &s->lock);
+#endif
+}
+
+static void scan_wake(ThreadScan* s)
+{
+#ifdef _WIN32
+  WakeAllConditionVariable(&s->changed);
+#else
+  pthread_cond_broadcast(&s->changed);
+#endif
+}
+
+#ifdef _WIN32
+static bool read_full(HANDLE file, uint8_t* buf, uint64_t len, uint64_t pos)
+{
+  while (len > 0)
+  {
+    OVERLAPPED ov;
+    memSet(&ov, 0, sizeof(ov));
+    ov.Offset = (DWORD)(pos & 0xFFFFFFFF);
+    ov.OffsetHigh = (DWORD)(pos >> 32);
+
+    DWORD got = 0;
+    if (!ReadFile(file, buf, (DWORD)len, &got, &ov) || got == 0)
+      return false;
+    buf += got;
+    pos += got;
+    len -= got;
+  }
+  return true;
+}
+#else
+static bool read_full(int fd, uint8_t* buf, uint64_t len, uint64_t pos)
+{
+  while (len > 0)
+  {
+    ssize_t got = pread(fd, buf, (size_t)len, (off_t)pos);
+    if (got < 0 && errno == EINTR)
+      continue;
+    if (got <= 0)
+      return false;
+    buf += got;
+    pos += (uint64_t)got;
+    len -= (uint64_t)got;
+  }
+  return true;
+}
+#endif
+
+static void scan_worker(ThreadScan* s)
+{
+  ScanRing* r = s->ring;
+
+#ifdef _WIN32
+  // A separate file object per worker keeps reads from serialising on the
+  // shared handle's file position lock.
+  HANDLE file = ReOpenFile((HANDLE)s->mapping->file, GENERIC_READ,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, 0);
+  bool ownFile = file != INVALID_HANDLE_VALUE;
+  if (!ownFile)
+    file = (HANDLE)s->mapping->file;
+#else
+  int file = s->mapping->fd;
+#endif
+
+  scan_lock(s);
+  for (;;)
+  {
+    while (!s->stop && s->next < r->chunks && s->next - s->delivered >= (uint64_t)r->depth)
+      scan_wait(s);
+    if (s->stop || s->next >= r->chunks)
+      break;
+
+    uint64_t chunk = s->next++;
+    ScanSlot* slot = &r->slots[chunk % r->depth];
+    scan_unlock(s);
+
+    uint64_t len = chunk_length(r, chunk);
+    bool ok = read_full(file, slot->data, len, r->offset + chunk * SCAN_CHUNK);
+
+    scan_lock(s);
+    if (ok)
+    {
+      slot->chunk = chunk;
+      slot->length = len;
+      slot->ready = true;
+    }
+    else
+    {
+      s->failed = true;
+      s->stop = true;
+    }
+    scan_wake(s);
+  }
+  scan_unlock(s);
+
+#ifdef _WIN32
+  if (ownFile)
+    CloseHandle(file);
+#endif
+}
+
+#ifdef _WIN32
+static DWORD WINAPI ScanThread(LPVOID param)
+{
+  scan_worker((ThreadScan*)param);
+  return 0;
+}
+#else
+static void* ScanThread(void* param)
+{
+  scan_worker((ThreadScan*)param);
+  return nullptr;
+}
+#endif
+
+static bool thread_scan(ScanRing* r, const FileMapping* m, ScanChunkCallback callback, void* context, ScanStats* stats)
+{
+  ThreadScan s;
+  s.ring = r;
+  s.mapping = m;
+  s.next = 0;
+  s.delivered = 0;
+  s.stop = false;
+  s.failed = false;
+#ifdef _WIN32
+  InitializeCriticalSection(&s.lock);
+  InitializeConditionVariable(&s.changed);
+  HANDLE threads[SCAN_THREADS];
+#else
+  pthread_mutex_init(&s.lock, nullptr);
+  pthread_cond_init(&s.changed, nullptr);
+  pthread_t threads[SCAN_THREADS];
+#endif
+
+  int wanted = r->chunks < SCAN_THREADS ? (int)r->chunks : SCAN_THREADS;
+  int started = 0;
+  for (int i = 0; i < wanted; i++)
+  {
+#ifdef _WIN32
+    threads[started] = CreateThread(nullptr, 0, ScanThread, &s, 0, nullptr);
+    if (threads[started])
+      started++;
+#else
+    if (pthread_create(&threads[started], nullptr, ScanThread, &s) == 0)
+      started++;
+#endif
+  }
+
+  if (started == 0)
+  {
+#ifdef _WIN32
+    DeleteCriticalSection(&s.lock);
+#else
+    pthread_cond_destroy(&s.changed);
+    pthread_mutex_destroy(&s.lock);
+#endif
+    return false;
+  }
+
+  scan_lock(&s);
+  while (s.delivered < r->chunks)
+  {
+    ScanSlot* slot = &r->slots[s.delivered % r->depth];
+    while (!s.failed && !(slot->ready && slot->chunk == s.delivered))
+      scan_wait(&s);
+    if (s.failed)
+      break;
+    scan_unlock(&s);
+
+    bool more = callback(context, r->offset + s.delivered * SCAN_CHUNK, slot->data, (size_t)slot->length);
+    stats->bytes += slot->length;
+
+    scan_lock(&s);
+    slot->ready = false;
+    s.delivered++;
+    if (!more)
+    {
+      s.stop = true;
+      break;
+    }
+    scan_wake(&s);
+  }
+  s.stop = true;
+  scan_wake(&s);
+  scan_unlock(&s);
+
+  for (int i = 0; i < started; i++)
+  {
+#ifdef _WIN32
+    WaitForSingleObject(threads[i], INFINITE);
+    CloseHandle(threads[i]);
+#else
+    pthread_join(threads[i], nullptr);
+#endif
+  }
+
+#ifdef _WIN32
+  DeleteCriticalSection(&s.lock);
+#else
+  pthread_cond_destroy(&s.changed);
+  pthread_mutex_destroy(&s.lock);
+#endif
+  return !s.failed;
+}
+
+uint64_t sr_now_us()
+{
+#ifdef _WIN32
+  LARGE_INTEGER freq;
+  LARGE_INTEGER now;
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&now);
+  return (uint64_t)(now.QuadPart / freq.QuadPart) * 1000000 +
+         (uint64_t)(now.QuadPart % freq.QuadPart) * 1000000 / (uint64_t)freq.QuadPart;
+#else
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+#endif
+}
+
+bool sr_scan_file(const FileMapping* m, uint64_t offset, uint64_t length,
+                  ScanChunkCallback callback, void* context, ScanStats* stats)
+{
+  stats->bytes = 0;
+  stats->microseconds = 0;
+  stats->backend = SCAN_BACKEND_NONE;
+
+  if (!fm_is_open(m) || offset > m->size)
+    return false;
+  if (length > m->size - offset)
+    length = m->size - offset;
+  if (length == 0)
+    return true;
+
+  ScanRing ring;
+  if (!ring_init(&ring, offset, length))
+  {
+    bb_free(&ring.buffer);
+    return false;
+  }
+
+  uint64_t start = sr_now_us();
+  int result = -1;
+
+#ifdef SCAN_HAVE_URING
+  result = uring_scan(&ring, m->fd, callback, context, stats);
+  if (result >= 0)
+    stats->backend = SCAN_BACKEND_IO_URING;
+#endif
+
+  if (result < 0)
+  {
+    stats->backend = SCAN_BACKEND_THREADS;
+    result = thread_scan(&ring, m, callback, context, stats) ? 1 : 0;
+  }
+
+  stats->microseconds = sr_now_us() - start;
+  bb_free(&ring.buffer);
+  return result > 0;
+}
+
+uint64_t sr_throughput(const ScanStats* stats)
+{
+  if (stats->microseconds == 0)
+    return 0;
+  return stats->bytes * 1000000 / stats->microseconds;
+}
+
+const char* sr_backend_name(int backend)
+{
+  switch (backend)
+  {
+  case SCAN_BACKEND_MEMORY:
+    return "memory";
+  case SCAN_BACKEND_THREADS:
+    return "threads";
+  case SCAN_BACKEND_IO_URING:
+    return "io_uring";
+  }
+  return "none";
+}
@@ -0,0 +1,476 @@
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+
+#include "streamsource.h"
+
+#ifdef _WIN32
+#define STREAM_STORE(p, v) InterlockedExchange64((volatile LONG64*)(p), (LONG64)(v))
+#define STREAM_LOAD(p) InterlockedCompareExchange64((volatile LONG64*)(p), 0, 0)
+#define STREAM_STORE_INT(p, v) InterlockedExchange((volatile LONG*)(p), (LONG)(v))
+#define STREAM_LOAD_INT(p) InterlockedCompareExchange((volatile LONG*)(p), 0, 0)
+#else
+#define STREAM_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define STREAM_LOAD(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STREAM_STORE_INT(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define STREAM_LOAD_INT(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#endif
+
+static void stream_lock(StreamSource* s)
+{
+#ifdef _WIN32
+  EnterCriticalSection(&s->lock);
+#else
+  pthread_mutex_lock(&s->lock);
+#endif
+}
+
+static void stream_unlock(StreamSource* s)
+{
+#ifdef _WIN32
+  LeaveCriticalSection(&s->lock);
+#else
+  pthread_mutex_unlock(&s->lock);
+#endif
+}
+
+static void stream_sleep()
+{
+#ifdef _WIN32
+  Sleep(1);
+#else
+  usleep(1000);
+#endif
+}
+
+// Only the reader appends to the last chunk, and the consumer never frees it,
+// so the returned pointer stays valid without holding the lock.
+static uint8_t* write_target(StreamSource* s, size_t* outRoom)
+{
+  stream_lock(s);
+  size_t count = s->chunks.size();
+  if (count > 0 && s->chunks[count - 1].length < STREAM_CHUNK)
+  {
+    StreamChunk& last = s->chunks[count - 1];
+    *outRoom = STREAM_CHUNK - last.length;
+    uint8_t* target = last.data + last.length;
+    stream_unlock(s);
+    return target;
+  }
+  stream_unlock(s);
+
+  StreamChunk chunk;
+  chunk.data = (uint8_t*)sysAlloc(STREAM_CHUNK);
+  chunk.length = 0;
+  if (!chunk.data)
+    return nullptr;
+
+  stream_lock(s);
+  s->chunks.push_back(chunk);
+  stream_unlock(s);
+
+  *outRoom = STREAM_CHUNK;
+  return chunk.data;
+}
+
+static void publish(StreamSource* s, size_t length)
+{
+  stream_lock(s);
+  s->chunks[s->chunks.size() - 1].length += length;
+  s->pending += length;
+  STREAM_STORE(&s->received, s->received + length);
+  stream_unlock(s);
+}
+
+static int run_stream(StreamSource* s)
+{
+#ifndef _WIN32
+  if (s->fd < 0)
+  {
+    // Opening a FIFO blocks until a writer appears; st_cancel unblocks it.
+    int fd = open(s->path, O_RDONLY);
+    if (fd < 0)
+      return STREAM_FAILED;
+    STREAM_STORE_INT(&s->fd, fd);
+  }
+#endif
+
+  for (;;)
+  {
+    if (STREAM_LOAD_INT(&s->cancelRequested))
+      return STREAM_CANCELLED;
+
+    stream_lock(s);
+    bool full = s->pending >= STREAM_BACKLOG;
+    stream_unlock(s);
+    if (full)
+    {
+      stream_sleep();
+      continue;
+    }
+
+    size_t room = 0;
+    uint8_t* target = write_target(s, &room);
+    if (!target)
+      return STREAM_FAILED;
+
+#ifdef _WIN32
+    DWORD got = 0;
+    if (!ReadFile(s->handle, target, (DWORD)room, &got, NULL))
+    {
+      DWORD err = GetLastError();
+      if (err == ERROR_OPERATION_ABORTED)
+        return STREAM_CANCELLED;
+      return err == ERROR_BROKEN_PIPE || err == ERROR_HANDLE_EOF ? STREAM_ENDED : STREAM_FAILED;
+    }
+    if (got == 0)
+      return STREAM_ENDED;
+#else
+    pollfd pfd;
+    pfd.fd = s->fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    int ready = poll(&pfd, 1, 100);
+    if (ready == 0 || (ready < 0 && errno == EINTR))
+      continue;
+
+    ssize_t got = read(s->fd, target, room);
+    if (got < 0 && (errno == EINTR || errno == EAGAIN))
+      continue;
+    if (got < 0)
+      return STREAM_FAILED;
+    if (got == 0)
+      return STREAM_ENDED;
+#endif
+
+    publish(s, (size_t)got);
+  }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI StreamThread(LPVOID param)
+{
+  StreamSource* s = (StreamSource*)param;
+  STREAM_STORE_INT(&s->state, run_stream(s));
+  return 0;
+}
+#else
+static void* StreamThread(void* param)
+{
+  StreamSource* s = (StreamSource*)param;
+  STREAM_STORE_INT(&s->state, run_stream(s));
+  return nullptr;
+}
+#endif
+
+void st_init(StreamSource* s)
+{
+  s->path[0] = '\0';
+  s->chunks.clear();
+  s->consumed = 0;
+  s->pending = 0;
+  s->received = 0;
+  s->state = STREAM_IDLE;
+  s->cancelRequested = 0;
+  s->threadStarted = false;
+#ifdef _WIN32
+  s->handle = INVALID_HANDLE_VALUE;
+  s->ownHandle = false;
+  s->thread = nullptr;
+#else
+  s->fd = -1;
+  s->ownFd = false;
+#endif
+}
+
+bool st_is_stream_path(const char* path)
+{
+  if (!path)
+    return false;
+  if (path[0] == '-' && path[1] == '\0')
+    return true;
+
+#ifdef _WIN32
+  HANDLE h = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                         NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (h == INVALID_HANDLE_VALUE)
+    return false;
+  DWORD type = GetFileType(h);
+  CloseHandle(h);
+  return type == FILE_TYPE_PIPE || type == FILE_TYPE_CHAR;
+#else
+  struct stat st;
+  if (stat(path, &st) != 0)
+    return false;
+  return S_ISFIFO(st.st_mode) || S_ISCHR(st.st_mode) || S_ISSOCK(st.st_mode);
+#endif
+}
+
+bool st_open(StreamSource* s, const char* path)
+{
+  st_close(s);
+  stringCopy(s->path, path, MAX_PATH_LEN);
+  bool useStdin = path[0] == '-' && path[1] == '\0';
+
+#ifdef _WIN32
+  if (useStdin)
+  {
+    s->handle = GetStdHandle(STD_INPUT_HANDLE);
+  }
+  else
+  {
+    s->handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                            NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    s->ownHandle = true;
+  }
+  if (s->handle == INVALID_HANDLE_VALUE || s->handle == NULL)
+  {
+    st_init(s);
+    return false;
+  }
+  InitializeCriticalSection(&s->lock);
+#else
+  if (useStdin)
+    s->fd = 0;
+  else
+    s->ownFd = true;
+  pthread_mutex_init(&s->lock, nullptr);
+#endif
+
+  s->state = STREAM_RUNNING;
+#ifdef _WIN32
+  s->thread = CreateThread(nullptr, 0, StreamThread, s, 0, nullptr);
+  s->threadStarted = s->thread != nullptr;
+#else
+  s->threadStarted = pthread_create(&s->thread, nullptr, StreamThread, s) == 0;
+#endif
+
+  if (!s->threadStarted)
+  {
+    s->state = STREAM_FAILED;
+    st_close(s);
+    return false;
+  }
+  return true;
+}
+
+void st_cancel(StreamSource* s)
+{
+  if (!s->threadStarted)
+    return;
+
+  STREAM_STORE_INT(&s->cancelRequested, 1);
+#ifdef _WIN32
+  CancelSynchronousIo(s->thread);
+#else
+  if (s->ownFd && STREAM_LOAD_INT(&s->fd) < 0)
+  {
+    int fd = open(s->path, O_WRONLY | O_NONBLOCK);
+    if (fd >= 0)
+      close(fd);
+  }
+#endif
+}
+
+void st_close(StreamSource* s)
+{
+  if (s->state == STREAM_IDLE)
+    return;
+
+  if (s->threadStarted)
+  {
+    st_cancel(s);
+#ifdef _WIN32
+    while (WaitForSingleObject(s->thread, 50) == WAIT_TIMEOUT)
+      CancelSynchronousIo(s->thread);
+    CloseHandle(s->thread);
+#else
+    pthread_join(s->thread, nullptr);
+#endif
+  }
+
+#ifdef _WIN32
+  if (s->ownHandle)
+    CloseHandle(s->handle);
+  DeleteCriticalSection(&s->lock);
+#else
+  if (s->ownFd && s->fd >= 0)
+    close(s->fd);
+  pthread_mutex_destroy(&s->lock);
+#endif
+
+  for (size_t i = 0; i < s->chunks.size(); i++)
+    sysFree(s->chunks[i].data);
+  st_init(s);
+}
+
+bool st_is_open(const StreamSource* s)
+{
+  return s->state != STREAM_IDLE;
+}
+
+int st_state(const StreamSource* s)
+{
+  return STREAM_LOAD_INT(&s->state);
+}
+
+uint64_t st_received(const StreamSource* s)
+{
+  return STREAM_LOAD(&s->received);
+}
+
+size_t st_available(StreamSource* s)
+{
+  if (!st_is_open(s))
+    return 0;
+
+  stream_lock(s);
+  size_t pending = (size_t)s->pending;
+  stream_unlock(s);
+  return pending;
+}
+
+size_t st_drain(StreamSource* s, uint8_t* out, size_t max)
+{
+  if (!st_is_open(s))
+    return 0;
+
+  size_t done = 0;
+  stream_lock(s);
+  while (done < max && !s->chunks.empty())
+  {
+    StreamChunk& first = s->chunks[0];
+    size_t take = first.length - s->consumed;
+    if (take > max - done)
+      take = max - done;
+    memCopy(out + done, first.data + s->consumed, take);
+    s->consumed += take;
+    done += take;
+
+    if (s->consumed < STREAM_CHUNK || s->chunks.size() == 1)
+      break;
+
+    sysFree(first.data);
+    s->chunks.remove(0);
+    s->consumed = 0;
+  }
+  s->pending -= done;
+  stream_unlock(s);
+  return done;
+}
+
+void st_store_init(StreamStore* store)
+{
+  store->slots = nullptr;
+  store->capacity = 0;
+  store->head = 0;
+  store->count = 0;
+  store->base = 0;
+  store->end = 0;
+}
+
+void st_store_free(StreamStore* store)
+{
+  for (size_t i = 0; i < store->count; i++)
+    sysFree(store->slots[(store->head + i) % store->capacity]);
+  if (store->slots)
+    sysFree(store->slots);
+  st_store_init(store);
+}
+
+static bool push_chunk(StreamStore* store)
+{
+  if (store->count == store->capacity)
+  {
+    size_t newCapacity = store->capacity ? store->capacity * 2 : 16;
+    uint8_t** slots = (uint8_t**)sysAlloc(newCapacity * sizeof(uint8_t*));
+    if (!slots)
+      return false;
+    for (size_t i = 0; i < store->count; i++)
+      slots[i] = store->slots[(store->head + i) % store->capacity];
+    if (store->slots)
+      sysFree(store->slots);
+    store->slots = slots;
+    store->capacity = newCapacity;
+    store->head = 0;
+  }
+
+  uint8_t* chunk = (uint8_t*)sysAlloc(STREAM_STORE_CHUNK);
+  if (!chunk)
+    return false;
+  store->slots[(store->head + store->count) % store->capacity] = chunk;
+  store->count++;
+  return true;
+}
+
+bool st_store_append(StreamStore* store, StreamSource* s, size_t max)
+{
+  size_t done = 0;
+  while (done < max)
+  {
+    uint64_t used = store->end - store->base;
+    if (used == (uint64_t)store->count * STREAM_STORE_CHUNK && !push_chunk(store))
+      return false;
+
+    size_t offset = (size_t)(used - (uint64_t)(store->count - 1) * STREAM_STORE_CHUNK);
+    uint8_t* last = store->slots[(store->head + store->count - 1) % store->capacity];
+    size_t room = STREAM_STORE_CHUNK - offset;
+    if (room > max - done)
+      room = max - done;
+
+    size_t got = st_drain(s, last + offset, room);
+    store->end += got;
+    done += got;
+    if (got < room)
+      break;
+  }
+  return true;
+}
+
+// Drops whole chunks once the store is a quarter over its limit, so the
+// offsets of what is kept shift rarely rather than on every append.
+uint64_t st_store_trim(StreamStore* store, uint64_t limit)
+{
+  uint64_t slack = limit / 4 > STREAM_STORE_CHUNK ? limit / 4 : STREAM_STORE_CHUNK;
+  if (store->end - store->base <= limit + slack)
+    return 0;
+
+  uint64_t dropped = 0;
+  while (store->count > 1 && store->end - store->base - STREAM_STORE_CHUNK >= limit)
+  {
+    sysFree(store->slots[store->head]);
+    store->head = (store->head + 1) % store->capacity;
+    store->count--;
+    store->base += STREAM_STORE_CHUNK;
+    dropped += STREAM_STORE_CHUNK;
+  }
+  return dropped;
+}
+
+uint64_t st_store_read(const StreamStore* store, uint64_t pos, uint8_t* out, uint64_t length)
+{
+  uint64_t done = 0;
+  while (done < length && pos + done >= store->base && pos + done < store->end)
+  {
+    uint64_t rel = pos + done - store->base;
+    size_t index = (size_t)(rel / STREAM_STORE_CHUNK);
+    size_t offset = (size_t)(rel % STREAM_STORE_CHUNK);
+    uint64_t take = STREAM_STORE_CHUNK - offset;
+    if (take > store->end - (pos + done))
+      take = store->end - (pos + done);
+    if (take > length - done)
+      take = length - done;
+
+    memCopy(out + done, store->slots[(store->head + index) % store->capacity] + offset, (size_t)take);
+    done += take;
+  }
+
+  if (done < length)
+    memSet(out + done, 0, (size_t)(length - done));
+  return done;
+}
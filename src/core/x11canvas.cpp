@@ -0,0 +1,468 @@
+#if !defined(_WIN32) && !defined(__APPLE__)
+
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include "x11canvas.h"
+
+static inline uint32_t blend(uint32_t dst, uint32_t src, uint32_t alpha)
+{
+  uint32_t inv = 255 - alpha;
+  uint32_t rb = (src & 0xFF00FF) * alpha + (dst & 0xFF00FF) * inv + 0x800080;
+  uint32_t g = (src & 0x00FF00) * alpha + (dst & 0x00FF00) * inv + 0x008000;
+  rb = ((rb + ((rb >> 8) & 0xFF00FF)) >> 8) & 0xFF00FF;
+  g = ((g + ((g >> 8) & 0x00FF00)) >> 8) & 0x00FF00;
+  return 0xFF000000 | rb | g;
+}
+
+static inline void put_pixel(uint32_t* dst, uint32_t argb, uint32_t alpha)
+{
+  if (alpha == 255)
+    *dst = argb | 0xFF000000;
+  else if (alpha)
+    *dst = blend(*dst, argb, alpha);
+}
+
+static bool shm_failed;
+
+static int shm_error_handler(Display*, XErrorEvent*)
+{
+  shm_failed = true;
+  return 0;
+}
+
+// MIT-SHM only works against a local server; a failed attach is reported
+// asynchronously, so it is trapped with a temporary handler and a sync.
+static bool create_shm_image(X11Canvas* c, Display* display, int width, int height)
+{
+  if (!XShmQueryExtension(display))
+    return false;
+
+  int screen = DefaultScreen(display);
+  XImage* image = XShmCreateImage(display, DefaultVisual(display, screen), DefaultDepth(display, screen),
+                                  ZPixmap, nullptr, &c->shmInfo, width, height);
+  if (!image)
+    return false;
+  if (image->bits_per_pixel != 32 || image->bytes_per_line != width * 4)
+  {
+    XDestroyImage(image);
+    return false;
+  }
+
+  c->shmInfo.shmid = shmget(IPC_PRIVATE, (size_t)image->bytes_per_line * height, IPC_CREAT | 0600);
+  if (c->shmInfo.shmid < 0)
+  {
+    XDestroyImage(image);
+    return false;
+  }
+
+  c->shmInfo.shmaddr = (char*)shmat(c->shmInfo.shmid, nullptr, 0);
+  if (c->shmInfo.shmaddr == (char*)-1)
+  {
+    shmctl(c->shmInfo.shmid, IPC_RMID, nullptr);
+    XDestroyImage(image);
+    return false;
+  }
+  c->shmInfo.readOnly = False;
+  image->data = c->shmInfo.shmaddr;
+
+  shm_failed = false;
+  XErrorHandler previous = XSetErrorHandler(shm_error_handler);
+  Status attached = XShmAttach(display, &c->shmInfo);
+  XSync(display, False);
+  XSetErrorHandler(previous);
+
+  // The segment stays alive until both sides detach.
+  shmctl(c->shmInfo.shmid, IPC_RMID, nullptr);
+
+  if (!attached || shm_failed)
+  {
+    shmdt(c->shmInfo.shmaddr);
+    image->data = nullptr;
+    XDestroyImage(image);
+    return false;
+  }
+
+  c->image = image;
+  c->pixels = (uint32_t*)c->shmInfo.shmaddr;
+  c->shm = true;
+  return true;
+}
+
+void ga_init(GlyphAtlas* a)
+{
+  a->coverage = nullptr;
+  a->cellWidth = 0;
+  a->cellHeight = 0;
+  a->ascent = 0;
+}
+
+// Rasterises the core font once through a scratch pixmap; text afterwards is
+// composited on the client without any per-string server requests.
+bool ga_build(GlyphAtlas* a, Display* display, Drawable drawable, XFontStruct* font)
+{
+  ga_free(a);
+  if (!display || !font)
+    return false;
+
+  int cellWidth = font->max_bounds.width;
+  int cellHeight = font->ascent + font->descent;
+  if (cellWidth <= 0 || cellHeight <= 0)
+    return false;
+
+  int stripWidth = cellWidth * GLYPH_COUNT;
+  Pixmap strip = XCreatePixmap(display, drawable, stripWidth, cellHeight,
+                               DefaultDepth(display, DefaultScreen(display)));
+  GC gc = XCreateGC(display, strip, 0, nullptr);
+  XSetFont(display, gc, font->fid);
+  XSetForeground(display, gc, 0);
+  XFillRectangle(display, strip, gc, 0, 0, stripWidth, cellHeight);
+  XSetForeground(display, gc, 0xFFFFFF);
+  for (int i = 0; i < GLYPH_COUNT; i++)
+  {
+    char ch = (char)i;
+    XDrawString(display, strip, gc, i * cellWidth, font->ascent, &ch, 1);
+  }
+
+  XImage* image = XGetImage(display, strip, 0, 0, stripWidth, cellHeight, AllPlanes, ZPixmap);
+  XFreeGC(display, gc);
+  XFreePixmap(display, strip);
+  if (!image)
+    return false;
+
+  size_t cellSize = (size_t)cellWidth * cellHeight;
+  a->coverage = (uint8_t*)sysAlloc(cellSize * GLYPH_COUNT);
+  if (!a->coverage)
+  {
+    XDestroyImage(image);
+    return false;
+  }
+
+  for (int i = 0; i < GLYPH_COUNT; i++)
+  {
+    uint8_t* cell = a->coverage + cellSize * i;
+    bool blank = true;
+    for (int y = 0; y < cellHeight; y++)
+    {
+      for (int x = 0; x < cellWidth; x++)
+      {
+        uint8_t cov = XGetPixel(image, i * cellWidth + x, y) ? 255 : 0;
+        cell[y * cellWidth + x] = cov;
+        blank = blank && cov == 0;
+      }
+    }
+    a->blank[i] = blank ? 1 : 0;
+  }
+  XDestroyImage(image);
+
+  a->cellWidth = cellWidth;
+  a->cellHeight = cellHeight;
+  a->ascent = font->ascent;
+  return true;
+}
+
+void ga_free(GlyphAtlas* a)
+{
+  if (a->coverage)
+    sysFree(a->coverage);
+  ga_init(a);
+}
+
+void xc_init(X11Canvas* c)
+{
+  c->display = nullptr;
+  c->image = nullptr;
+  c->pixels = nullptr;
+  c->width = 0;
+  c->height = 0;
+  c->shm = false;
+  xc_reset_clip(c);
+}
+
+bool xc_resize(X11Canvas* c, Display* display, int width, int height)
+{
+  xc_free(c);
+  c->display = display;
+
+  if (!create_shm_image(c, display, width, height))
+  {
+    int screen = DefaultScreen(display);
+    c->pixels = (uint32_t*)sysAlloc((size_t)width * height * 4);
+    if (!c->pixels)
+      return false;
+
+    c->image = XCreateImage(display, DefaultVisual(display, screen), DefaultDepth(display, screen),
+                            ZPixmap, 0, (char*)c->pixels, width, height, 32, width * 4);
+    if (!c->image)
+    {
+      sysFree(c->pixels);
+      c->pixels = nullptr;
+      return false;
+    }
+  }
+
+  c->width = width;
+  c->height = height;
+  xc_reset_clip(c);
+  return true;
+}
+
+void xc_free(X11Canvas* c)
+{
+  if (c->shm)
+  {
+    XShmDetach(c->display, &c->shmInfo);
+    XSync(c->display, False);
+  }
+  if (c->image)
+  {
+    // The pixel buffer is ours; stop XDestroyImage from freeing it.
+    c->image->data = nullptr;
+    XDestroyImage(c->image);
+  }
+  if (c->shm)
+    shmdt(c->shmInfo.shmaddr);
+  else if (c->pixels)
+    sysFree(c->pixels);
+  xc_init(c);
+}
+
+void xc_set_clip(X11Canvas* c, int x, int y, int width, int height)
+{
+  c->clipLeft = x < 0 ? 0 : x;
+  c->clipTop = y < 0 ? 0 : y;
+  c->clipRight = x + width > c->width ? c->width : x + width;
+  c->clipBottom = y + height > c->height ? c->height : y + height;
+}
+
+void xc_reset_clip(X11Canvas* c)
+{
+  c->clipLeft = 0;
+  c->clipTop = 0;
+  c->clipRight = c->width;
+  c->clipBottom = c->height;
+}
+
+void xc_fill_rect(X11Canvas* c, int x, int y, int width, int height, uint32_t argb)
+{
+  int x0 = x < c->clipLeft ? c->clipLeft : x;
+  int y0 = y < c->clipTop ? c->clipTop : y;
+  int x1 = x + width > c->clipRight ? c->clipRight : x + width;
+  int y1 = y + height > c->clipBottom ? c->clipBottom : y + height;
+  if (!c->pixels || x0 >= x1 || y0 >= y1)
+    return;
+
+  uint32_t alpha = argb >> 24;
+  if (alpha == 0)
+    return;
+
+  for (int row = y0; row < y1; row++)
+  {
+    uint32_t* p = c->pixels + (size_t)row * c->width;
+    if (alpha == 255)
+    {
+      for (int col = x0; col < x1; col++)
+        p[col] = argb;
+    }
+    else
+    {
+      for (int col = x0; col < x1; col++)
+        p[col] = blend(p[col], argb, alpha);
+    }
+  }
+}
+
+// Matches XDrawRectangle, which covers width + 1 by height + 1 pixels.
+void xc_frame_rect(X11Canvas* c, int x, int y, int width, int height, uint32_t argb)
+{
+  xc_fill_rect(c, x, y, width + 1, 1, argb);
+  xc_fill_rect(c, x, y + height, width + 1, 1, argb);
+  xc_fill_rect(c, x, y + 1, 1, height - 1, argb);
+  xc_fill_rect(c, x + width, y + 1, 1, height - 1, argb);
+}
+
+void xc_line(X11Canvas* c, int x1, int y1, int x2, int y2, uint32_t argb)
+{
+  if (!c->pixels)
+    return;
+
+  if (y1 == y2)
+  {
+    int lo = x1 < x2 ? x1 : x2;
+    int hi = x1 < x2 ? x2 : x1;
+    xc_fill_rect(c, lo, y1, hi - lo + 1, 1, argb);
+    return;
+  }
+  if (x1 == x2)
+  {
+    int lo = y1 < y2 ? y1 : y2;
+    int hi = y1 < y2 ? y2 : y1;
+    xc_fill_rect(c, x1, lo, 1, hi - lo + 1, argb);
+    return;
+  }
+
+  int dx = x2 > x1 ? x2 - x1 : x1 - x2;
+  int dy = y2 > y1 ? y1 - y2 : y2 - y1;
+  int sx = x1 < x2 ? 1 : -1;
+  int sy = y1 < y2 ? 1 : -1;
+  int err = dx + dy;
+  for (;;)
+  {
+    if (x1 >= c->clipLeft && x1 < c->clipRight && y1 >= c->clipTop && y1 < c->clipBottom)
+      put_pixel(&c->pixels[(size_t)y1 * c->width + x1], argb, argb >> 24);
+    if (x1 == x2 && y1 == y2)
+      break;
+    int e2 = 2 * err;
+    if (e2 >= dy)
+    {
+      err += dy;
+      x1 += sx;
+    }
+    if (e2 <= dx)
+    {
+      err += dx;
+      y1 += sy;
+    }
+  }
+}
+
+// Horizontal extent of an ellipse inscribed in a width x height box at a row.
+static bool ellipse_span(int width, int height, int row, int* left, int* right)
+{
+  double rx = width / 2.0;
+  double ry = height / 2.0;
+  double dy = (row + 0.5 - ry) / ry;
+  double t = 1.0 - dy * dy;
+  if (t < 0.0)
+    return false;
+
+  double half = rx * __builtin_sqrt(t);
+  *left = (int)(rx - half + 0.5);
+  *right = (int)(rx + half - 0.5);
+  return *left <= *right;
+}
+
+void xc_fill_ellipse(X11Canvas* c, int x, int y, int width, int height, uint32_t argb)
+{
+  for (int row = 0; row < height; row++)
+  {
+    int left, right;
+    if (ellipse_span(width, height, row, &left, &right))
+      xc_fill_rect(c, x + left, y + row, right - left + 1, 1, argb);
+  }
+}
+
+void xc_frame_ellipse(X11Canvas* c, int x, int y, int width, int height, uint32_t argb)
+{
+  for (int row = 0; row < height; row++)
+  {
+    int left, right;
+    if (!ellipse_span(width, height, row, &left, &right))
+      continue;
+
+    int innerLeft, innerRight;
+    if (row == 0 || row == height - 1 ||
+        !ellipse_span(width - 2, height - 2, row - 1, &innerLeft, &innerRight))
+    {
+      xc_fill_rect(c, x + left, y + row, right - left + 1, 1, argb);
+      continue;
+    }
+
+    innerLeft++;
+    innerRight++;
+    xc_fill_rect(c, x + left, y + row, innerLeft - left > 0 ? innerLeft - left : 1, 1, argb);
+    xc_fill_rect(c, x + innerRight + 1, y + row, right - innerRight > 0 ? right - innerRight : 1, 1, argb);
+  }
+}
+
+void xc_text(X11Canvas* c, const GlyphAtlas* a, const char* text, int x, int baseline, uint32_t argb)
+{
+  uint32_t alpha = argb >> 24;
+  if (!c->pixels || !a->coverage || !text || alpha == 0)
+    return;
+
+  int top = baseline - a->ascent;
+  int rowStart = top < c->clipTop ? c->clipTop - top : 0;
+  int rowEnd = top + a->cellHeight > c->clipBottom ? c->clipBottom - top : a->cellHeight;
+  if (rowStart >= rowEnd)
+    return;
+
+  size_t cellSize = (size_t)a->cellWidth * a->cellHeight;
+  for (const unsigned char* p = (const unsigned char*)text; *p; p++, x += a->cellWidth)
+  {
+    if (x >= c->clipRight)
+      break;
+    if (a->blank[*p] || x + a->cellWidth <= c->clipLeft)
+      continue;
+
+    const uint8_t* cell = a->coverage + cellSize * *p;
+    int colStart = x < c->clipLeft ? c->clipLeft - x : 0;
+    int colEnd = x + a->cellWidth > c->clipRight ? c->clipRight - x : a->cellWidth;
+
+    for (int row = rowStart; row < rowEnd; row++)
+    {
+      const uint8_t* cov = cell + row * a->cellWidth;
+      uint32_t* dst = c->pixels + (size_t)(top + row) * c->width + x;
+      for (int col = colStart; col < colEnd; col++)
+      {
+        if (cov[col])
+          put_pixel(&dst[col], argb, cov[col] * alpha / 255);
+      }
+    }
+  }
+}
+
+void xc_blit(X11Canvas* c, XImage* src, int width, int height, int x, int y)
+{
+  if (!c->pixels || !src)
+    return;
+
+  for (int row = 0; row < height; row++)
+  {
+    if (y + row < c->clipTop || y + row >= c->clipBottom)
+      continue;
+    uint32_t* dst = c->pixels + (size_t)(y + row) * c->width;
+    for (int col = 0; col < width; col++)
+    {
+      if (x + col >= c->clipLeft && x + col < c->clipRight)
+        dst[x + col] = 0xFF000000 | ((uint32_t)XGetPixel(src, col, row) & 0xFFFFFF);
+    }
+  }
+}
+
+void xc_present(X11Canvas* c, Drawable target, GC gc)
+{
+  xc_present_rect(c, target, gc, 0, 0, c->width, c->height);
+}
+
+void xc_present_rect(X11Canvas* c, Drawable target, GC gc, int x, int y, int width, int height)
+{
+  if (!c->image)
+    return;
+
+  int x0 = x < 0 ? 0 : x;
+  int y0 = y < 0 ? 0 : y;
+  int x1 = x + width > c->width ? c->width : x + width;
+  int y1 = y + height > c->height ? c->height : y + height;
+  if (x0 >= x1 || y0 >= y1)
+    return;
+
+  if (c->shm)
+    XShmPutImage(c->display, target, gc, c->image, x0, y0, x0, y0, x1 - x0, y1 - y0, False);
+  else
+    XPutImage(c->display, target, gc, c->image, x0, y0, x0, y0, x1 - x0, y1 - y0);
+}
+
+// The server reads shared memory lazily, so the next frame must not start
+// drawing until it is done; plain XPutImage has already copied the pixels.
+void xc_finish(X11Canvas* c)
+{
+  if (!c->display)
+    return;
+  if (c->shm)
+    XSync(c->display, False);
+  else
+    XFlush(c->display);
+}
+
+#endif
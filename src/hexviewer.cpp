@@ -11,6 +11,8 @@
 #include <X11/Xatom.h>
 #include <X11/keysym.h>
 #include <unistd.h>
+#include <poll.h>
+#include <sys/timerfd.h>
 #else
 #error "Unsupported platform"
 #endif
@@ -19,6 +21,10 @@
 #include "options.h"
 #include "menu.h"
 #include "hexdata.h"
+#include "filewatch.h"
+#include "documents.h"
+#include "frameprofile.h"
+#include "minimap.h"
 #include "global.h"
 #include "darkmode.h"
 #include "panelcontent.h"
@@ -36,7 +42,12 @@ void LoadDroppedFile(const char* path);
 void SaveOptionsToFile(const AppOptions &opts);
 void LoadOptionsFromFile(AppOptions &opts);
 void OnFileSaveAs();
+void InvalidateWindow();
 void LinuxRedraw();
+void LinuxPaint();
+void LinuxInvalidateMenuBar(int windowWidth);
+void LinuxInvalidateCaret();
+void LinuxBlinkCaret();
 void RebuildFileMenu();
 void OpenRecentFile(int index);
 void DIE_Analyze();
@@ -157,7 +168,11 @@ RenderManager g_Renderer;
 ScrollbarState g_MainScrollbar;
 SelectionState g_Selection;
 AppContextMenu g_ContextMenu;
-HexData g_HexData;
+HexData* g_HexData = nullptr;
+DocumentSet g_Documents;
+LineCache g_LineCache;
+FrameProfiler g_Profiler;
+Minimap g_Minimap;
 AppOptions g_Options;
 MenuBar g_MenuBar;
 LeftPanelState g_LeftPanel;
@@ -166,15 +181,16 @@ ChecksumResults g_Checksums;
 size_t editingOffset = (size_t)-1;
 
 extern char g_DIEExecutablePath[260];
+extern DetectItEasyState g_DIEState;
 const int PANEL_TITLE_HEIGHT = 28;
 int g_SearchCaretX = 0;
 int g_SearchCaretY = 0;
 int g_SearchBoxXStart = 0;
 bool caretVisible = true;
-int g_ScrollY = 0;
-int maxScrolls;
+long long g_ScrollY = 0;
+long long maxScrolls = 0;
 int g_LinesPerPage = 0;
-int g_TotalLines = 0;
+long long g_TotalLines = 0;
 bool darkmode = true;
 long long cursorBytePos = -1;
 int cursorNibblePos = 0;
@@ -188,6 +204,11 @@ int g_ResizeStartX = 0;
 int g_ResizeStartY = 0;
 int g_ResizeStartWidth = 0;
 int g_ResizeStartHeight = 0;
+FileWatch g_FileWatch;
+bool g_FollowTail = false;
+
+static void (*g_AfterLoad[MAX_AFTER_LOAD])();
+static int g_AfterLoadCount = 0;
 
 
 #if defined(_WIN32)
@@ -305,10 +326,10 @@ void CopyString(char *dest, const char *src, int maxLen)
 
 void ApplyEnabledPlugins()
 {
-	if (g_HexData.getFileSize() == 0)
+	if (g_HexData->getFileSize() == 0)
 		return;
 
-	g_HexData.clearAllPlugins();
+	g_HexData->clearAllPlugins();
 
 	if (g_Options.enabledPluginCount > 0)
 	{
@@ -324,22 +345,383 @@ void ApplyEnabledPlugins()
 #endif
 			strCopy(fullPath + len + 1, g_Options.enabledPlugins[i]);
 
-			g_HexData.addPlugin(fullPath);
+			g_HexData->addPlugin(fullPath);
+		}
+
+		if (g_HexData->hasPlugins())
+		{
+			int bpl = g_HexData->getCurrentBytesPerLine();
+			g_HexData->generateDisassemblyFromPlugin(bpl);
 		}
+	}
+
+	g_HexData->executeBookmarkPlugins();
+}
+
+void RunAfterLoad(void (*action)())
+{
+	if (!g_HexData->isLoading())
+	{
+		action();
+		return;
+	}
+
+	for (int i = 0; i < g_AfterLoadCount; i++)
+	{
+		if (g_AfterLoad[i] == action)
+			return;
+	}
+
+	if (g_AfterLoadCount < MAX_AFTER_LOAD)
+		g_AfterLoad[g_AfterLoadCount++] = action;
+}
+
+static void ScrollToTail()
+{
+	long long fileSize = (long long)g_HexData->getFileSize();
+	if (fileSize <= 0)
+		return;
+
+	cursorBytePos = fileSize - 1;
+	cursorNibblePos = 0;
+	g_ScrollY = (fileSize - 1) / 16 - g_LinesPerPage + 1;
+	if (g_ScrollY < 0)
+		g_ScrollY = 0;
+}
+
+static void ApplyStreamData(uint64_t dropped)
+{
+	g_TotalLines = (long long)g_HexData->getLineCount();
+
+	if (dropped > 0)
+	{
+		if (cursorBytePos >= 0)
+			cursorBytePos = cursorBytePos > (long long)dropped ? cursorBytePos - (long long)dropped : 0;
+		g_ScrollY -= (long long)(dropped / 16);
+		if (g_ScrollY < 0)
+			g_ScrollY = 0;
+		g_Selection.clear();
+	}
+
+	if (g_FollowTail)
+		ScrollToTail();
+}
+
+static void PollBackgroundDocuments()
+{
+	for (int i = 0; i < g_Documents.count; i++)
+	{
+		if (i == g_Documents.active)
+			continue;
+		HexData& data = g_Documents.items[i]->data;
+		data.pollStream();
+		data.pollLoad();
+	}
+}
+
+bool PollFileLoad()
+{
+	static int lastPermille = -1;
+	bool changed = false;
+
+	PollBackgroundDocuments();
+
+	uint64_t dropped = g_HexData->getStreamDropped();
+	if (g_HexData->pollStream())
+	{
+		ApplyStreamData(g_HexData->getStreamDropped() - dropped);
+		changed = true;
+	}
+	else if (g_HexData->isLoading() && !g_HexData->isStream())
+	{
+		int permille = (int)(g_HexData->getLoadProgress() * 1000.0f);
+		changed = permille != lastPermille;
+		lastPermille = permille;
+	}
+
+	if (!g_HexData->pollLoad())
+		return changed;
+
+	lastPermille = -1;
+	g_TotalLines = (long long)g_HexData->getLineCount();
+
+	int count = g_AfterLoadCount;
+	g_AfterLoadCount = 0;
+	for (int i = 0; i < count; i++)
+		g_AfterLoad[i]();
+	return true;
+}
+
+// Classifies another slice of the active file for the overview strip.
+bool PollMinimap()
+{
+	return mm_step(&g_Minimap, g_HexData, MINIMAP_SLICE_US);
+}
+
+static void SaveDocumentView(DocumentView* view)
+{
+	CopyString(view->path, g_CurrentFilePath, MAX_PATH_LEN);
+	view->cursorBytePos = cursorBytePos;
+	view->cursorNibblePos = cursorNibblePos;
+	view->scrollY = g_ScrollY;
+	view->selection = g_Selection;
+	view->bookmarks = g_Bookmarks;
+	view->byteStats = g_ByteStats;
+	view->die = g_DIEState;
+	view->followTail = g_FollowTail;
+	for (int i = 0; i < g_AfterLoadCount; i++)
+		view->afterLoad[i] = g_AfterLoad[i];
+	view->afterLoadCount = g_AfterLoadCount;
+}
+
+static void RestoreDocumentView(const DocumentView* view)
+{
+	CopyString(g_CurrentFilePath, view->path, MAX_PATH_LEN);
+	cursorBytePos = view->cursorBytePos;
+	cursorNibblePos = view->cursorNibblePos;
+	g_ScrollY = view->scrollY;
+	g_Selection = view->selection;
+	g_Bookmarks = view->bookmarks;
+	g_ByteStats = view->byteStats;
+	g_DIEState = view->die;
+	g_FollowTail = view->followTail;
+	for (int i = 0; i < view->afterLoadCount; i++)
+		g_AfterLoad[i] = view->afterLoad[i];
+	g_AfterLoadCount = view->afterLoadCount;
+
+	long long fileSize = (long long)g_HexData->getFileSize();
+	if (cursorBytePos >= fileSize)
+		cursorBytePos = fileSize - 1;
+	g_TotalLines = (long long)g_HexData->getLineCount();
+	g_PatternSearch.lastMatch = -1;
+	editingOffset = (size_t)-1;
+
+	// A background document may have finished loading while it was hidden.
+	if (!g_HexData->isLoading() && g_AfterLoadCount > 0)
+	{
+		int count = g_AfterLoadCount;
+		g_AfterLoadCount = 0;
+		for (int i = 0; i < count; i++)
+			g_AfterLoad[i]();
+	}
+}
 
-		if (g_HexData.hasPlugins())
+static int NewDocument()
+{
+	int index = ds_add(&g_Documents);
+	if (index < 0)
+		return -1;
+
+	HexData& data = g_Documents.items[index]->data;
+	data.setOffsetShiftCallback(Bookmarks_ShiftOffsets);
+	data.setStreamLimit((uint64_t)g_Options.streamBufferMB * 1024 * 1024);
+	return index;
+}
+
+static void InitDocuments()
+{
+	ds_init(&g_Documents);
+	ds_activate(&g_Documents, NewDocument());
+	g_HexData = &ds_active(&g_Documents)->data;
+}
+
+void SwitchDocument(int index)
+{
+	if (index < 0 || index >= g_Documents.count || index == g_Documents.active)
+		return;
+
+	SaveDocumentView(&ds_active(&g_Documents)->view);
+	ds_activate(&g_Documents, index);
+	g_HexData = &ds_active(&g_Documents)->data;
+	RestoreDocumentView(&ds_active(&g_Documents)->view);
+	InvalidateWindow();
+}
+
+static void CloseDocument(int index)
+{
+	if (index < 0 || index >= g_Documents.count)
+		return;
+
+	// A later document may be allocated at the same address.
+	lc_invalidate(&g_LineCache);
+	g_Minimap.owner = nullptr;
+
+	if (g_Documents.count == 1)
+	{
+		ds_remove(&g_Documents, 0);
+		InitDocuments();
+		RestoreDocumentView(&ds_active(&g_Documents)->view);
+		InvalidateWindow();
+		return;
+	}
+
+	if (index != g_Documents.active)
+	{
+		ds_remove(&g_Documents, index);
+		InvalidateWindow();
+		return;
+	}
+
+	ds_remove(&g_Documents, index);
+	ds_activate(&g_Documents, index < g_Documents.count ? index : g_Documents.count - 1);
+	g_HexData = &ds_active(&g_Documents)->data;
+	RestoreDocumentView(&ds_active(&g_Documents)->view);
+	InvalidateWindow();
+}
+
+void OnCloseDocument()
+{
+	CloseDocument(g_Documents.active);
+}
+
+void CycleDocument(int step)
+{
+	if (g_Documents.count < 2)
+		return;
+	SwitchDocument((g_Documents.active + step + g_Documents.count) % g_Documents.count);
+}
+
+static DocumentTab g_DocumentTabs[MAX_DOCUMENTS];
+static int g_DocumentTabCount = 0;
+
+static void BuildTabLabel(Document* doc, const char* path, char* label, int maxLen)
+{
+	const char* name = path;
+	for (const char* p = path; *p; p++)
+	{
+		if (*p == '/' || *p == '\\')
+			name = p + 1;
+	}
+	if (!*name)
+		name = doc->data.isStream() ? "Stream" : "Untitled";
+
+	CopyString(label, name, 21);
+	if (strLen(name) > 20)
+		strCopy(label + 17, "...");
+	if (doc->data.isModified())
+		CopyString(label + strLen(label), " *", maxLen - (int)strLen(label));
+}
+
+void DrawDocumentTabs(int windowWidth)
+{
+	g_DocumentTabCount = 0;
+	if (g_Documents.count < 2)
+		return;
+
+	int widths[MAX_DOCUMENTS];
+	int total = 0;
+	for (int i = 0; i < g_Documents.count; i++)
+	{
+		Document* doc = g_Documents.items[i];
+		const char* path = i == g_Documents.active ? g_CurrentFilePath : doc->view.path;
+		BuildTabLabel(doc, path, g_DocumentTabs[i].label, sizeof(g_DocumentTabs[i].label));
+		widths[i] = g_Renderer.measureTextWidth(g_DocumentTabs[i].label) + 20;
+		total += widths[i];
+	}
+
+	int x = windowWidth - total - 10;
+	int height = g_MenuBar.getHeight() - 1;
+	for (int i = 0; i < g_Documents.count; i++)
+	{
+		g_DocumentTabs[i].bounds = Rect(x, 0, widths[i], height);
+		x += widths[i];
+	}
+	g_DocumentTabCount = g_Documents.count;
+
+	g_Renderer.drawDocumentTabs(g_DocumentTabs, g_DocumentTabCount, g_Documents.active,
+		g_Options.darkMode ? Theme::Dark() : Theme::Light());
+}
+
+bool HandleDocumentTabClick(int x, int y)
+{
+	for (int i = 0; i < g_DocumentTabCount; i++)
+	{
+		if (g_DocumentTabs[i].bounds.contains(x, y))
 		{
-			int bpl = g_HexData.getCurrentBytesPerLine();
-			g_HexData.generateDisassemblyFromPlugin(bpl);
+			SwitchDocument(i);
+			return true;
 		}
 	}
+	return false;
+}
+
+// Centers the view on the part of the file under the click and moves the
+// caret there.
+bool HandleMinimapClick(int x, int y)
+{
+	const Rect& bounds = g_Renderer.getMinimapRect();
+	uint64_t fileSize = g_HexData->getFileSize();
+	if (fileSize == 0 || bounds.height <= 0 || !bounds.contains(x, y))
+		return false;
+
+	uint64_t offset = fileSize * (uint64_t)(y - bounds.y) / (uint64_t)bounds.height;
+	if (offset >= fileSize)
+		offset = fileSize - 1;
+
+	long long maxScroll = g_TotalLines - g_LinesPerPage;
+	if (maxScroll < 0)
+		maxScroll = 0;
+
+	g_ScrollY = (long long)(offset / 16) - g_LinesPerPage / 2;
+	if (g_ScrollY < 0)
+		g_ScrollY = 0;
+	if (g_ScrollY > maxScroll)
+		g_ScrollY = maxScroll;
+
+	cursorBytePos = (long long)offset;
+	cursorNibblePos = 0;
+	caretVisible = true;
+	g_Selection.clear();
+	return true;
+}
+
+// Opens into a new tab unless the current one is still empty; on failure the
+// previously active document is brought back.
+static bool OpenInDocument(const char* path)
+{
+	int previous = g_Documents.active;
+	bool reuse = g_HexData->getFileSize() == 0 && !g_HexData->isLoading() && !g_HexData->isModified();
+
+	if (!reuse)
+	{
+		int index = NewDocument();
+		if (index < 0)
+			return false;
+		SwitchDocument(index);
+	}
+
+	if (g_HexData->loadFile(path))
+		return true;
+
+	if (!reuse)
+	{
+		lc_invalidate(&g_LineCache);
+		g_Minimap.owner = nullptr;
+		ds_remove(&g_Documents, g_Documents.active);
+		ds_activate(&g_Documents, previous);
+		g_HexData = &ds_active(&g_Documents)->data;
+		RestoreDocumentView(&ds_active(&g_Documents)->view);
+	}
+	return false;
+}
 
-	g_HexData.executeBookmarkPlugins();
+void PollMemoryBudget()
+{
+	static uint64_t lastCheck = 0;
+	uint64_t now = sr_now_us();
+	if (now - lastCheck < 2000000)
+		return;
+	lastCheck = now;
+
+	uint64_t bytesPerLine = (uint64_t)g_HexData->getCurrentBytesPerLine();
+	uint64_t keepOffset = (uint64_t)g_ScrollY * bytesPerLine;
+	uint64_t keepLength = (uint64_t)(g_LinesPerPage + 1) * bytesPerLine;
+	ds_enforce_budget(&g_Documents, (uint64_t)g_Options.memoryBudgetMB * 1024 * 1024, keepOffset, keepLength);
 }
 
 void OnNew()
 {
-	g_HexData.clear();
+	g_HexData->clear();
 	g_CurrentFilePath[0] = '\0';
 	g_ScrollY = 0;
 	g_TotalLines = 0;
@@ -384,17 +766,17 @@ void OnFileOpen()
 
 	if (GetOpenFileNameA(&ofn))
 	{
-		if (g_HexData.loadFile(ofn.lpstrFile))
+		if (OpenInDocument(ofn.lpstrFile))
 		{
 			strCopy(g_CurrentFilePath, ofn.lpstrFile);
 			AddToRecentFiles(ofn.lpstrFile);
 			SaveOptionsToFile(g_Options);
 			RebuildFileMenu();
 
-			ApplyEnabledPlugins();
-			DIE_Analyze();
+			RunAfterLoad(ApplyEnabledPlugins);
+			RunAfterLoad(DIE_Analyze);
 
-			g_TotalLines = (int)g_HexData.getHexLines().count;
+			g_TotalLines = (long long)g_HexData->getLineCount();
 			g_ScrollY = 0;
 
 			RECT rc;
@@ -426,16 +808,16 @@ void OnFileOpen()
 		NSURL* url = [[panel URLs]objectAtIndex:0];
 		const char* path = [[url path]UTF8String];
 
-		if (g_HexData.loadFile(path))
+		if (OpenInDocument(path))
 		{
 			strCopy(g_CurrentFilePath, path);
 			AddToRecentFiles(path);
 			SaveOptionsToFile(g_Options);
 			RebuildFileMenu();
 
-			ApplyEnabledPlugins();
+			RunAfterLoad(ApplyEnabledPlugins);
 
-			g_TotalLines = (int)g_HexData.getHexLines().count;
+			g_TotalLines = (long long)g_HexData->getLineCount();
 			g_ScrollY = 0;
 
 			if (g_Hwnd) {
@@ -473,16 +855,16 @@ void OnFileOpen()
 	if (len > 0 && path[len - 1] == '\n')
 		path[len - 1] = 0;
 
-	if (g_HexData.loadFile(path))
+	if (OpenInDocument(path))
 	{
 		strCopy(g_CurrentFilePath, path);
 		AddToRecentFiles(path);
 		SaveOptionsToFile(g_Options);
 		RebuildFileMenu();
 
-		ApplyEnabledPlugins();
+		RunAfterLoad(ApplyEnabledPlugins);
 
-		g_TotalLines = (int)g_HexData.getHexLines().count;
+		g_TotalLines = (long long)g_HexData->getLineCount();
 		g_ScrollY = 0;
 		LinuxRedraw();
 	}
@@ -501,8 +883,9 @@ void OnFileSave()
 		return;
 	}
 
-	if (g_HexData.saveFile(g_CurrentFilePath))
+	if (g_HexData->saveFile(g_CurrentFilePath))
 	{
+		fw_sync(&g_FileWatch);
 #if defined(_WIN32)
 		MessageBoxA(g_Hwnd, "File saved successfully.", "Info", MB_OK | MB_ICONINFORMATION);
 #elif defined(__APPLE__)
@@ -550,7 +933,7 @@ void OnFileSaveAs()
 
 	if (GetSaveFileNameA(&ofn))
 	{
-		if (g_HexData.saveFile(ofn.lpstrFile))
+		if (g_HexData->saveFile(ofn.lpstrFile))
 		{
 			CopyString(g_CurrentFilePath, ofn.lpstrFile, MAX_PATH_LEN);
 			MessageBoxA(g_Hwnd, "File saved successfully.", "Info", MB_OK | MB_ICONINFORMATION);
@@ -569,7 +952,7 @@ void OnFileSaveAs()
 		NSURL* url = [panel URL];
 		const char* path = [[url path]UTF8String];
 
-		if (g_HexData.saveFile(path))
+		if (g_HexData->saveFile(path))
 		{
 			CopyString(g_CurrentFilePath, path, MAX_PATH_LEN);
 			NSAlert* alert = [[NSAlert alloc]init];
@@ -750,17 +1133,17 @@ void OpenRecentFile(int index)
 	if (index < 0 || index >= g_RecentFileCount)
 		return;
 
-	if (g_HexData.loadFile(g_RecentFiles[index]))
+	if (OpenInDocument(g_RecentFiles[index]))
 	{
 		strCopy(g_CurrentFilePath, g_RecentFiles[index]);
 		AddToRecentFiles(g_RecentFiles[index]);
 		SaveOptionsToFile(g_Options);
 		RebuildFileMenu();
 
-		ApplyEnabledPlugins();
-		DIE_Analyze();
+		RunAfterLoad(ApplyEnabledPlugins);
+		RunAfterLoad(DIE_Analyze);
 
-		g_TotalLines = (int)g_HexData.getHexLines().count;
+		g_TotalLines = (long long)g_HexData->getLineCount();
 		g_ScrollY = 0;
 
 #if defined(_WIN32)
@@ -828,19 +1211,19 @@ void OnfindReplace()
 void OnGoTo()
 {
 #if defined(_WIN32)
-	static int resultOffset = -1;
+	static long long resultOffset = -1;
 	resultOffset = -1;
 
 	SearchDialogs::ShowGoToDialog(
 		g_Hwnd,
 		g_Options.darkMode,
-		[](int offset)
+		[](long long offset)
 		{
 			resultOffset = offset;
 		},
 		nullptr);
 
-	if (resultOffset >= 0 && resultOffset < (long long)g_HexData.getFileSize())
+	if (resultOffset >= 0 && resultOffset < (long long)g_HexData->getFileSize())
 	{
 		cursorBytePos = resultOffset;
 		cursorNibblePos = 0;
@@ -860,11 +1243,11 @@ void OnGoTo()
 
 		long long targetLine = resultOffset / 16;
 
-		g_ScrollY = (int)(targetLine - g_LinesPerPage / 2);
+		g_ScrollY = (long long)(targetLine - g_LinesPerPage / 2);
 		if (g_ScrollY < 0)
 			g_ScrollY = 0;
 
-		int maxScroll = g_TotalLines - g_LinesPerPage;
+		long long maxScroll = g_TotalLines - g_LinesPerPage;
 		if (maxScroll < 0)
 			maxScroll = 0;
 
@@ -873,7 +1256,7 @@ void OnGoTo()
 
 		if (maxScroll > 0)
 		{
-			g_MainScrollbar.position = (float)g_ScrollY / (float)maxScroll;
+			g_MainScrollbar.position = (float)((double)g_ScrollY / (double)maxScroll);
 			if (g_MainScrollbar.position < 0.0f) g_MainScrollbar.position = 0.0f;
 			if (g_MainScrollbar.position > 1.0f) g_MainScrollbar.position = 1.0f;
 		}
@@ -891,34 +1274,34 @@ void OnGoTo()
 		InvalidateRect(g_Hwnd, NULL, TRUE);
 		UpdateWindow(g_Hwnd);
 	}
-	else if (resultOffset >= (long long)g_HexData.getFileSize())
+	else if (resultOffset >= (long long)g_HexData->getFileSize())
 	{
 		MessageBoxA(g_Hwnd, "Offset out of range.", "Error", MB_OK | MB_ICONERROR);
 	}
 #elif defined(__APPLE__)
-	static int resultOffset = -1;
+	static long long resultOffset = -1;
 	resultOffset = -1;
 
 	SearchDialogs::ShowGoToDialog(
 		g_Hwnd,
 		g_Options.darkMode,
-		[](int offset)
+		[](long long offset)
 		{
 			resultOffset = offset;
 		});
 
-	if (resultOffset >= 0 && resultOffset < (long long)g_HexData.getFileSize())
+	if (resultOffset >= 0 && resultOffset < (long long)g_HexData->getFileSize())
 	{
 		cursorBytePos = resultOffset;
 		cursorNibblePos = 0;
 
 		long long targetLine = resultOffset / 16;
 
-		g_ScrollY = (int)(targetLine - g_LinesPerPage / 2);
+		g_ScrollY = (long long)(targetLine - g_LinesPerPage / 2);
 		if (g_ScrollY < 0)
 			g_ScrollY = 0;
 
-		int maxScroll = g_TotalLines - g_LinesPerPage;
+		long long maxScroll = g_TotalLines - g_LinesPerPage;
 		if (maxScroll < 0)
 			maxScroll = 0;
 
@@ -927,7 +1310,7 @@ void OnGoTo()
 
 		if (maxScroll > 0)
 		{
-			g_MainScrollbar.position = (float)g_ScrollY / (float)maxScroll;
+			g_MainScrollbar.position = (float)((double)g_ScrollY / (double)maxScroll);
 			if (g_MainScrollbar.position < 0.0f) g_MainScrollbar.position = 0.0f;
 			if (g_MainScrollbar.position > 1.0f) g_MainScrollbar.position = 1.0f;
 		}
@@ -947,34 +1330,34 @@ void OnGoTo()
 			[[window contentView]setNeedsDisplay:YES];
 		}
 	}
-	else if (resultOffset >= (long long)g_HexData.getFileSize())
+	else if (resultOffset >= (long long)g_HexData->getFileSize())
 	{
-		printf("Offset out of range: 0x%X\n", resultOffset);
+		printf("Offset out of range: 0x%llX\n", resultOffset);
 	}
 #else
-	static int resultOffset = -1;
+	static long long resultOffset = -1;
 	resultOffset = -1;
 
 	SearchDialogs::ShowGoToDialog(
 		g_Hwnd,
 		g_Options.darkMode,
-		[](int offset)
+		[](long long offset)
 		{
 			resultOffset = offset;
 		});
 
-	if (resultOffset >= 0 && resultOffset < (long long)g_HexData.getFileSize())
+	if (resultOffset >= 0 && resultOffset < (long long)g_HexData->getFileSize())
 	{
 		cursorBytePos = resultOffset;
 		cursorNibblePos = 0;
 
 		long long targetLine = resultOffset / 16;
 
-		g_ScrollY = (int)(targetLine - g_LinesPerPage / 2);
+		g_ScrollY = (long long)(targetLine - g_LinesPerPage / 2);
 		if (g_ScrollY < 0)
 			g_ScrollY = 0;
 
-		int maxScroll = g_TotalLines - g_LinesPerPage;
+		long long maxScroll = g_TotalLines - g_LinesPerPage;
 		if (maxScroll < 0)
 			maxScroll = 0;
 
@@ -983,7 +1366,7 @@ void OnGoTo()
 
 		if (maxScroll > 0)
 		{
-			g_MainScrollbar.position = (float)g_ScrollY / (float)maxScroll;
+			g_MainScrollbar.position = (float)((double)g_ScrollY / (double)maxScroll);
 			if (g_MainScrollbar.position < 0.0f) g_MainScrollbar.position = 0.0f;
 			if (g_MainScrollbar.position > 1.0f) g_MainScrollbar.position = 1.0f;
 		}
@@ -1000,13 +1383,185 @@ void OnGoTo()
 
 		LinuxRedraw();
 	}
-	else if (resultOffset >= (long long)g_HexData.getFileSize())
+	else if (resultOffset >= (long long)g_HexData->getFileSize())
 	{
-		printf("Offset out of range: 0x%X\n", resultOffset);
+		printf("Offset out of range: 0x%llX\n", resultOffset);
 	}
 #endif
 }
 
+static void RevealCursor()
+{
+	long long cursorLine = cursorBytePos / 16;
+	if (cursorLine < g_ScrollY || cursorLine >= g_ScrollY + g_LinesPerPage)
+	{
+		g_ScrollY = cursorLine - g_LinesPerPage / 2;
+		if (g_ScrollY > maxScrolls)
+			g_ScrollY = maxScrolls;
+		if (g_ScrollY < 0)
+			g_ScrollY = 0;
+	}
+}
+
+static void ApplyHistoryStep(bool redo)
+{
+	uint64_t offset = 0;
+	bool changed = redo ? g_HexData->redo(&offset) : g_HexData->undo(&offset);
+	if (!changed)
+		return;
+
+	long long fileSize = (long long)g_HexData->getFileSize();
+	cursorBytePos = (long long)offset;
+	if (cursorBytePos >= fileSize)
+		cursorBytePos = fileSize > 0 ? fileSize - 1 : -1;
+	cursorNibblePos = 0;
+	g_Selection.clear();
+	RevealCursor();
+	InvalidateWindow();
+}
+
+void OnUndo()
+{
+	ApplyHistoryStep(false);
+}
+
+void OnRedo()
+{
+	ApplyHistoryStep(true);
+}
+
+void OnDeleteBytes()
+{
+	long long start = cursorBytePos;
+	long long end = cursorBytePos;
+	if (g_Selection.active)
+		g_Selection.getRange(start, end);
+
+	if (start < 0 || !g_HexData->deleteBytes((uint64_t)start, (uint64_t)(end - start + 1)))
+		return;
+
+	long long fileSize = (long long)g_HexData->getFileSize();
+	cursorBytePos = start < fileSize ? start : fileSize - 1;
+	cursorNibblePos = 0;
+	g_Selection.clear();
+	InvalidateWindow();
+}
+
+static void JumpToDataExtent(bool forward)
+{
+	uint64_t from = cursorBytePos >= 0 ? (uint64_t)cursorBytePos : 0;
+	uint64_t target;
+	if (!g_HexData->findDataExtent(from, forward, &target))
+		return;
+
+	cursorBytePos = (long long)target;
+	cursorNibblePos = 0;
+	g_Selection.clear();
+	RevealCursor();
+	InvalidateWindow();
+}
+
+void OnNextDataExtent()
+{
+	JumpToDataExtent(true);
+}
+
+void OnPrevDataExtent()
+{
+	JumpToDataExtent(false);
+}
+
+void OnToggleFollowTail()
+{
+	g_FollowTail = !g_FollowTail;
+}
+
+// Shown once per load: the watcher fires on every further write.
+static void WarnUndetachedEdits()
+{
+	static uint64_t warnedContent = 0;
+	if (warnedContent == g_HexData->getContentId())
+		return;
+	warnedContent = g_HexData->getContentId();
+
+#if defined(_WIN32)
+	MessageBoxA(g_Hwnd, "The file was changed on disk and the unsaved edits are too large to keep apart from it.\n"
+		"Further changes to the file will show through; save to a new file to keep the current contents.",
+		"Warning", MB_OK | MB_ICONWARNING);
+#elif defined(__APPLE__)
+	NSAlert* alert = [[NSAlert alloc]init];
+	[alert setMessageText:@"File changed on disk"] ;
+	[alert setInformativeText:@"The unsaved edits are too large to keep apart from the file. Further changes to the file will show through; save to a new file to keep the current contents."] ;
+	[alert setAlertStyle:NSAlertStyleWarning] ;
+	[alert runModal] ;
+#else
+	fprintf(stderr, "File changed on disk; unsaved edits are too large to keep apart from it. "
+		"Save to a new file to keep the current contents.\n");
+#endif
+}
+
+void PollFileWatch()
+{
+	// Unsaved edits are watched even without autoReload, so a file changed
+	// underneath them can be detached before it changes again.
+	bool watch = g_Options.autoReload || g_HexData->isModified();
+	if (!watch || g_CurrentFilePath[0] == '\0' || !g_HexData->isMapped())
+	{
+		fw_stop(&g_FileWatch);
+		return;
+	}
+
+	if (!fw_is_watching(&g_FileWatch, g_CurrentFilePath))
+	{
+		fw_start(&g_FileWatch, g_CurrentFilePath);
+		return;
+	}
+
+	if (!fw_poll(&g_FileWatch))
+		return;
+
+	ReloadResult result = g_Options.autoReload ?
+		g_HexData->reloadFromDisk(g_CurrentFilePath) :
+		g_HexData->detachFromDisk(g_CurrentFilePath);
+	if (result == RELOAD_NONE || result == RELOAD_FAILED)
+		return;
+	if (result == RELOAD_UNDETACHED)
+		WarnUndetachedEdits();
+
+	long long fileSize = (long long)g_HexData->getFileSize();
+	g_TotalLines = (long long)g_HexData->getLineCount();
+
+	if (cursorBytePos >= fileSize)
+		cursorBytePos = fileSize - 1;
+	if (g_Selection.active && (g_Selection.startByte >= fileSize || g_Selection.endByte >= fileSize))
+		g_Selection.clear();
+	Bookmarks_UpdateValues();
+
+	if (g_FollowTail && result == RELOAD_APPENDED)
+		ScrollToTail();
+
+	InvalidateWindow();
+}
+
+void OnInsertBytes()
+{
+	long long start = cursorBytePos;
+	if (g_Selection.active)
+	{
+		long long end;
+		g_Selection.getRange(start, end);
+	}
+
+	uint8_t zero = 0;
+	if (start < 0 || !g_HexData->insertBytes((uint64_t)start, &zero, 1))
+		return;
+
+	cursorBytePos = start;
+	cursorNibblePos = 0;
+	g_Selection.clear();
+	InvalidateWindow();
+}
+
 void OnToggleDarkMode()
 {
 	g_Options.darkMode = !g_Options.darkMode;
@@ -1045,15 +1600,15 @@ void OnDocumentation() {}
 
 void LoadDroppedFile(const char* path)
 {
-	if (g_HexData.loadFile(path))
+	if (OpenInDocument(path))
 	{
 		strCopy(g_CurrentFilePath, path);
 		AddToRecentFiles(path);
 		SaveOptionsToFile(g_Options);
 		RebuildFileMenu();
-		ApplyEnabledPlugins();
-		DIE_Analyze();
-		g_TotalLines = (int)g_HexData.getHexLines().count;
+		RunAfterLoad(ApplyEnabledPlugins);
+		RunAfterLoad(DIE_Analyze);
+		g_TotalLines = (long long)g_HexData->getLineCount();
 		g_ScrollY = 0;
 
 #if defined(_WIN32)
@@ -1077,8 +1632,23 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 	{
 	case WM_TIMER:
 	{
+		if (wParam == 2)
+		{
+			if (!g_HexData->isLoading() && !mm_is_building(&g_Minimap))
+				KillTimer(hwnd, 2);
+			if (PollFileLoad())
+				InvalidateRect(hwnd, NULL, FALSE);
+			if (PollMinimap())
+				InvalidateRect(hwnd, NULL, FALSE);
+		}
 		if (wParam == 1)
 		{
+			if (PollFileLoad())
+				InvalidateRect(hwnd, NULL, FALSE);
+			if (PollMinimap())
+				InvalidateRect(hwnd, NULL, FALSE);
+			PollFileWatch();
+			PollMemoryBudget();
 			caretVisible = !caretVisible;
 			if (g_PatternSearch.hasFocus || cursorBytePos >= 0)
 			{
@@ -1130,15 +1700,15 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 		char path[MAX_PATH];
 		if (DragQueryFileA(hDrop, 0, path, MAX_PATH))
 		{
-			if (g_HexData.loadFile(path))
+			if (OpenInDocument(path))
 			{
 				strCopy(g_CurrentFilePath, path);
 				AddToRecentFiles(path);
 				SaveOptionsToFile(g_Options);
 				RebuildFileMenu();
-				ApplyEnabledPlugins();
+				RunAfterLoad(ApplyEnabledPlugins);
 
-				g_TotalLines = (int)g_HexData.getHexLines().count;
+				g_TotalLines = (long long)g_HexData->getLineCount();
 				g_ScrollY = 0;
 
 				InvalidateRect(hwnd, NULL, FALSE);
@@ -1176,10 +1746,10 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 	{
 		int delta = GET_WHEEL_DELTA_WPARAM(wParam);
 		int lines = delta / WHEEL_DELTA;
-		int oldY = g_ScrollY;
+		long long oldY = g_ScrollY;
 		g_ScrollY -= lines * 3;
 
-		int maxScroll = g_TotalLines - g_LinesPerPage;
+		long long maxScroll = g_TotalLines - g_LinesPerPage;
 		if (maxScroll < 0)
 			maxScroll = 0;
 
@@ -1190,7 +1760,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 
 		if (maxScroll > 0)
 		{
-			g_MainScrollbar.position = (float)g_ScrollY / (float)maxScroll;
+			g_MainScrollbar.position = (float)((double)g_ScrollY / (double)maxScroll);
 
 			if (g_MainScrollbar.position < 0.0f)
 				g_MainScrollbar.position = 0.0f;
@@ -1252,7 +1822,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 
 		if (g_MainScrollbar.pressed)
 		{
-			int maxScroll = g_TotalLines - g_LinesPerPage;
+			long long maxScroll = g_TotalLines - g_LinesPerPage;
 			if (maxScroll < 0)
 				maxScroll = 0;
 
@@ -1270,7 +1840,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 					newPos = 1.0f;
 
 				g_MainScrollbar.position = newPos;
-				g_ScrollY = (int)(newPos * maxScroll);
+				g_ScrollY = (long long)((double)newPos * (double)maxScroll);
 
 				if (g_ScrollY < 0)
 					g_ScrollY = 0;
@@ -1453,7 +2023,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 				BytePositionInfo hoverInfo = g_Renderer.GetHexBytePositionInfo(Point(x, y));
 
 				if (hoverInfo.Index >= 0 &&
-					hoverInfo.Index < (long long)g_HexData.getFileSize())
+					hoverInfo.Index < (long long)g_HexData->getFileSize())
 				{
 					g_Selection.endByte = hoverInfo.Index;
 					cursorBytePos = hoverInfo.Index;
@@ -1462,11 +2032,11 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 					long long cursorLine = hoverInfo.Index / 16;
 					if (cursorLine < g_ScrollY)
 					{
-						g_ScrollY = (int)cursorLine;
+						g_ScrollY = cursorLine;
 					}
 					else if (cursorLine >= g_ScrollY + g_LinesPerPage)
 					{
-						g_ScrollY = (int)(cursorLine - g_LinesPerPage + 1);
+						g_ScrollY = (long long)(cursorLine - g_LinesPerPage + 1);
 					}
 
 					InvalidateRect(hwnd, NULL, FALSE);
@@ -1635,11 +2205,11 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 			float newPos = g_Renderer.getScrollbarPositionFromMouse(
 				y, g_MainScrollbar, true);
 
-			int maxScroll = g_TotalLines - g_LinesPerPage;
+			long long maxScroll = g_TotalLines - g_LinesPerPage;
 			if (maxScroll < 0)
 				maxScroll = 0;
 
-			g_ScrollY = (int)(newPos * maxScroll);
+			g_ScrollY = (long long)((double)newPos * (double)maxScroll);
 
 			if (g_ScrollY < 0)
 				g_ScrollY = 0;
@@ -1652,6 +2222,12 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 			return 0;
 		}
 
+		if (HandleMinimapClick(x, y))
+		{
+			InvalidateRect(hwnd, NULL, FALSE);
+			return 0;
+		}
+
 		if (g_Renderer.isPointInDisasmResizeHandle(x, y, g_MenuBar.getHeight()))
 		{
 			g_Renderer.startDisasmResize(x);
@@ -1666,6 +2242,12 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 			return 0;
 		}
 
+		if (HandleDocumentTabClick(x, y))
+		{
+			InvalidateRect(hwnd, NULL, FALSE);
+			return 0;
+		}
+
 		if (g_BottomPanel.visible)
 		{
 			Rect bottomBounds = GetBottomPanelBounds(
@@ -1844,7 +2426,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 				g_Renderer.GetHexBytePositionInfo(Point(x, y));
 
 			if (clickInfo.Index >= 0 &&
-				clickInfo.Index < (long long)g_HexData.getFileSize())
+				clickInfo.Index < (long long)g_HexData->getFileSize())
 			{
 				bool shiftHeld = (GetKeyState(VK_SHIFT) & 0x8000) != 0;
 
@@ -1922,7 +2504,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 			return 0;
 		}
 
-		if (cursorBytePos >= 0 && cursorBytePos < (long long)g_HexData.getFileSize())
+		if (cursorBytePos >= 0 && cursorBytePos < (long long)g_HexData->getFileSize())
 		{
 			char c = (char)wParam;
 
@@ -1933,7 +2515,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 			{
 				int nibbleValue = (c <= '9') ? (c - '0') : (c - 'A' + 10);
 
-				uint8_t currentByte = g_HexData.getByte((size_t)cursorBytePos);
+				uint8_t currentByte = g_HexData->getByte((size_t)cursorBytePos);
 				uint8_t newByte;
 
 				if (cursorNibblePos == 0)
@@ -1941,7 +2523,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 				else
 					newByte = (currentByte & 0xF0) | nibbleValue;
 
-				g_HexData.editByte((size_t)cursorBytePos, newByte);
+				g_HexData->editByte((size_t)cursorBytePos, newByte);
 
 				if (cursorNibblePos == 0)
 				{
@@ -1949,7 +2531,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 				}
 				else
 				{
-					if (cursorBytePos < (long long)g_HexData.getFileSize() - 1)
+					if (cursorBytePos < (long long)g_HexData->getFileSize() - 1)
 					{
 						cursorBytePos++;
 						cursorNibblePos = 0;
@@ -1957,7 +2539,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 						long long cursorLine = cursorBytePos / 16;
 						if (cursorLine >= g_ScrollY + g_LinesPerPage)
 						{
-							g_ScrollY = (int)(cursorLine - g_LinesPerPage + 1);
+							g_ScrollY = (long long)(cursorLine - g_LinesPerPage + 1);
 						}
 					}
 				}
@@ -1975,6 +2557,11 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 	{
 		if (wParam == VK_ESCAPE)
 		{
+			if (g_HexData->isLoading())
+			{
+				g_HexData->cancelLoad();
+				return 0;
+			}
 			if (g_ContextMenu.isVisible())
 			{
 				g_ContextMenu.hide();
@@ -2009,9 +2596,9 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 		}
 		else
 		{
-			if (cursorBytePos >= 0 && g_HexData.getFileSize() > 0)
+			if (cursorBytePos >= 0 && g_HexData->getFileSize() > 0)
 			{
-				long long maxPos = (long long)g_HexData.getFileSize() - 1;
+				long long maxPos = (long long)g_HexData->getFileSize() - 1;
 				bool moved = false;
 
 				switch (wParam)
@@ -2064,11 +2651,11 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 					long long cursorLine = cursorBytePos / 16;
 					if (cursorLine < g_ScrollY)
 					{
-						g_ScrollY = (int)cursorLine;
+						g_ScrollY = cursorLine;
 					}
 					else if (cursorLine >= g_ScrollY + g_LinesPerPage)
 					{
-						g_ScrollY = (int)(cursorLine - g_LinesPerPage + 1);
+						g_ScrollY = (long long)(cursorLine - g_LinesPerPage + 1);
 					}
 
 					caretVisible = true;
@@ -2076,6 +2663,18 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 					return 0;
 				}
 			}
+
+			if (wParam == VK_DELETE && GetKeyState(VK_CONTROL) >= 0)
+			{
+				OnDeleteBytes();
+				return 0;
+			}
+
+			if (wParam == VK_INSERT && GetKeyState(VK_CONTROL) >= 0)
+			{
+				OnInsertBytes();
+				return 0;
+			}
 		}
 
 		bool ctrl = (GetKeyState(VK_CONTROL) & 0x8000) != 0;
@@ -2098,6 +2697,14 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 				OnFileSave();
 				return 0;
 
+			case 'W':
+				OnCloseDocument();
+				return 0;
+
+			case VK_TAB:
+				CycleDocument(1);
+				return 0;
+
 			case 'F':
 				OnfindReplace();
 				return 0;
@@ -2115,11 +2722,11 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 				return 0;
 
 			case 'A':
-				if (g_HexData.getFileSize() > 0)
+				if (g_HexData->getFileSize() > 0)
 				{
 					g_Selection.active = true;
 					g_Selection.startByte = 0;
-					g_Selection.endByte = (long long)g_HexData.getFileSize() - 1;
+					g_Selection.endByte = (long long)g_HexData->getFileSize() - 1;
 					InvalidateRect(hwnd, NULL, FALSE);
 				}
 				return 0;
@@ -2138,15 +2745,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 
 						if (hexString)
 						{
-							size_t pos = 0;
-							for (long long i = minByte; i <= maxByte; i++)
-							{
-								uint8_t byte = g_HexData.getByte((size_t)i);
-								static const char hex[] = "0123456789ABCDEF";
-								hexString[pos++] = hex[byte >> 4];
-								hexString[pos++] = hex[byte & 0x0F];
-								hexString[pos++] = ' ';
-							}
+							size_t pos = g_HexData->formatHex((uint64_t)minByte, (uint64_t)length, hexString);
 							hexString[pos] = '\0';
 
 							if (OpenClipboard(hwnd))
@@ -2191,15 +2790,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 
 						if (hexString)
 						{
-							size_t pos = 0;
-							for (long long i = minByte; i <= maxByte; i++)
-							{
-								uint8_t byte = g_HexData.getByte((size_t)i);
-								static const char hex[] = "0123456789ABCDEF";
-								hexString[pos++] = hex[byte >> 4];
-								hexString[pos++] = hex[byte & 0x0F];
-								hexString[pos++] = ' ';
-							}
+							size_t pos = g_HexData->formatHex((uint64_t)minByte, (uint64_t)length, hexString);
 							hexString[pos] = '\0';
 
 							if (OpenClipboard(hwnd))
@@ -2222,10 +2813,8 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 							HeapFree(GetProcessHeap(), 0, hexString);
 						}
 
-						for (long long i = minByte; i <= maxByte; i++)
-						{
-							g_HexData.editByte((size_t)i, 0x00);
-						}
+						uint8_t zero = 0x00;
+						g_HexData->fillRange((uint64_t)minByte, (uint64_t)(maxByte - minByte + 1), &zero, 1);
 
 						g_Selection.clear();
 						InvalidateRect(hwnd, NULL, FALSE);
@@ -2234,7 +2823,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 				return 0;
 
 			case 'V':
-				if (g_HexData.getFileSize() > 0)
+				if (g_HexData->getFileSize() > 0)
 				{
 					if (OpenClipboard(hwnd))
 					{
@@ -2245,9 +2834,11 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 							if (pszText)
 							{
 								long long pastePos = cursorBytePos >= 0 ? cursorBytePos : 0;
+								long long pasteStart = pastePos;
+								Vector<uint8_t> pasteBytes;
 
 								const char* p = pszText;
-								while (*p && pastePos < (long long)g_HexData.getFileSize())
+								while (*p && pastePos < (long long)g_HexData->getFileSize())
 								{
 									while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
 										p++;
@@ -2276,7 +2867,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 										if (lowNibble >= 0)
 										{
 											uint8_t byte = (uint8_t)((highNibble << 4) | lowNibble);
-											g_HexData.editByte((size_t)pastePos, byte);
+											pasteBytes.push_back(byte);
 											pastePos++;
 											p++;
 										}
@@ -2287,6 +2878,9 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 									}
 								}
 
+								if (!pasteBytes.empty())
+									g_HexData->writeRange((uint64_t)pasteStart, &pasteBytes[0], pasteBytes.size());
+
 								GlobalUnlock(hData);
 								InvalidateRect(hwnd, NULL, FALSE);
 							}
@@ -2297,13 +2891,19 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 				return 0;
 
 			case 'Z':
-				MessageBoxA(hwnd, "Undo functionality not yet implemented",
-					"Info", MB_OK | MB_ICONINFORMATION);
+				OnUndo();
+				return 0;
+
+			case VK_NEXT:
+				OnNextDataExtent();
+				return 0;
+
+			case VK_PRIOR:
+				OnPrevDataExtent();
 				return 0;
 
 			case 'Y':
-				MessageBoxA(hwnd, "Redo functionality not yet implemented",
-					"Info", MB_OK | MB_ICONINFORMATION);
+				OnRedo();
 				return 0;
 
 			case 'B':
@@ -2337,10 +2937,10 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 
 						if (start >= 0 &&
 							length > 0 &&
-							start < (long long)g_HexData.getFileSize())
+							start < (long long)g_HexData->getFileSize())
 						{
 							long long end = start + length;
-							long long maxEnd = (long long)g_HexData.getFileSize();
+							long long maxEnd = (long long)g_HexData->getFileSize();
 							if (end > maxEnd)
 								end = maxEnd;
 
@@ -2351,13 +2951,13 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 							cursorBytePos = start;
 							cursorNibblePos = 0;
 
-							int bytesPerLine = g_HexData.getCurrentBytesPerLine();
-							int targetRow = (int)(start / bytesPerLine);
+							int bytesPerLine = g_HexData->getCurrentBytesPerLine();
+							long long targetRow = start / bytesPerLine;
 
-							int centerRow = targetRow - g_LinesPerPage / 2;
+							long long centerRow = targetRow - g_LinesPerPage / 2;
 							if (centerRow < 0) centerRow = 0;
 
-							int maxScroll = g_TotalLines - g_LinesPerPage;
+							long long maxScroll = g_TotalLines - g_LinesPerPage;
 							if (maxScroll < 0) maxScroll = 0;
 							if (centerRow > maxScroll) centerRow = maxScroll;
 
@@ -2365,7 +2965,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 
 							if (maxScroll > 0)
 							{
-								g_MainScrollbar.position = (float)g_ScrollY / (float)maxScroll;
+								g_MainScrollbar.position = (float)((double)g_ScrollY / (double)maxScroll);
 							}
 							else
 							{
@@ -2392,6 +2992,10 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 				OnFileSaveAs();
 				return 0;
 
+			case VK_TAB:
+				CycleDocument(-1);
+				return 0;
+
 			case 'F':
 				return 0;
 			}
@@ -2411,6 +3015,9 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 
 	case WM_PAINT:
 	{
+		if (g_HexData->isLoading())
+			SetTimer(hwnd, 2, 50, nullptr);
+
 		PAINTSTRUCT ps;
 		HDC hdc = BeginPaint(hwnd, &ps);
 		g_Renderer.beginFrame();
@@ -2450,57 +3057,54 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 		if (g_LinesPerPage < 1)
 			g_LinesPerPage = 1;
 
-		const LineArray& allLines = g_HexData.getHexLines();
-		g_TotalLines = (int)allLines.count;
+		g_TotalLines = (long long)g_HexData->getLineCount();
 
-		if (g_HexData.hasDisassemblyPlugin() && g_HexData.getFileSize() > 0)
+		if (g_HexData->hasDisassemblyPlugin() && g_HexData->getFileSize() > 0)
 		{
-			int startLine = g_ScrollY;
-			int endLine = g_ScrollY + g_LinesPerPage + 1;
+			long long startLine = g_ScrollY;
+			long long endLine = g_ScrollY + g_LinesPerPage + 1;
 
 			size_t startOffset = (size_t)startLine * 16;
 			size_t endOffset = (size_t)endLine * 16;
 
-			if (endOffset > g_HexData.getFileSize())
-				endOffset = g_HexData.getFileSize();
+			if (endOffset > g_HexData->getFileSize())
+				endOffset = g_HexData->getFileSize();
 
 			size_t chunkSize = endOffset - startOffset;
 
-			if (chunkSize > 0 && !g_HexData.isRangeDisassembled(startOffset, endOffset))
+			if (chunkSize > 0 && !g_HexData->isRangeDisassembled(startOffset, endOffset))
 			{
-				g_HexData.disassembleRange(startOffset, chunkSize);
+				g_HexData->disassembleRange(startOffset, chunkSize);
 			}
 		}
 
-		Vector<char*> hexLines;
-		const LineArray& lines = g_HexData.getHexLines();
+		LineProvider hexLines = lc_begin_frame(&g_LineCache, g_HexData, 0, 0);
+		size_t lineCount = g_HexData->getLineCount();
 
-		if (lines.count > 0)
+		if (lineCount > 0)
 		{
 			size_t startLine = (size_t)g_ScrollY;
 			size_t endLine = startLine + g_LinesPerPage + 2;
-			if (endLine > lines.count)
-				endLine = lines.count;
+			if (endLine > lineCount)
+				endLine = lineCount;
 
-			if (startLine >= lines.count)
+			if (startLine >= lineCount)
 				startLine = 0;
 
-			for (size_t i = startLine; i < endLine; i++)
-			{
-				char* buf = (char*)HeapAlloc(GetProcessHeap(), 0, 256);
-
-				g_HexData.getHexLine(i, buf, 256);
+			uint64_t bytesPerLine = (uint64_t)g_HexData->getCurrentBytesPerLine();
+			g_HexData->adviseAccess(startLine * bytesPerLine, (endLine - startLine) * bytesPerLine, FM_ADVICE_WILLNEED);
 
-				hexLines.push_back(buf);
-			}
+			hexLines.firstLine = startLine;
+			hexLines.count = endLine - startLine;
 		}
 
-		const SimpleString& header = g_HexData.getHeaderLine();
+		const SimpleString& header = g_HexData->getHeaderLine();
 		const char* headerStr = header.data ? header.data : "No File Loaded";
 
-		int maxScrollPos = g_TotalLines - g_LinesPerPage;
+		long long maxScrollPos = g_TotalLines - g_LinesPerPage;
 		if (maxScrollPos < 0)
 			maxScrollPos = 0;
+		maxScrolls = maxScrollPos;
 
 		g_Renderer.renderHexViewer(
 			hexLines,
@@ -2517,13 +3121,10 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 			"",
 			cursorBytePos,
 			cursorNibblePos,
-			(long long)g_HexData.getFileSize(),
+			(long long)g_HexData->getFileSize(),
 			leftPanelWidth,
 			effectiveWindowHeight);
 
-		for (size_t i = 0; i < hexLines.size(); i++)
-			HeapFree(GetProcessHeap(), 0, hexLines[i]);
-
 		if (g_LeftPanel.visible)
 		{
 			g_Renderer.drawLeftPanel(
@@ -2543,6 +3144,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 				bottomBounds);
 		}
 		g_MenuBar.render(&g_Renderer, windowWidth);
+		DrawDocumentTabs(windowWidth);
 
 		if (g_ContextMenu.isVisible())
 		{
@@ -2691,6 +3293,7 @@ extern "C" void entry()
 	DetectNative();
 	g_Options.enabledPluginCount = 0;
 	LoadOptionsFromFile(g_Options);
+	InitDocuments();
 	InitializeDIESystem();
 	g_MenuBar.setPosition(0, 0);
 	g_MenuBar.addMenu(MenuHelper::createFileMenu(OnNew, OnFileOpen, OnFileSave, OnFileExit, OnFileProcessOpen, RecentCallbacks));
@@ -2701,13 +3304,14 @@ extern "C" void entry()
 	char *filename = GetFileNameFromCmdLine();
 	if (filename)
 	{
-		if (g_HexData.loadFile(filename))
+		if (OpenInDocument(filename))
 		{
-			CopyString(g_CurrentFilePath, filename, MAX_PATH_LEN);
-			ApplyEnabledPlugins();
-			DIE_Analyze();
+			if (!g_HexData->isStream())
+				CopyString(g_CurrentFilePath, filename, MAX_PATH_LEN);
+			RunAfterLoad(ApplyEnabledPlugins);
+			RunAfterLoad(DIE_Analyze);
 
-			g_TotalLines = (int)g_HexData.getHexLines().count;
+			g_TotalLines = (long long)g_HexData->getLineCount();
 		}
 	}
 
@@ -2842,6 +3446,12 @@ extern "C" void entry()
 
 - (void)blinkCaret:(NSTimer*)timer
 {
+	if (PollFileLoad())
+		[self setNeedsDisplay:YES] ;
+	if (PollMinimap())
+		[self setNeedsDisplay:YES] ;
+	PollFileWatch();
+	PollMemoryBudget();
 	caretVisible = !caretVisible;
 	if (cursorBytePos >= 0)
 	{
@@ -2893,45 +3503,44 @@ extern "C" void entry()
 	if (g_LinesPerPage < 1)
 		g_LinesPerPage = 1;
 
-	if (g_HexData.hasDisassemblyPlugin() && g_HexData.getFileSize() > 0)
+	if (g_HexData->hasDisassemblyPlugin() && g_HexData->getFileSize() > 0)
 	{
-		int startLine = g_ScrollY;
-		int endLine = g_ScrollY + g_LinesPerPage + 1;
+		long long startLine = g_ScrollY;
+		long long endLine = g_ScrollY + g_LinesPerPage + 1;
 		size_t startOffset = (size_t)startLine * 16;
 		size_t endOffset = (size_t)endLine * 16;
 
-		if (endOffset > g_HexData.getFileSize())
-			endOffset = g_HexData.getFileSize();
+		if (endOffset > g_HexData->getFileSize())
+			endOffset = g_HexData->getFileSize();
 
 		size_t chunkSize = endOffset - startOffset;
 
-		if (chunkSize > 0 && !g_HexData.isRangeDisassembled(startOffset, endOffset))
+		if (chunkSize > 0 && !g_HexData->isRangeDisassembled(startOffset, endOffset))
 		{
-			g_HexData.disassembleRange(startOffset, chunkSize);
+			g_HexData->disassembleRange(startOffset, chunkSize);
 		}
 	}
 
-	Vector<char*> hexLines;
-	const LineArray& lines = g_HexData.getHexLines();
-	if (lines.count > 0)
+	LineProvider hexLines = lc_begin_frame(&g_LineCache, g_HexData, 0, 0);
+	size_t lineCount = g_HexData->getLineCount();
+	if (lineCount > 0)
 	{
-		for (int i = 0; i < (int)lines.count; i++)
-		{
-			const SimpleString* line = &lines.lines[i];
-			char* buf = (char*)malloc(line->length + 1);
-			for (size_t j = 0; j < line->length; j++)
-				buf[j] = line->data[j];
-			buf[line->length] = '\0';
-			hexLines.push_back(buf);
-		}
+		size_t startLine = (size_t)g_ScrollY;
+		size_t endLine = startLine + g_LinesPerPage + 1;
+		if (endLine > lineCount)
+			endLine = lineCount;
+
+		hexLines.firstLine = startLine;
+		hexLines.count = endLine > startLine ? endLine - startLine : 0;
 	}
 
-	const SimpleString& header = g_HexData.getHeaderLine();
+	const SimpleString& header = g_HexData->getHeaderLine();
 	const char* headerStr = header.data ? header.data : "No File Loaded";
 
-	int maxScrollPos = g_TotalLines - g_LinesPerPage;
+	long long maxScrollPos = g_TotalLines - g_LinesPerPage;
 	if (maxScrollPos < 0)
 		maxScrollPos = 0;
+	maxScrolls = maxScrollPos;
 
 	g_Renderer.renderHexViewer(
 		hexLines,
@@ -2948,13 +3557,10 @@ extern "C" void entry()
 		"",
 		cursorBytePos,
 		cursorNibblePos,
-		(long long)g_HexData.getFileSize(),
+		(long long)g_HexData->getFileSize(),
 		g_LeftPanel.visible ? g_LeftPanel.width : 0,
 		effectiveWindowHeight);
 
-	for (size_t i = 0; i < hexLines.size(); i++)
-		free(hexLines[i]);
-
 	if (g_LeftPanel.visible)
 	{
 		g_Renderer.drawLeftPanel(
@@ -2976,6 +3582,7 @@ extern "C" void entry()
 	}
 
 	g_MenuBar.render(&g_Renderer, windowWidth);
+	DrawDocumentTabs(windowWidth);
 
 	if (g_ContextMenu.isVisible())
 	{
@@ -3019,6 +3626,12 @@ extern "C" void entry()
 		return;
 	}
 
+	if (HandleMinimapClick(x, y))
+	{
+		[self setNeedsDisplay:YES] ;
+		return;
+	}
+
 	if (g_Renderer.isPointInDisasmResizeHandle(x, y, g_MenuBar.getHeight()))
 	{
 		g_Renderer.startDisasmResize(x);
@@ -3032,6 +3645,12 @@ extern "C" void entry()
 		return;
 	}
 
+	if (HandleDocumentTabClick(x, y))
+	{
+		[self setNeedsDisplay:YES] ;
+		return;
+	}
+
 	if (g_BottomPanel.visible)
 	{
 		Rect bottomBounds = GetBottomPanelBounds(
@@ -3162,7 +3781,7 @@ extern "C" void entry()
 		BytePositionInfo clickInfo = g_Renderer.GetHexBytePositionInfo(Point(x, y));
 
 		if (clickInfo.Index >= 0 &&
-			clickInfo.Index < (long long)g_HexData.getFileSize())
+			clickInfo.Index < (long long)g_HexData->getFileSize())
 		{
 			bool shiftHeld = ([event modifierFlags] & NSEventModifierFlagShift) != 0;
 
@@ -3276,7 +3895,7 @@ extern "C" void entry()
 
 	if (g_MainScrollbar.pressed)
 	{
-		int maxScroll = g_TotalLines - g_LinesPerPage;
+		long long maxScroll = g_TotalLines - g_LinesPerPage;
 		if (maxScroll < 0)
 			maxScroll = 0;
 
@@ -3294,7 +3913,7 @@ extern "C" void entry()
 				newPos = 1.0f;
 
 			g_MainScrollbar.position = newPos;
-			g_ScrollY = (int)(newPos * maxScroll);
+			g_ScrollY = (long long)((double)newPos * (double)maxScroll);
 
 			if (g_ScrollY < 0)
 				g_ScrollY = 0;
@@ -3463,7 +4082,7 @@ extern "C" void entry()
 			BytePositionInfo hoverInfo = g_Renderer.GetHexBytePositionInfo(Point(x, y));
 
 			if (hoverInfo.Index >= 0 &&
-				hoverInfo.Index < (long long)g_HexData.getFileSize())
+				hoverInfo.Index < (long long)g_HexData->getFileSize())
 			{
 				g_Selection.endByte = hoverInfo.Index;
 				cursorBytePos = hoverInfo.Index;
@@ -3472,11 +4091,11 @@ extern "C" void entry()
 				long long cursorLine = hoverInfo.Index / 16;
 				if (cursorLine < g_ScrollY)
 				{
-					g_ScrollY = (int)cursorLine;
+					g_ScrollY = cursorLine;
 				}
 				else if (cursorLine >= g_ScrollY + g_LinesPerPage)
 				{
-					g_ScrollY = (int)(cursorLine - g_LinesPerPage + 1);
+					g_ScrollY = (long long)(cursorLine - g_LinesPerPage + 1);
 				}
 
 				[self setNeedsDisplay:YES];
@@ -3520,10 +4139,10 @@ extern "C" void entry()
 - (void)scrollWheel:(NSEvent*)event
 {
 	int delta = (int)[event deltaY];
-	int oldY = g_ScrollY;
+	long long oldY = g_ScrollY;
 	g_ScrollY += delta;
 
-	int maxScroll = g_TotalLines - g_LinesPerPage;
+	long long maxScroll = g_TotalLines - g_LinesPerPage;
 	if (maxScroll < 0)
 		maxScroll = 0;
 
@@ -3534,7 +4153,7 @@ extern "C" void entry()
 
 	if (maxScroll > 0)
 	{
-		g_MainScrollbar.position = (float)g_ScrollY / (float)maxScroll;
+		g_MainScrollbar.position = (float)((double)g_ScrollY / (double)maxScroll);
 
 		if (g_MainScrollbar.position < 0.0f)
 			g_MainScrollbar.position = 0.0f;
@@ -3560,7 +4179,7 @@ extern "C" void entry()
 	bool shift = (flags & NSEventModifierFlagShift) != 0;
 	bool alt = (flags & NSEventModifierFlagOption) != 0;
 
-	if (!ctrl && cursorBytePos >= 0 && cursorBytePos < (long long)g_HexData.getFileSize())
+	if (!ctrl && cursorBytePos >= 0 && cursorBytePos < (long long)g_HexData->getFileSize())
 	{
 		char c = (char)ch;
 
@@ -3571,7 +4190,7 @@ extern "C" void entry()
 		{
 			int nibbleValue = (c <= '9') ? (c - '0') : (c - 'A' + 10);
 
-			uint8_t currentByte = g_HexData.getByte((size_t)cursorBytePos);
+			uint8_t currentByte = g_HexData->getByte((size_t)cursorBytePos);
 			uint8_t newByte;
 
 			if (cursorNibblePos == 0)
@@ -3579,7 +4198,7 @@ extern "C" void entry()
 			else
 				newByte = (currentByte & 0xF0) | nibbleValue;
 
-			g_HexData.editByte((size_t)cursorBytePos, newByte);
+			g_HexData->editByte((size_t)cursorBytePos, newByte);
 
 			if (cursorNibblePos == 0)
 			{
@@ -3587,7 +4206,7 @@ extern "C" void entry()
 			}
 			else
 			{
-				if (cursorBytePos < (long long)g_HexData.getFileSize() - 1)
+				if (cursorBytePos < (long long)g_HexData->getFileSize() - 1)
 				{
 					cursorBytePos++;
 					cursorNibblePos = 0;
@@ -3595,7 +4214,7 @@ extern "C" void entry()
 					long long cursorLine = cursorBytePos / 16;
 					if (cursorLine >= g_ScrollY + g_LinesPerPage)
 					{
-						g_ScrollY = (int)(cursorLine - g_LinesPerPage + 1);
+						g_ScrollY = (long long)(cursorLine - g_LinesPerPage + 1);
 					}
 				}
 			}
@@ -3606,6 +4225,12 @@ extern "C" void entry()
 		}
 	}
 
+	if ((flags & NSEventModifierFlagControl) && ch == '\t')
+	{
+		CycleDocument(shift ? -1 : 1);
+		return;
+	}
+
 	if (ctrl)
 	{
 		switch (ch)
@@ -3623,6 +4248,9 @@ extern "C" void entry()
 			else
 				OnFileSave();
 			return;
+		case 'w':
+			OnCloseDocument();
+			return;
 		case 'f':
 			OnfindReplace();
 			return;
@@ -3636,20 +4264,31 @@ extern "C" void entry()
 			OnOptionsDialog();
 			return;
 		case 'a':
-			if (g_HexData.getFileSize() > 0)
+			if (g_HexData->getFileSize() > 0)
 			{
 				g_Selection.active = true;
 				g_Selection.startByte = 0;
-				g_Selection.endByte = (long long)g_HexData.getFileSize() - 1;
+				g_Selection.endByte = (long long)g_HexData->getFileSize() - 1;
 				[self setNeedsDisplay:YES] ;
 			}
 			return;
+		case 'z':
+			if (shift)
+				OnRedo();
+			else
+				OnUndo();
+			[self setNeedsDisplay:YES] ;
+			return;
+		case 'y':
+			OnRedo();
+			[self setNeedsDisplay:YES] ;
+			return;
 		}
 	}
 
-	if (cursorBytePos >= 0 && g_HexData.getFileSize() > 0)
+	if (cursorBytePos >= 0 && g_HexData->getFileSize() > 0)
 	{
-		long long maxPos = (long long)g_HexData.getFileSize() - 1;
+		long long maxPos = (long long)g_HexData->getFileSize() - 1;
 		bool moved = false;
 
 		switch ([event keyCode])
@@ -3702,11 +4341,11 @@ extern "C" void entry()
 			long long cursorLine = cursorBytePos / 16;
 			if (cursorLine < g_ScrollY)
 			{
-				g_ScrollY = (int)cursorLine;
+				g_ScrollY = cursorLine;
 			}
 			else if (cursorLine >= g_ScrollY + g_LinesPerPage)
 			{
-				g_ScrollY = (int)(cursorLine - g_LinesPerPage + 1);
+				g_ScrollY = (long long)(cursorLine - g_LinesPerPage + 1);
 			}
 
 			caretVisible = true;
@@ -3715,8 +4354,27 @@ extern "C" void entry()
 		}
 	}
 
+	if (!ctrl && [event keyCode] == 117)
+	{
+		OnDeleteBytes();
+		[self setNeedsDisplay:YES] ;
+		return;
+	}
+
+	if (!ctrl && [event keyCode] == 114)
+	{
+		OnInsertBytes();
+		[self setNeedsDisplay:YES] ;
+		return;
+	}
+
 	if (ch == 27)
 	{
+		if (g_HexData->isLoading())
+		{
+			g_HexData->cancelLoad();
+			return;
+		}
 		if (g_ContextMenu.isVisible())
 		{
 			g_ContextMenu.hide();
@@ -3787,11 +4445,12 @@ extern "C" void entry()
 	char* filename = GetFileNameFromCmdLine();
 	if (filename)
 	{
-		if (g_HexData.loadFile(filename))
+		if (OpenInDocument(filename))
 		{
-			strCopy(g_CurrentFilePath, filename);
-			ApplyEnabledPlugins();
-			g_TotalLines = (int)g_HexData.getHexLines().count;
+			if (!g_HexData->isStream())
+				strCopy(g_CurrentFilePath, filename);
+			RunAfterLoad(ApplyEnabledPlugins);
+			g_TotalLines = (long long)g_HexData->getLineCount();
 		}
 	}
 
@@ -3844,6 +4503,7 @@ int main(int argc, char** argv)
 		DetectNative();
 		g_Options.enabledPluginCount = 0;
 		LoadOptionsFromFile(g_Options);
+		InitDocuments();
 
 		if (argc > 1)
 		{
@@ -4030,6 +4690,14 @@ void HandleLinuxKeyPress(XKeyEvent* event)
 			OnFileSave();
 			return;
 
+		case XK_w:
+			OnCloseDocument();
+			return;
+
+		case XK_Tab:
+			CycleDocument(1);
+			return;
+
 		case XK_f:
 			OnfindReplace();
 			return;
@@ -4047,15 +4715,35 @@ void HandleLinuxKeyPress(XKeyEvent* event)
 			return;
 
 		case XK_a:
-			if (g_HexData.getFileSize() > 0)
+			if (g_HexData->getFileSize() > 0)
 			{
 				g_Selection.active = true;
 				g_Selection.startByte = 0;
-				g_Selection.endByte = (long long)g_HexData.getFileSize() - 1;
+				g_Selection.endByte = (long long)g_HexData->getFileSize() - 1;
 				LinuxRedraw();
 			}
 			return;
 
+		case XK_z:
+			OnUndo();
+			LinuxRedraw();
+			return;
+
+		case XK_Next:
+			OnNextDataExtent();
+			LinuxRedraw();
+			return;
+
+		case XK_Prior:
+			OnPrevDataExtent();
+			LinuxRedraw();
+			return;
+
+		case XK_y:
+			OnRedo();
+			LinuxRedraw();
+			return;
+
 		case XK_c:
 			if (g_Selection.active)
 			{
@@ -4070,15 +4758,7 @@ void HandleLinuxKeyPress(XKeyEvent* event)
 
 					if (hexString)
 					{
-						size_t pos = 0;
-						for (long long i = minByte; i <= maxByte; i++)
-						{
-							uint8_t byte = g_HexData.getByte((size_t)i);
-							static const char hex[] = "0123456789ABCDEF";
-							hexString[pos++] = hex[byte >> 4];
-							hexString[pos++] = hex[byte & 0x0F];
-							hexString[pos++] = ' ';
-						}
+						size_t pos = g_HexData->formatHex((uint64_t)minByte, (uint64_t)length, hexString);
 						hexString[pos] = '\0';
 
 						XStoreBuffer(g_display, hexString, (int)pos, 0);
@@ -4103,25 +4783,15 @@ void HandleLinuxKeyPress(XKeyEvent* event)
 
 					if (hexString)
 					{
-						size_t pos = 0;
-						for (long long i = minByte; i <= maxByte; i++)
-						{
-							uint8_t byte = g_HexData.getByte((size_t)i);
-							static const char hex[] = "0123456789ABCDEF";
-							hexString[pos++] = hex[byte >> 4];
-							hexString[pos++] = hex[byte & 0x0F];
-							hexString[pos++] = ' ';
-						}
+						size_t pos = g_HexData->formatHex((uint64_t)minByte, (uint64_t)length, hexString);
 						hexString[pos] = '\0';
 
 						XStoreBuffer(g_display, hexString, (int)pos, 0);
 						free(hexString);
 					}
 
-					for (long long i = minByte; i <= maxByte; i++)
-					{
-						g_HexData.editByte((size_t)i, 0x00);
-					}
+					uint8_t zero = 0x00;
+					g_HexData->fillRange((uint64_t)minByte, (uint64_t)(maxByte - minByte + 1), &zero, 1);
 
 					g_Selection.clear();
 					LinuxRedraw();
@@ -4130,7 +4800,7 @@ void HandleLinuxKeyPress(XKeyEvent* event)
 			return;
 
 		case XK_v:
-			if (g_HexData.getFileSize() > 0)
+			if (g_HexData->getFileSize() > 0)
 			{
 				int length;
 				char* pszText = XFetchBuffer(g_display, &length, 0);
@@ -4138,9 +4808,11 @@ void HandleLinuxKeyPress(XKeyEvent* event)
 				if (pszText && length > 0)
 				{
 					long long pastePos = cursorBytePos >= 0 ? cursorBytePos : 0;
+					long long pasteStart = pastePos;
+					Vector<uint8_t> pasteBytes;
 					const char* p = pszText;
 
-					while (*p && pastePos < (long long)g_HexData.getFileSize())
+					while (*p && pastePos < (long long)g_HexData->getFileSize())
 					{
 						while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
 							p++;
@@ -4169,7 +4841,7 @@ void HandleLinuxKeyPress(XKeyEvent* event)
 							if (lowNibble >= 0)
 							{
 								uint8_t byte = (uint8_t)((highNibble << 4) | lowNibble);
-								g_HexData.editByte((size_t)pastePos, byte);
+								pasteBytes.push_back(byte);
 								pastePos++;
 								p++;
 							}
@@ -4180,6 +4852,9 @@ void HandleLinuxKeyPress(XKeyEvent* event)
 						}
 					}
 
+					if (!pasteBytes.empty())
+						g_HexData->writeRange((uint64_t)pasteStart, &pasteBytes[0], pasteBytes.size());
+
 					XFree(pszText);
 					LinuxRedraw();
 				}
@@ -4188,6 +4863,27 @@ void HandleLinuxKeyPress(XKeyEvent* event)
 		}
 	}
 
+	if (ctrl && shift && !alt && keysym == XK_Tab)
+	{
+		CycleDocument(-1);
+		return;
+	}
+
+	if (keysym == XK_F12 && !ctrl && !alt)
+	{
+		if (shift)
+			fp_dump(&g_Profiler, "hexviewer-frames.csv");
+		else
+			g_Profiler.enabled = !g_Profiler.enabled;
+		return;
+	}
+
+	if (keysym == XK_Escape && g_HexData->isLoading())
+	{
+		g_HexData->cancelLoad();
+		return;
+	}
+
 	int vk = 0;
 	switch (keysym)
 	{
@@ -4264,7 +4960,19 @@ void HandleLinuxKeyPress(XKeyEvent* event)
 		return;
 	}
 
-	if (!ctrl && cursorBytePos >= 0 && cursorBytePos < (long long)g_HexData.getFileSize())
+	if (!ctrl && keysym == XK_Delete)
+	{
+		OnDeleteBytes();
+		return;
+	}
+
+	if (!ctrl && keysym == XK_Insert)
+	{
+		OnInsertBytes();
+		return;
+	}
+
+	if (!ctrl && cursorBytePos >= 0 && cursorBytePos < (long long)g_HexData->getFileSize())
 	{
 		char buf[8];
 		KeySym sym;
@@ -4281,7 +4989,7 @@ void HandleLinuxKeyPress(XKeyEvent* event)
 			{
 				int nibbleValue = (c <= '9') ? (c - '0') : (c - 'A' + 10);
 
-				uint8_t currentByte = g_HexData.getByte((size_t)cursorBytePos);
+				uint8_t currentByte = g_HexData->getByte((size_t)cursorBytePos);
 				uint8_t newByte;
 
 				if (cursorNibblePos == 0)
@@ -4289,7 +4997,7 @@ void HandleLinuxKeyPress(XKeyEvent* event)
 				else
 					newByte = (currentByte & 0xF0) | nibbleValue;
 
-				g_HexData.editByte((size_t)cursorBytePos, newByte);
+				g_HexData->editByte((size_t)cursorBytePos, newByte);
 
 				if (cursorNibblePos == 0)
 				{
@@ -4297,7 +5005,7 @@ void HandleLinuxKeyPress(XKeyEvent* event)
 				}
 				else
 				{
-					if (cursorBytePos < (long long)g_HexData.getFileSize() - 1)
+					if (cursorBytePos < (long long)g_HexData->getFileSize() - 1)
 					{
 						cursorBytePos++;
 						cursorNibblePos = 0;
@@ -4305,7 +5013,7 @@ void HandleLinuxKeyPress(XKeyEvent* event)
 						long long cursorLine = cursorBytePos / 16;
 						if (cursorLine >= g_ScrollY + g_LinesPerPage)
 						{
-							g_ScrollY = (int)(cursorLine - g_LinesPerPage + 1);
+							g_ScrollY = (long long)(cursorLine - g_LinesPerPage + 1);
 						}
 					}
 				}
@@ -4364,7 +5072,7 @@ void HandleLinuxMouseButton(XButtonEvent* event, bool pressed)
 				BytePositionInfo clickInfo = g_Renderer.GetHexBytePositionInfo(Point(x, y));
 
 				if (clickInfo.Index >= 0 &&
-					clickInfo.Index < (long long)g_HexData.getFileSize())
+					clickInfo.Index < (long long)g_HexData->getFileSize())
 				{
 					g_Selection.startByte = clickInfo.Index;
 					g_Selection.endByte = clickInfo.Index;
@@ -4379,6 +5087,12 @@ void HandleLinuxMouseButton(XButtonEvent* event, bool pressed)
 				return;
 			}
 
+			if (HandleMinimapClick(x, y))
+			{
+				LinuxRedraw();
+				return;
+			}
+
 			if (g_Renderer.isPointInDisasmResizeHandle(x, y, g_MenuBar.getHeight()))
 			{
 				g_Renderer.startDisasmResize(x);
@@ -4392,6 +5106,12 @@ void HandleLinuxMouseButton(XButtonEvent* event, bool pressed)
 				return;
 			}
 
+			if (HandleDocumentTabClick(x, y))
+			{
+				LinuxRedraw();
+				return;
+			}
+
 			if (g_BottomPanel.visible)
 			{
 				Rect bottomBounds = GetBottomPanelBounds(
@@ -4515,6 +5235,8 @@ void HandleLinuxMouseButton(XButtonEvent* event, bool pressed)
 			g_ScrollY += 3;
 			if (g_ScrollY > g_TotalLines - 1)
 				g_ScrollY = g_TotalLines - 1;
+			if (g_ScrollY < 0)
+				g_ScrollY = 0;
 			LinuxRedraw();
 		}
 	}
@@ -4733,14 +5455,147 @@ void HandleLinuxMouseMotion(XMotionEvent* event)
 		return;
 	}
 
+	Rect before[3];
+	int beforeCount = g_MenuBar.getDamageRects(windowWidth, before);
 	if (g_MenuBar.handleMouseMove(x, y))
 	{
-		LinuxRedraw();
+		for (int i = 0; i < beforeCount; i++)
+			g_Renderer.invalidate(before[i]);
+		LinuxInvalidateMenuBar(windowWidth);
 	}
 }
 
+// Damage is painted once per pass of the event loop, after the X queue is drained.
 void LinuxRedraw()
 {
+	g_Renderer.invalidateAll();
+}
+
+void LinuxInvalidateMenuBar(int windowWidth)
+{
+	Rect rects[3];
+	int count = g_MenuBar.getDamageRects(windowWidth, rects);
+	for (int i = 0; i < count; i++)
+		g_Renderer.invalidate(rects[i]);
+}
+
+void LinuxInvalidateCaret()
+{
+	if (cursorBytePos < 0 && !g_PatternSearch.hasFocus)
+		return;
+
+	CaretInfo ci = g_Renderer.GetCaretPosition();
+	g_Renderer.invalidate(Rect(ci.x, ci.y, ci.width, ci.height));
+}
+
+void LinuxBlinkCaret()
+{
+	static uint64_t lastBlink = 0;
+	uint64_t now = sr_now_us();
+	// Ticks can land slightly early; that must not skip a whole blink.
+	if (now - lastBlink < 450000)
+		return;
+	lastBlink = now;
+
+	caretVisible = !caretVisible;
+	LinuxInvalidateCaret();
+}
+
+#define LINUX_IDLE_TICK_MS 500
+#define LINUX_BUSY_TICK_MS 33
+
+static bool AnyDocumentBusy()
+{
+	for (int i = 0; i < g_Documents.count; i++)
+	{
+		if (g_Documents.items[i]->data.isLoading())
+			return true;
+	}
+	return mm_is_building(&g_Minimap);
+}
+
+static void ArmLinuxTimer(int timerFd, int intervalMs)
+{
+	itimerspec spec;
+	spec.it_interval.tv_sec = intervalMs / 1000;
+	spec.it_interval.tv_nsec = (long)(intervalMs % 1000) * 1000000;
+	spec.it_value = spec.it_interval;
+	timerfd_settime(timerFd, 0, &spec, nullptr);
+}
+
+// Sleeps until the X connection, the tick timer or the file watch has
+// something for us. Without a timerfd the tick falls back to the poll timeout.
+static void WaitForLinuxEvents(int timerFd, int tickMs)
+{
+	if (XPending(g_display))
+		return;
+
+	pollfd fds[3];
+	int count = 0;
+	fds[count].fd = ConnectionNumber(g_display);
+	fds[count].events = POLLIN;
+	fds[count].revents = 0;
+	count++;
+
+	int timerIndex = -1;
+	if (timerFd >= 0)
+	{
+		timerIndex = count;
+		fds[count].fd = timerFd;
+		fds[count].events = POLLIN;
+		fds[count].revents = 0;
+		count++;
+	}
+
+	if (g_FileWatch.active && g_FileWatch.fd >= 0)
+	{
+		fds[count].fd = g_FileWatch.fd;
+		fds[count].events = POLLIN;
+		fds[count].revents = 0;
+		count++;
+	}
+
+	int ready = poll(fds, count, timerFd >= 0 ? -1 : tickMs);
+	if (ready > 0 && timerIndex >= 0 && (fds[timerIndex].revents & POLLIN))
+	{
+		uint64_t expirations;
+		ssize_t got = read(timerFd, &expirations, sizeof(expirations));
+		(void)got;
+	}
+}
+
+static const char* FetchProfiledLine(void* context, uint64_t line)
+{
+	const LineProvider* inner = (const LineProvider*)context;
+	uint64_t start = sr_now_us();
+	const char* text = inner->fetch(inner->context, line);
+	fp_add(&g_Profiler, PHASE_FORMAT, sr_now_us() - start);
+	return text;
+}
+
+static Rect GetProfilerHudBounds(int windowWidth, int menuBarHeight)
+{
+	return Rect(windowWidth - 300, menuBarHeight + 8, 290, PROFILE_HUD_LINES * 16 + 12);
+}
+
+static void DrawProfilerHud(const Rect& bounds)
+{
+	char lines[PROFILE_HUD_LINES][PROFILE_HUD_TEXT];
+	int count = fp_format_hud(&g_Profiler, lines, PROFILE_HUD_LINES);
+
+	g_Renderer.drawRect(bounds, Color(0, 0, 0, 200), true);
+	for (int i = 0; i < count; i++)
+		g_Renderer.drawText(lines[i], bounds.x + 8, bounds.y + 6 + i * 16, Color(120, 230, 120));
+}
+
+// Repaints only the damaged rectangles: each one is clipped in turn, only the
+// parts of the scene that overlap it are drawn, and endFrame presents just
+// those rectangles.
+void LinuxPaint()
+{
+	if (!g_Renderer.hasDamage())
+		return;
+
 	XWindowAttributes attrs;
 	XGetWindowAttributes(g_display, g_window, &attrs);
 	int windowWidth = attrs.width;
@@ -4752,11 +5607,6 @@ void LinuxRedraw()
 
 	g_Renderer.beginFrame();
 
-	g_Renderer.clear(
-		g_Options.darkMode
-		? Theme::Dark().windowBackground
-		: Theme::Light().windowBackground);
-
 	Rect leftBounds = GetLeftPanelBounds(
 		g_LeftPanel, windowWidth, windowHeight, menuBarHeight);
 
@@ -4764,84 +5614,139 @@ void LinuxRedraw()
 		g_BottomPanel, windowWidth, windowHeight,
 		menuBarHeight, g_LeftPanel);
 
-	Vector<char*> hexLines;
-	const LineArray& lines = g_HexData.getHexLines();
+	bool profiling = g_Profiler.enabled;
+	Rect hudBounds = GetProfilerHudBounds(windowWidth, menuBarHeight);
+	if (profiling)
+	{
+		g_Renderer.invalidate(hudBounds);
+		g_Renderer.resetDrawCalls();
+	}
+	fp_begin_frame(&g_Profiler);
 
-	if (lines.count > 0)
+	LineProvider hexLines = lc_begin_frame(&g_LineCache, g_HexData, 0, 0);
+	size_t lineCount = g_HexData->getLineCount();
+
+	if (lineCount > 0)
 	{
-		int startLine = g_ScrollY;
-		int endLine = startLine + g_LinesPerPage + 1;
-		if (endLine > (int)lines.count)
-			endLine = (int)lines.count;
+		size_t startLine = (size_t)g_ScrollY;
+		size_t endLine = startLine + g_LinesPerPage + 1;
+		if (endLine > lineCount)
+			endLine = lineCount;
 
-		for (int i = startLine; i < endLine; i++)
-		{
-			char* buf = (char*)malloc(256);
-			g_HexData.getHexLine((size_t)i, buf, 256);
-			hexLines.push_back(buf);
-		}
+		uint64_t bytesPerLine = (uint64_t)g_HexData->getCurrentBytesPerLine();
+		g_HexData->adviseAccess(startLine * bytesPerLine, (endLine - startLine) * bytesPerLine, FM_ADVICE_WILLNEED);
+
+		hexLines.firstLine = startLine;
+		hexLines.count = endLine > startLine ? endLine - startLine : 0;
 	}
 
-	const SimpleString& header = g_HexData.getHeaderLine();
+	const SimpleString& header = g_HexData->getHeaderLine();
 	const char* headerStr = header.data ? header.data : "No File Loaded";
 
-	int maxScrollPos = g_TotalLines - g_LinesPerPage;
+	long long maxScrollPos = g_TotalLines - g_LinesPerPage;
 	if (maxScrollPos < 0)
 		maxScrollPos = 0;
+	maxScrolls = maxScrollPos;
 
-	g_Renderer.renderHexViewer(
-		hexLines,
-		headerStr,
-		g_ScrollY,
-		maxScrollPos,
-		false,
-		false,
-		Rect(0, 0, 0, 0),
-		Rect(0, 0, 0, 0),
-		g_Options.darkMode,
-		-1,
-		-1,
-		"",
-		cursorBytePos,
-		cursorNibblePos,
-		(long long)g_HexData.getFileSize(),
-		g_LeftPanel.visible ? g_LeftPanel.width : 0,
-		windowHeight);
-
-	for (size_t i = 0; i < hexLines.size(); i++)
-		free(hexLines[i]);
-
-	if (g_LeftPanel.visible)
+	LineProvider profiledLines = hexLines;
+	if (profiling)
 	{
-		g_Renderer.drawLeftPanel(
-			g_LeftPanel,
-			g_Options.darkMode ? Theme::Dark() : Theme::Light(),
-			windowHeight,
-			leftBounds);
+		profiledLines.fetch = FetchProfiledLine;
+		profiledLines.context = &hexLines;
 	}
 
-	if (g_BottomPanel.visible)
+	Rect hexBounds(0, menuBarHeight, windowWidth, windowHeight - menuBarHeight);
+	Rect menuRects[3];
+	int menuRectCount = g_MenuBar.getDamageRects(windowWidth, menuRects);
+	Rect contextBounds = g_Renderer.getContextMenuBounds(g_ContextMenu.getState());
+
+	for (int d = 0; d < g_Renderer.getDamageCount(); d++)
 	{
-		g_Renderer.drawBottomPanel(
-			g_BottomPanel,
-			g_Options.darkMode ? Theme::Dark() : Theme::Light(),
-			g_Checksums,
-			windowWidth,
-			windowHeight,
-			bottomBounds);
-	}
+		g_Renderer.setClip(g_Renderer.getDamageRect(d));
 
-	g_MenuBar.render(&g_Renderer, windowWidth);
+		g_Renderer.clear(
+			g_Options.darkMode
+			? Theme::Dark().windowBackground
+			: Theme::Light().windowBackground);
 
-	if (g_ContextMenu.isVisible())
-	{
-		g_Renderer.drawContextMenu(
-			g_ContextMenu.getState(),
-			g_Options.darkMode ? Theme::Dark() : Theme::Light()
-		);
+		if (!g_Renderer.isClipped(hexBounds))
+		{
+			uint32_t formatBefore = g_Profiler.current.phaseUs[PHASE_FORMAT];
+			fp_begin_phase(&g_Profiler, PHASE_HEX);
+			g_Renderer.renderHexViewer(
+				profiledLines,
+				headerStr,
+				g_ScrollY,
+				maxScrollPos,
+				false,
+				false,
+				Rect(0, 0, 0, 0),
+				Rect(0, 0, 0, 0),
+				g_Options.darkMode,
+				-1,
+				-1,
+				"",
+				cursorBytePos,
+				cursorNibblePos,
+				(long long)g_HexData->getFileSize(),
+				g_LeftPanel.visible ? g_LeftPanel.width : 0,
+				windowHeight);
+			fp_end_phase(&g_Profiler, PHASE_HEX);
+			// Line formatting is timed inside the hex pass; report it on its own.
+			g_Profiler.current.phaseUs[PHASE_HEX] -= g_Profiler.current.phaseUs[PHASE_FORMAT] - formatBefore;
+		}
+
+		fp_begin_phase(&g_Profiler, PHASE_PANELS);
+		if (g_LeftPanel.visible && !g_Renderer.isClipped(leftBounds))
+		{
+			g_Renderer.drawLeftPanel(
+				g_LeftPanel,
+				g_Options.darkMode ? Theme::Dark() : Theme::Light(),
+				windowHeight,
+				leftBounds);
+		}
+
+		if (g_BottomPanel.visible && !g_Renderer.isClipped(bottomBounds))
+		{
+			g_Renderer.drawBottomPanel(
+				g_BottomPanel,
+				g_Options.darkMode ? Theme::Dark() : Theme::Light(),
+				g_Checksums,
+				windowWidth,
+				windowHeight,
+				bottomBounds);
+		}
+		fp_end_phase(&g_Profiler, PHASE_PANELS);
+
+		fp_begin_phase(&g_Profiler, PHASE_MENU);
+		bool menuDamaged = false;
+		for (int i = 0; i < menuRectCount; i++)
+			menuDamaged = menuDamaged || !g_Renderer.isClipped(menuRects[i]);
+		if (menuDamaged)
+		{
+			g_MenuBar.render(&g_Renderer, windowWidth);
+			DrawDocumentTabs(windowWidth);
+		}
+
+		if (g_ContextMenu.isVisible() && !g_Renderer.isClipped(contextBounds))
+		{
+			g_Renderer.drawContextMenu(
+				g_ContextMenu.getState(),
+				g_Options.darkMode ? Theme::Dark() : Theme::Light()
+			);
+		}
+		fp_end_phase(&g_Profiler, PHASE_MENU);
+
+		if (profiling && !g_Renderer.isClipped(hudBounds))
+			DrawProfilerHud(hudBounds);
 	}
 
+	g_Renderer.resetClip();
+	uint32_t drawCalls = g_Renderer.getDrawCalls();
+	fp_begin_phase(&g_Profiler, PHASE_BLIT);
 	g_Renderer.endFrame(g_GC);
+	fp_end_phase(&g_Profiler, PHASE_BLIT);
+	fp_end_frame(&g_Profiler, drawCalls);
 
 }
 
@@ -4849,6 +5754,7 @@ int main(int argc, char** argv)
 {
 	DetectNative();
 	LoadOptionsFromFile(g_Options);
+	InitDocuments();
 
 	if (argc > 1)
 	{
@@ -4926,27 +5832,50 @@ int main(int argc, char** argv)
 	char* filename = GetFileNameFromCmdLine();
 	if (filename)
 	{
-		if (g_HexData.loadFile(filename))
+		if (OpenInDocument(filename))
 		{
-			CopyString(g_CurrentFilePath, filename, MAX_PATH_LEN);
-			g_TotalLines = (int)g_HexData.getHexLines().count;
+			if (!g_HexData->isStream())
+				CopyString(g_CurrentFilePath, filename, MAX_PATH_LEN);
+			g_TotalLines = (long long)g_HexData->getLineCount();
 		}
 	}
 
 	XEvent event;
 	bool running = true;
 
+	int timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	bool timerBusy = false;
+	if (timerFd >= 0)
+		ArmLinuxTimer(timerFd, LINUX_IDLE_TICK_MS);
+
 	while (running)
 	{
 		while (XPending(g_display))
 		{
 			XNextEvent(g_display, &event);
 
+			// Only the latest position of a motion burst matters.
+			if (event.type == MotionNotify)
+			{
+				XEvent next;
+				while (XEventsQueued(g_display, QueuedAlready) > 0)
+				{
+					XPeekEvent(g_display, &next);
+					if (next.type != MotionNotify || next.xmotion.window != event.xmotion.window)
+						break;
+					XNextEvent(g_display, &event);
+				}
+			}
+
 			switch (event.type)
 			{
 			case Expose:
-				if (event.xexpose.count == 0)
+				// InvalidateWindow sends a synthetic Expose with no area.
+				if (event.xexpose.width == 0 || event.xexpose.height == 0)
 					LinuxRedraw();
+				else
+					g_Renderer.invalidate(Rect(event.xexpose.x, event.xexpose.y,
+						event.xexpose.width, event.xexpose.height));
 				break;
 
 			case ConfigureNotify:
@@ -4997,17 +5926,17 @@ int main(int argc, char** argv)
 			case MotionNotify:
 				if (g_ContextMenu.isVisible())
 				{
+					g_Renderer.invalidate(g_Renderer.getContextMenuBounds(g_ContextMenu.getState()));
 					g_ContextMenu.handleMouseMove(
 						event.xmotion.x,
 						event.xmotion.y,
 						&g_Renderer
 					);
-					LinuxRedraw();
+					g_Renderer.invalidate(g_Renderer.getContextMenuBounds(g_ContextMenu.getState()));
 				}
 				else
 				{
 					HandleLinuxMouseMotion(&event.xmotion);
-					LinuxRedraw();
 				}
 				break;
 
@@ -5037,9 +5966,26 @@ int main(int argc, char** argv)
 			}
 		}
 
-		usleep(1000);
+		if (PollFileLoad())
+			LinuxRedraw();
+		if (PollMinimap())
+			g_Renderer.invalidate(g_Renderer.getMinimapRect());
+		PollFileWatch();
+		PollMemoryBudget();
+		LinuxBlinkCaret();
+
+		bool busy = AnyDocumentBusy();
+		if (timerFd >= 0 && busy != timerBusy)
+			ArmLinuxTimer(timerFd, busy ? LINUX_BUSY_TICK_MS : LINUX_IDLE_TICK_MS);
+		timerBusy = busy;
+
+		LinuxPaint();
+		WaitForLinuxEvents(timerFd, busy ? LINUX_BUSY_TICK_MS : LINUX_IDLE_TICK_MS);
 	}
 
+	if (timerFd >= 0)
+		close(timerFd);
+
 	SaveOptionsToFile(g_Options);
 	XFreeGC(g_display, g_GC);
 	XDestroyWindow(g_display, g_window);
@@ -15,21 +15,55 @@ extern Window g_window;
 #include "contextmenu.h"
 #include "panelcontent.h"
 
-extern HexData g_HexData;
+extern HexData* g_HexData;
 extern ScrollbarState g_MainScrollbar;
 extern SelectionState g_Selection;
 extern RenderManager g_Renderer;
 extern LeftPanelState g_LeftPanel;
 extern MenuBar g_MenuBar;
-extern int g_ScrollY;
+extern long long g_ScrollY;
 extern int g_LinesPerPage;
-extern int g_TotalLines;
+extern long long g_TotalLines;
 extern AppOptions g_Options;
 extern long long cursorBytePos;
 extern int cursorNibblePos;
 extern long long selectionLength;
 extern size_t editingOffset;
-extern int maxScrolls;
+extern long long maxScrolls;
+extern bool g_FollowTail;
+
+void OnUndo();
+void OnRedo();
+void OnInsertBytes();
+void OnDeleteBytes();
+void OnToggleFollowTail();
+void OnNextDataExtent();
+void OnPrevDataExtent();
+
+// Remembers the range behind the last hex copy so pasting it back into the
+// same, unedited document shares pieces instead of re-parsing the text.
+struct InternalCopy
+{
+  uint64_t source;
+  uint64_t offset;
+  uint64_t length;
+  uint64_t generation;
+  size_t textLength;
+  uint32_t textHash;
+};
+
+static InternalCopy g_InternalCopy = {};
+
+static uint32_t HashClipboardText(const char *text, size_t length)
+{
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; i++)
+  {
+    hash ^= (uint8_t)text[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
 
 #ifdef _WIN32
 
@@ -376,9 +410,42 @@ void AppContextMenu::show(int x, int y)
   state.items.clear();
 
   bool hasSelection = (selectionLength > 0);
-  bool hasData = !g_HexData.isEmpty();
+  bool hasData = !g_HexData->isEmpty();
   bool hasCursor = (cursorBytePos != -1);
 
+  {
+    ContextMenuItem item;
+    item.text = allocString("Undo");
+    item.shortcut = allocString("Ctrl+Z");
+    item.enabled = g_HexData->canUndo();
+    item.checked = false;
+    item.separator = false;
+    item.id = ID_UNDO;
+    state.items.push_back(item);
+  }
+
+  {
+    ContextMenuItem item;
+    item.text = allocString("Redo");
+    item.shortcut = allocString("Ctrl+Y");
+    item.enabled = g_HexData->canRedo();
+    item.checked = false;
+    item.separator = false;
+    item.id = ID_REDO;
+    state.items.push_back(item);
+  }
+
+  {
+    ContextMenuItem item;
+    item.text = nullptr;
+    item.shortcut = nullptr;
+    item.enabled = true;
+    item.checked = false;
+    item.separator = true;
+    item.id = 0;
+    state.items.push_back(item);
+  }
+
   {
     ContextMenuItem item;
     item.text = allocString("Copy");
@@ -444,6 +511,28 @@ void AppContextMenu::show(int x, int y)
     state.items.push_back(item);
   }
 
+  {
+    ContextMenuItem item;
+    item.text = allocString("Insert Byte");
+    item.shortcut = allocString("Ins");
+    item.enabled = hasData && hasCursor;
+    item.checked = false;
+    item.separator = false;
+    item.id = ID_INSERT_BYTE;
+    state.items.push_back(item);
+  }
+
+  {
+    ContextMenuItem item;
+    item.text = allocString("Delete");
+    item.shortcut = allocString("Del");
+    item.enabled = hasData && (hasCursor || hasSelection);
+    item.checked = false;
+    item.separator = false;
+    item.id = ID_DELETE_BYTES;
+    state.items.push_back(item);
+  }
+
   {
     ContextMenuItem item;
     item.text = nullptr;
@@ -487,6 +576,28 @@ void AppContextMenu::show(int x, int y)
     item.id = ID_GOTO_OFFSET;
     state.items.push_back(item);
   }
+
+  {
+    ContextMenuItem item;
+    item.text = allocString("Next Data Extent");
+    item.shortcut = allocString("Ctrl+PgDn");
+    item.enabled = hasData;
+    item.checked = false;
+    item.separator = false;
+    item.id = ID_NEXT_DATA_EXTENT;
+    state.items.push_back(item);
+  }
+
+  {
+    ContextMenuItem item;
+    item.text = allocString("Previous Data Extent");
+    item.shortcut = allocString("Ctrl+PgUp");
+    item.enabled = hasData;
+    item.checked = false;
+    item.separator = false;
+    item.id = ID_PREV_DATA_EXTENT;
+    state.items.push_back(item);
+  }
   {
     ContextMenuItem item;
     item.text = allocString("Select Block...");
@@ -562,6 +673,17 @@ void AppContextMenu::show(int x, int y)
     item.id = ID_ADD_BOOKMARK;
     state.items.push_back(item);
   }
+
+  {
+    ContextMenuItem item;
+    item.text = allocString("Follow Tail");
+    item.shortcut = nullptr;
+    item.enabled = g_HexData->isMapped() && g_Options.autoReload;
+    item.checked = g_FollowTail;
+    item.separator = false;
+    item.id = ID_FOLLOW_TAIL;
+    state.items.push_back(item);
+  }
 }
 
 void AppContextMenu::hide()
@@ -628,29 +750,29 @@ int AppContextMenu::handleClick(int x, int y, RenderManager *renderer)
   return -1;
 }
 
-static void GoToOffsetCallback(int offset)
+static void GoToOffsetCallback(long long offset)
 {
-  if (offset >= 0 && offset < (int)g_HexData.getFileSize())
+  if (offset >= 0 && offset < (long long)g_HexData->getFileSize())
   {
     cursorBytePos = offset;
     editingOffset = offset;
     cursorNibblePos = 0;
 
-    int bytesPerLine = g_HexData.getCurrentBytesPerLine();
+    int bytesPerLine = g_HexData->getCurrentBytesPerLine();
     long long targetLine = offset / bytesPerLine;
 
-    int maxScroll = g_TotalLines - g_LinesPerPage;
+    long long maxScroll = g_TotalLines - g_LinesPerPage;
     if (maxScroll < 0)
       maxScroll = 0;
 
-    g_ScrollY = (int)(targetLine - g_LinesPerPage / 2);
+    g_ScrollY = targetLine - g_LinesPerPage / 2;
     if (g_ScrollY < 0)
       g_ScrollY = 0;
     if (g_ScrollY > maxScroll)
       g_ScrollY = maxScroll;
 
     if (maxScroll > 0)
-      g_MainScrollbar.position = (float)g_ScrollY / (float)maxScroll;
+      g_MainScrollbar.position = (float)((double)g_ScrollY / (double)maxScroll);
     else
       g_MainScrollbar.position = 0.0f;
 
@@ -733,30 +855,35 @@ void AppContextMenu::executeAction(int actionId)
   {
     if (selectionLength > 0)
     {
-      size_t capacity = 1024;
-      size_t length = 0;
-      char *hexString = (char *)platformAlloc(capacity);
-      hexString[0] = '\0';
-
       long long start = cursorBytePos;
       long long end = start + selectionLength;
+      if (end > (long long)g_HexData->getFileSize())
+        end = (long long)g_HexData->getFileSize();
+      if (start < 0 || end <= start)
+        break;
 
-      for (long long i = start; i < end && i < (long long)g_HexData.getFileSize(); i++)
-      {
-        uint8_t byte = g_HexData.readByte(i);
-        char hex[4];
-        byteToHex(byte, hex);
-        hex[2] = ' ';
-        hex[3] = '\0';
-        appendToBuffer(hexString, capacity, length, hex);
-      }
+      size_t capacity = (size_t)(end - start) * 3 + 1;
+      char *hexString = (char *)platformAlloc(capacity);
+      if (!hexString)
+        break;
+      size_t length = g_HexData->formatHex((uint64_t)start, (uint64_t)(end - start), hexString);
+      hexString[length] = '\0';
 
       if (length > 0 && hexString[length - 1] == ' ')
       {
         hexString[length - 1] = '\0';
       }
 
-      SetClipboardText(hexString);
+      if (SetClipboardText(hexString))
+      {
+        size_t textLength = strLen(hexString);
+        g_InternalCopy.source = g_HexData->getContentId();
+        g_InternalCopy.offset = (uint64_t)start;
+        g_InternalCopy.length = (uint64_t)(end - start);
+        g_InternalCopy.generation = g_HexData->getEditGeneration();
+        g_InternalCopy.textLength = textLength;
+        g_InternalCopy.textHash = HashClipboardText(hexString, textLength);
+      }
       platformFree(hexString, capacity);
     }
     break;
@@ -774,9 +901,9 @@ void AppContextMenu::executeAction(int actionId)
       long long start = cursorBytePos;
       long long end = start + selectionLength;
 
-      for (long long i = start; i < end && i < (long long)g_HexData.getFileSize(); i++)
+      for (long long i = start; i < end && i < (long long)g_HexData->getFileSize(); i++)
       {
-        uint8_t byte = g_HexData.readByte(i);
+        uint8_t byte = g_HexData->readByte(i);
         char c = (byte >= 32 && byte <= 126) ? (char)byte : '.';
         appendCharToBuffer(textString, capacity, length, c);
       }
@@ -803,9 +930,9 @@ void AppContextMenu::executeAction(int actionId)
       int bytesPerLine = 12;
       int count = 0;
 
-      for (long long i = start; i < end && i < (long long)g_HexData.getFileSize(); i++)
+      for (long long i = start; i < end && i < (long long)g_HexData->getFileSize(); i++)
       {
-        uint8_t byte = g_HexData.readByte(i);
+        uint8_t byte = g_HexData->readByte(i);
         char hex[8];
         hex[0] = '0';
         hex[1] = 'x';
@@ -813,7 +940,7 @@ void AppContextMenu::executeAction(int actionId)
         hex[4] = '\0';
         appendToBuffer(cArrayString, capacity, length, hex);
 
-        if (i < end - 1 && i < (long long)g_HexData.getFileSize() - 1)
+        if (i < end - 1 && i < (long long)g_HexData->getFileSize() - 1)
         {
           appendToBuffer(cArrayString, capacity, length, ", ");
           count++;
@@ -833,16 +960,65 @@ void AppContextMenu::executeAction(int actionId)
     break;
   }
 
+  case ID_UNDO:
+    OnUndo();
+    break;
+
+  case ID_REDO:
+    OnRedo();
+    break;
+
+  case ID_INSERT_BYTE:
+    OnInsertBytes();
+    break;
+
+  case ID_DELETE_BYTES:
+    OnDeleteBytes();
+    break;
+
+  case ID_FOLLOW_TAIL:
+    OnToggleFollowTail();
+    break;
+
+  case ID_NEXT_DATA_EXTENT:
+    OnNextDataExtent();
+    break;
+
+  case ID_PREV_DATA_EXTENT:
+    OnPrevDataExtent();
+    break;
+
   case ID_PASTE:
   {
     if (cursorBytePos != -1)
     {
       char *clipText = GetClipboardText();
-      if (clipText)
+      size_t clipLen = clipText ? strLen(clipText) : 0;
+      if (clipText && g_InternalCopy.source == g_HexData->getContentId() &&
+          g_InternalCopy.generation == g_HexData->getEditGeneration() &&
+          g_InternalCopy.textLength == clipLen &&
+          g_InternalCopy.textHash == HashClipboardText(clipText, clipLen) &&
+          (uint64_t)cursorBytePos < g_HexData->getFileSize())
+      {
+        uint64_t pastePos = (uint64_t)cursorBytePos;
+        uint64_t count = g_InternalCopy.length;
+        if (count > g_HexData->getFileSize() - pastePos)
+          count = g_HexData->getFileSize() - pastePos;
+
+        if (g_HexData->copyRange(g_InternalCopy.offset, pastePos, count))
+          pastePos += count;
+
+        long long maxPos = (long long)g_HexData->getFileSize() - 1;
+        cursorBytePos = clampLL((long long)pastePos, 0LL, maxPos);
+        editingOffset = cursorBytePos;
+
+        platformFree(clipText, clipLen + 1);
+        InvalidateWindow();
+      }
+      else if (clipText)
       {
         Vector<uint8_t> bytes;
         size_t pos = 0;
-        size_t clipLen = strLen(clipText);
 
         while (pos < clipLen)
         {
@@ -878,12 +1054,17 @@ void AppContextMenu::executeAction(int actionId)
         }
 
         long long pastePos = cursorBytePos;
-        const size_t fileSize = g_HexData.getFileSize();
+        const size_t fileSize = g_HexData->getFileSize();
 
-        for (size_t i = 0; i < bytes.size() && pastePos < static_cast<long long>(fileSize); ++i)
+        if (pastePos < static_cast<long long>(fileSize) && !bytes.empty())
         {
-          g_HexData.editByte(static_cast<size_t>(pastePos), bytes[i]);
-          ++pastePos;
+          long long available = static_cast<long long>(fileSize) - pastePos;
+          long long count = static_cast<long long>(bytes.size());
+          if (count > available)
+            count = available;
+
+          g_HexData->writeRange(static_cast<uint64_t>(pastePos), &bytes[0], static_cast<uint64_t>(count));
+          pastePos += count;
         }
 
         long long maxPos = (fileSize > 0) ? static_cast<long long>(fileSize - 1) : 0LL;
@@ -898,10 +1079,10 @@ void AppContextMenu::executeAction(int actionId)
   }
 
   case ID_SELECT_ALL:
-    if (!g_HexData.isEmpty())
+    if (!g_HexData->isEmpty())
     {
       cursorBytePos = 0;
-      selectionLength = g_HexData.getFileSize();
+      selectionLength = g_HexData->getFileSize();
       InvalidateWindow();
     }
     break;
@@ -914,17 +1095,17 @@ void AppContextMenu::executeAction(int actionId)
     SearchDialogs::ShowGoToDialog(
         (NativeWindow)g_nsWindow,
         g_Options.darkMode,
-        [](int offset)
+        [](long long offset)
         {
-          if (offset >= 0 && offset < (int)g_HexData.getFileSize())
+          if (offset >= 0 && offset < (long long)g_HexData->getFileSize())
           {
             cursorBytePos = offset;
             editingOffset = offset;
             cursorNibblePos = 0;
 
-            int bytesPerLine = g_HexData.getCurrentBytesPerLine();
-            int targetRow = offset / bytesPerLine;
-            g_ScrollY = clamp(targetRow - 5, 0, maxScrolls);
+            int bytesPerLine = g_HexData->getCurrentBytesPerLine();
+            long long targetRow = offset / bytesPerLine;
+            g_ScrollY = clamp(targetRow - 5, 0LL, maxScrolls);
 
             InvalidateWindow();
           }
@@ -933,17 +1114,17 @@ void AppContextMenu::executeAction(int actionId)
     SearchDialogs::ShowGoToDialog(
         (void *)g_window,
         g_Options.darkMode,
-        [](int offset)
+        [](long long offset)
         {
-          if (offset >= 0 && offset < (int)g_HexData.getFileSize())
+          if (offset >= 0 && offset < (long long)g_HexData->getFileSize())
           {
             cursorBytePos = offset;
             editingOffset = offset;
             cursorNibblePos = 0;
 
-            int bytesPerLine = g_HexData.getCurrentBytesPerLine();
-            int targetRow = offset / bytesPerLine;
-            g_ScrollY = clamp(targetRow - 5, 0, maxScrolls);
+            int bytesPerLine = g_HexData->getCurrentBytesPerLine();
+            long long targetRow = offset / bytesPerLine;
+            g_ScrollY = clamp(targetRow - 5, 0LL, maxScrolls);
 
             InvalidateWindow();
           }
@@ -956,13 +1137,8 @@ void AppContextMenu::executeAction(int actionId)
   {
     if (selectionLength > 0)
     {
-      long long start = cursorBytePos;
-      long long end = start + selectionLength;
-
-      for (long long i = start; i < end && i < (long long)g_HexData.getFileSize(); i++)
-      {
-        g_HexData.editByte(i, 0x00);
-      }
+      uint8_t value = 0x00;
+      g_HexData->fillRange((uint64_t)cursorBytePos, (uint64_t)selectionLength, &value, 1);
 
       InvalidateWindow();
     }
@@ -973,13 +1149,8 @@ void AppContextMenu::executeAction(int actionId)
   {
     if (selectionLength > 0)
     {
-      long long start = cursorBytePos;
-      long long end = start + selectionLength;
-
-      for (long long i = start; i < end && i < (long long)g_HexData.getFileSize(); i++)
-      {
-        g_HexData.editByte(i, 0xFF);
-      }
+      uint8_t value = 0xFF;
+      g_HexData->fillRange((uint64_t)cursorBytePos, (uint64_t)selectionLength, &value, 1);
 
       InvalidateWindow();
     }
@@ -991,16 +1162,7 @@ void AppContextMenu::executeAction(int actionId)
     if (selectionLength > 0)
     {
       uint8_t patternBytes[] = {0xAA, 0xBB, 0xCC, 0xDD};
-      int patternLen = 4;
-      long long start = cursorBytePos;
-      long long end = start + selectionLength;
-      size_t patternIndex = 0;
-
-      for (long long i = start; i < end && i < (long long)g_HexData.getFileSize(); i++)
-      {
-        g_HexData.editByte(i, patternBytes[patternIndex]);
-        patternIndex = (patternIndex + 1) % patternLen;
-      }
+      g_HexData->fillRange((uint64_t)cursorBytePos, (uint64_t)selectionLength, patternBytes, 4);
 
       InvalidateWindow();
     }
@@ -1043,6 +1205,7 @@ void AppContextMenu::executeAction(int actionId)
             newBookmark.color = colors[colorIndex];
 
             g_Bookmarks.bookmarks.push_back(newBookmark);
+            Bookmarks_Invalidate();
             g_Bookmarks.selectedIndex = g_Bookmarks.bookmarks.size() - 1;
 
             InvalidateWindow();
@@ -1076,6 +1239,7 @@ void AppContextMenu::executeAction(int actionId)
             newBookmark.color = colors[colorIndex];
 
             g_Bookmarks.bookmarks.push_back(newBookmark);
+            Bookmarks_Invalidate();
             g_Bookmarks.selectedIndex = g_Bookmarks.bookmarks.size() - 1;
 
             InvalidateWindow();
@@ -1108,6 +1272,7 @@ void AppContextMenu::executeAction(int actionId)
             newBookmark.color = colors[colorIndex];
 
             g_Bookmarks.bookmarks.push_back(newBookmark);
+            Bookmarks_Invalidate();
             g_Bookmarks.selectedIndex = g_Bookmarks.bookmarks.size() - 1;
 
             InvalidateWindow();
@@ -1157,10 +1322,10 @@ void AppContextMenu::executeAction(int actionId)
 
         if (start >= 0 &&
           length > 0 &&
-          start < (long long)g_HexData.getFileSize())
+          start < (long long)g_HexData->getFileSize())
         {
           long long end = start + length;
-          long long maxEnd = (long long)g_HexData.getFileSize();
+          long long maxEnd = (long long)g_HexData->getFileSize();
           if (end > maxEnd)
             end = maxEnd;
 
@@ -1169,9 +1334,9 @@ void AppContextMenu::executeAction(int actionId)
           editingOffset = start;
           cursorNibblePos = 0;
 
-          int bytesPerLine = g_HexData.getCurrentBytesPerLine();
-          int targetRow = start / bytesPerLine;
-          g_ScrollY = clamp(targetRow - 5, 0, maxScrolls);
+          int bytesPerLine = g_HexData->getCurrentBytesPerLine();
+          long long targetRow = start / bytesPerLine;
+          g_ScrollY = clamp(targetRow - 5, 0LL, maxScrolls);
 
           InvalidateWindow();
         }
@@ -1196,10 +1361,10 @@ void AppContextMenu::executeAction(int actionId)
 
         if (start >= 0 &&
           length > 0 &&
-          start < (long long)g_HexData.getFileSize())
+          start < (long long)g_HexData->getFileSize())
         {
           long long end = start + length;
-          long long maxEnd = (long long)g_HexData.getFileSize();
+          long long maxEnd = (long long)g_HexData->getFileSize();
           if (end > maxEnd)
             end = maxEnd;
 
@@ -1208,9 +1373,9 @@ void AppContextMenu::executeAction(int actionId)
           editingOffset = start;
           cursorNibblePos = 0;
 
-          int bytesPerLine = g_HexData.getCurrentBytesPerLine();
-          int targetRow = start / bytesPerLine;
-          g_ScrollY = clamp(targetRow - 5, 0, maxScrolls);
+          int bytesPerLine = g_HexData->getCurrentBytesPerLine();
+          long long targetRow = start / bytesPerLine;
+          g_ScrollY = clamp(targetRow - 5, 0LL, maxScrolls);
 
           InvalidateWindow();
         }
@@ -1234,10 +1399,10 @@ void AppContextMenu::executeAction(int actionId)
 
         if (start >= 0 &&
           length > 0 &&
-          start < (long long)g_HexData.getFileSize())
+          start < (long long)g_HexData->getFileSize())
         {
           long long end = start + length;
-          long long maxEnd = (long long)g_HexData.getFileSize();
+          long long maxEnd = (long long)g_HexData->getFileSize();
           if (end > maxEnd)
             end = maxEnd;
 
@@ -1246,9 +1411,9 @@ void AppContextMenu::executeAction(int actionId)
           editingOffset = start;
           cursorNibblePos = 0;
 
-          int bytesPerLine = g_HexData.getCurrentBytesPerLine();
-          int targetRow = start / bytesPerLine;
-          g_ScrollY = clamp(targetRow - 5, 0, maxScrolls);
+          int bytesPerLine = g_HexData->getCurrentBytesPerLine();
+          long long targetRow = start / bytesPerLine;
+          g_ScrollY = clamp(targetRow - 5, 0LL, maxScrolls);
 
           InvalidateWindow();
         }
@@ -479,6 +479,8 @@ void MenuBar::render(RenderManager *renderer, int windowWidth)
 
   int charWidth = renderer->getCharWidth();
   int charHeight = renderer->getCharHeight();
+  lastCharWidth = charWidth;
+  lastWindowWidth = windowWidth;
 
   Rect menuBarRect(x, y, windowWidth, height);
   renderer->drawRect(menuBarRect, theme.menuBackground, true);
@@ -515,16 +517,11 @@ void MenuBar::render(RenderManager *renderer, int windowWidth)
   {
     Menu &menu = menus[openMenuIndex];
 
-    int dropdownX = menu.bounds.x;
-    int dropdownY = menu.bounds.y + menu.bounds.height;
-    int maxWidth = 250;
-
-    int dropdownHeight = 8;
-    for (int i = 0; i < menu.itemCount; i++)
-    {
-      dropdownHeight += (menu.items[i].type == MenuItemType::Separator) ? 8 : 32;
-    }
-    dropdownHeight += 8;
+    Rect dropdownBounds = getDropdownRect();
+    int dropdownX = dropdownBounds.x;
+    int dropdownY = dropdownBounds.y;
+    int maxWidth = dropdownBounds.width;
+    int dropdownHeight = dropdownBounds.height;
 
     Rect shadowRect(dropdownX + 3, dropdownY + 3, maxWidth, dropdownHeight);
     renderer->drawRect(shadowRect, Color(0, 0, 0, 80), true);
@@ -594,41 +591,11 @@ void MenuBar::render(RenderManager *renderer, int windowWidth)
 
       if (parentItem.type == MenuItemType::Submenu && parentItem.submenuCount > 0)
       {
-        int submenuX = dropdownX + maxWidth - 2;
-        int submenuY = dropdownY + 8;
-
-        for (int i = 0; i < openSubmenuIndex; i++)
-        {
-          submenuY += (menu.items[i].type == MenuItemType::Separator) ? 8 : 32;
-        }
-
-        int submenuWidth = 250;
-        for (int i = 0; i < parentItem.submenuCount; i++)
-        {
-          if (parentItem.submenu[i].label)
-          {
-            int labelLen = strLen(parentItem.submenu[i].label);
-            int itemWidth = labelLen * charWidth + 50;
-            if (itemWidth > submenuWidth)
-            {
-              submenuWidth = itemWidth;
-            }
-          }
-        }
-
-        int maxAllowedWidth = windowWidth - submenuX - 20;
-        if (submenuWidth > maxAllowedWidth && maxAllowedWidth > 250)
-        {
-          submenuWidth = maxAllowedWidth;
-        }
-
-        int submenuHeight = 16;
-        for (int i = 0; i < parentItem.submenuCount; i++)
-        {
-          submenuHeight += (parentItem.submenu[i].type == MenuItemType::Separator) ? 8 : 32;
-        }
-
-        submenuBounds = Rect(submenuX, submenuY, submenuWidth, submenuHeight);
+        submenuBounds = getSubmenuRect();
+        int submenuX = submenuBounds.x;
+        int submenuY = submenuBounds.y;
+        int submenuWidth = submenuBounds.width;
+        int submenuHeight = submenuBounds.height;
 
         Rect subShadow(submenuX + 3, submenuY + 3, submenuWidth, submenuHeight);
         renderer->drawRect(subShadow, Color(0, 0, 0, 80), true);
@@ -970,6 +937,87 @@ Rect MenuBar::getBounds(int windowWidth) const
   return Rect(x, y, windowWidth, height);
 }
 
+// Everything render() may touch: the bar plus any open dropdown and submenu,
+// including their drop shadows.
+int MenuBar::getDamageRects(int windowWidth, Rect *out) const
+{
+  int count = 0;
+  out[count++] = getBounds(windowWidth);
+
+  Rect dropdown = getDropdownRect();
+  if (dropdown.width > 0)
+    out[count++] = Rect(dropdown.x, dropdown.y, dropdown.width + 4, dropdown.height + 4);
+
+  Rect submenu = getSubmenuRect();
+  if (submenu.width > 0)
+    out[count++] = Rect(submenu.x, submenu.y, submenu.width + 4, submenu.height + 4);
+
+  return count;
+}
+
+Rect MenuBar::getDropdownRect() const
+{
+  if (openMenuIndex < 0 || openMenuIndex >= menuCount)
+    return Rect(0, 0, 0, 0);
+
+  const Menu &menu = menus[openMenuIndex];
+  int dropdownHeight = 8;
+  for (int i = 0; i < menu.itemCount; i++)
+  {
+    dropdownHeight += (menu.items[i].type == MenuItemType::Separator) ? 8 : 32;
+  }
+  dropdownHeight += 8;
+
+  return Rect(menu.bounds.x, menu.bounds.y + menu.bounds.height, 250, dropdownHeight);
+}
+
+Rect MenuBar::getSubmenuRect() const
+{
+  Rect dropdown = getDropdownRect();
+  if (dropdown.width == 0 || openSubmenuIndex < 0 || openSubmenuIndex >= menus[openMenuIndex].itemCount)
+    return Rect(0, 0, 0, 0);
+
+  const Menu &menu = menus[openMenuIndex];
+  const MenuItem &parentItem = menu.items[openSubmenuIndex];
+  if (parentItem.type != MenuItemType::Submenu || parentItem.submenuCount <= 0)
+    return Rect(0, 0, 0, 0);
+
+  int submenuX = dropdown.x + dropdown.width - 2;
+  int submenuY = dropdown.y + 8;
+  for (int i = 0; i < openSubmenuIndex; i++)
+  {
+    submenuY += (menu.items[i].type == MenuItemType::Separator) ? 8 : 32;
+  }
+
+  int submenuWidth = 250;
+  for (int i = 0; i < parentItem.submenuCount; i++)
+  {
+    if (parentItem.submenu[i].label)
+    {
+      int labelLen = strLen(parentItem.submenu[i].label);
+      int itemWidth = labelLen * lastCharWidth + 50;
+      if (itemWidth > submenuWidth)
+      {
+        submenuWidth = itemWidth;
+      }
+    }
+  }
+
+  int maxAllowedWidth = lastWindowWidth - submenuX - 20;
+  if (submenuWidth > maxAllowedWidth && maxAllowedWidth > 250)
+  {
+    submenuWidth = maxAllowedWidth;
+  }
+
+  int submenuHeight = 16;
+  for (int i = 0; i < parentItem.submenuCount; i++)
+  {
+    submenuHeight += (parentItem.submenu[i].type == MenuItemType::Separator) ? 8 : 32;
+  }
+
+  return Rect(submenuX, submenuY, submenuWidth, submenuHeight);
+}
+
 void MenuBar::closeAllMenus()
 {
   closeMenu();
@@ -233,6 +233,11 @@ void SaveOptionsToFile(const AppOptions& options)
   strCopy(buf + 20, "\n");
   WriteFile(hFile, buf, (DWORD)strLen(buf), &written, nullptr);
 
+  strCopy(buf, "byteClassColors=");
+  strCopy(buf + 16, options.byteClassColors ? "1" : "0");
+  strCopy(buf + 17, "\n");
+  WriteFile(hFile, buf, (DWORD)strLen(buf), &written, nullptr);
+
   strCopy(buf, "bytesPerLine=");
   itoaDec((long long)options.defaultBytesPerLine, buf + 13, 243);
   int len = (int)strLen(buf);
@@ -256,6 +261,17 @@ void SaveOptionsToFile(const AppOptions& options)
   strCopy(buf + len, "\n");
   WriteFile(hFile, buf, (DWORD)strLen(buf), &written, nullptr);
 
+  strCopy(buf, "streamBufferMB=");
+  itoaDec((long long)options.streamBufferMB, buf + 15, 241);
+  len = (int)strLen(buf);
+  strCopy(buf + len, "\n");
+  WriteFile(hFile, buf, (DWORD)strLen(buf), &written, nullptr);
+  strCopy(buf, "memoryBudgetMB=");
+  itoaDec((long long)options.memoryBudgetMB, buf + 15, 241);
+  len = (int)strLen(buf);
+  strCopy(buf + len, "\n");
+  WriteFile(hFile, buf, (DWORD)strLen(buf), &written, nullptr);
+
   strCopy(buf, "fontName=");
   strCopy(buf + 9, options.fontName);
   len = (int)strLen(buf);
@@ -352,6 +368,10 @@ if (fd < 0)
   strCopy(buf + 19, options.bookmarkHighlights ? "1\n" : "0\n");
   write(fd, buf, strLen(buf));
 
+  strCopy(buf, "byteClassColors=");
+  strCopy(buf + 16, options.byteClassColors ? "1\n" : "0\n");
+  write(fd, buf, strLen(buf));
+
   strCopy(buf, "bytesPerLine=");
   itoaDec((long long)options.defaultBytesPerLine, buf + 13, 243);
   int len = (int)strLen(buf);
@@ -368,6 +388,17 @@ if (fd < 0)
   strCopy(buf + len, "\n");
   write(fd, buf, strLen(buf));
 
+  strCopy(buf, "streamBufferMB=");
+  itoaDec((long long)options.streamBufferMB, buf + 15, 241);
+  len = (int)strLen(buf);
+  strCopy(buf + len, "\n");
+  write(fd, buf, strLen(buf));
+  strCopy(buf, "memoryBudgetMB=");
+  itoaDec((long long)options.memoryBudgetMB, buf + 15, 241);
+  len = (int)strLen(buf);
+  strCopy(buf + len, "\n");
+  write(fd, buf, strLen(buf));
+
   strCopy(buf, "\n[RecentFiles]\n");
   write(fd, buf, strLen(buf));
 
@@ -556,6 +587,9 @@ void LoadOptionsFromFile(AppOptions& options)
             else if (strEquals(key, "bookmarkHighlights"))
               options.bookmarkHighlights = strEquals(val, "1");
 
+            else if (strEquals(key, "byteClassColors"))
+              options.byteClassColors = strEquals(val, "1");
+
             else if (strEquals(key, "bytesPerLine"))
               options.defaultBytesPerLine = strToInt(val);
             else if (strEquals(key, "autoReload"))
@@ -564,6 +598,10 @@ void LoadOptionsFromFile(AppOptions& options)
               strCopy(options.language, val);
             else if (strEquals(key, "fontSize"))
               options.fontSize = strToInt(val);
+            else if (strEquals(key, "streamBufferMB"))
+              options.streamBufferMB = strToInt(val);
+            else if (strEquals(key, "memoryBudgetMB"))
+              options.memoryBudgetMB = strToInt(val);
             else if (strEquals(key, "fontName"))
               strCopy(options.fontName, val);
           }
@@ -588,6 +626,33 @@ inline int NextY(int& y, int controlHeight, int spacing)
   return y;
 }
 
+// Client height that fits every row RenderOptionsDialog lays out plus the
+// OK/Cancel row, so adding a control only means updating this walk.
+static int OptionsDialogClientHeight()
+{
+  const int margin = 20;
+  const int controlHeight = 25;
+  const int controlSpacing = 10;
+  const int sectionSpacing = 20;
+  const int buttonHeight = 25;
+
+  int y = margin;
+  y += controlHeight + 15;
+  y += (controlHeight + controlSpacing) * 4;
+  if (!GetIsNativeFlag())
+    y += controlHeight + sectionSpacing;
+
+  y += (controlHeight + 2) + (controlHeight + sectionSpacing);
+  y += (controlHeight + 2) + (controlHeight + controlSpacing);
+  y += (controlHeight + 2) + (controlHeight + controlSpacing);
+  y += controlSpacing;
+
+  y += (controlHeight + controlSpacing) * 2;
+  y += 16;
+
+  return y + sectionSpacing + buttonHeight + 5 + margin;
+}
+
 void RenderOptionsDialog(OptionsDialogData* data, int windowWidth, int windowHeight)
 {
   if (!data || !data->renderer)
@@ -630,6 +695,17 @@ void RenderOptionsDialog(OptionsDialogData* data, int windowWidth, int windowHei
     NEXT_Y(controlSpacing);
   }
 
+  {
+    Rect r(margin, y, 18, 18);
+    WidgetState ws(r);
+    ws.hovered = (data->hoveredWidget == 11);
+    ws.pressed = (data->pressedWidget == 11);
+
+    data->renderer->drawModernCheckbox(ws, theme, data->tempOptions.byteClassColors);
+    data->renderer->drawText(Translations::T("Color bytes by class"), margin + 28, y + 2, theme.textColor);
+    NEXT_Y(controlSpacing);
+  }
+
   {
     Rect r(margin, y, 18, 18);
     WidgetState ws(r);
@@ -863,6 +939,8 @@ void UpdateHoverState(OptionsDialogData* data, int x, int y, int windowWidth, in
 
   { Rect r(margin, startY, 18, 18); if (IsPointInRect(x, y, r)) { data->hoveredWidget = 9; return; } NEXT_Y(controlSpacing); }
 
+  { Rect r(margin, startY, 18, 18); if (IsPointInRect(x, y, r)) { data->hoveredWidget = 11; return; } NEXT_Y(controlSpacing); }
+
   { Rect r(margin, startY, 18, 18); if (IsPointInRect(x, y, r)) { data->hoveredWidget = 1; return; } NEXT_Y(controlSpacing); }
 
   if (!GetIsNativeFlag())
@@ -1024,6 +1102,10 @@ void HandleMouseClick(OptionsDialogData* data, int x, int y, int windowWidth, in
     data->tempOptions.bookmarkHighlights = !data->tempOptions.bookmarkHighlights;
     break;
 
+  case 11:
+    data->tempOptions.byteClassColors = !data->tempOptions.byteClassColors;
+    break;
+
   case 1:
     data->tempOptions.autoReload = !data->tempOptions.autoReload;
     break;
@@ -1365,7 +1447,11 @@ bool OptionsDialog::Show(HWND parent, AppOptions& options)
   }
 
   int width = 400;
-  int height = 620;
+  RECT frameRect = { 0, 0, width, OptionsDialogClientHeight() };
+  AdjustWindowRectEx(&frameRect, WS_POPUP | WS_CAPTION | WS_SYSMENU, FALSE,
+    WS_EX_DLGMODALFRAME | WS_EX_TOPMOST);
+  width = frameRect.right - frameRect.left;
+  int height = frameRect.bottom - frameRect.top;
   RECT parentRect;
   GetWindowRect(parent, &parentRect);
   int x = parentRect.left + (parentRect.right - parentRect.left - width) / 2;
@@ -1605,7 +1691,7 @@ bool OptionsDialog::Show(NativeWindow parent, AppOptions &options)
   }
 
   int width = 400;
-  int height = 500;
+  int height = OptionsDialogClientHeight();
 
   Window window = XCreateSimpleWindow(display, rootWindow, 100, 100, width, height, 1,
                                       BlackPixel(display, screen), WhitePixel(display, screen));
@@ -1812,7 +1898,8 @@ bool OptionsDialog::Show(NativeWindow parent, AppOptions& options)
       }
     }
 
-    NSRect frame = NSMakeRect(0, 0, 400, 620);
+    const int height = OptionsDialogClientHeight();
+    NSRect frame = NSMakeRect(0, 0, 400, height);
     NSWindowStyleMask style = NSWindowStyleMaskTitled | NSWindowStyleMaskClosable;
 
     NSWindow* window = [[NSWindow alloc]initWithContentRect:frame
@@ -1846,7 +1933,7 @@ bool OptionsDialog::Show(NativeWindow parent, AppOptions& options)
       return false;
     }
 
-    data.renderer->resize(400, 600);
+    data.renderer->resize(400, height);
 
     if (parentWindow) {
       [parentWindow addChildWindow:window ordered : NSWindowAbove] ;
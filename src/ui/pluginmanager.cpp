@@ -725,13 +725,13 @@ void HandlePluginClick(PluginManagerData* data, int x, int y, int windowWidth, i
       if (data->plugins[data->hoveredPlugin]->enabled &&
         data->plugins[data->hoveredPlugin]->canDisassemble)
       {
-        extern HexData g_HexData;
-        g_HexData.setDisassemblyPlugin(data->plugins[data->hoveredPlugin]->path);
+        extern HexData* g_HexData;
+        g_HexData->setDisassemblyPlugin(data->plugins[data->hoveredPlugin]->path);
       }
       else if (!data->plugins[data->hoveredPlugin]->enabled)
       {
-        extern HexData g_HexData;
-        g_HexData.clearDisassemblyPlugin();
+        extern HexData* g_HexData;
+        g_HexData->clearDisassemblyPlugin();
       }
     }
     return;
@@ -36,10 +36,10 @@
 #include "processdialog.h"
 
 
-extern HexData g_HexData;
+extern HexData* g_HexData;
 extern char g_CurrentFilePath[MAX_PATH_LEN];
-extern int g_TotalLines;
-extern int g_ScrollY;
+extern long long g_TotalLines;
+extern long long g_ScrollY;
 extern void ApplyEnabledPlugins();
 
 static ProcessDialogData* g_processDialogData = nullptr;
@@ -564,16 +564,10 @@ bool ReadProcessMemoryData(int pid, HexData* hexData)
     return false;
   }
 
-  bb_resize(&hexData->fileData, tempBuffer.size);
-  for (size_t i = 0; i < tempBuffer.size; i++)
-  {
-    hexData->fileData.data[i] = tempBuffer.data[i];
-  }
-
+  hexData->loadBuffer(tempBuffer.data, tempBuffer.size);
   hexData->setMemoryMap(memoryMap);
   hexData->isProcessMemory = true;
 
-  hexData->convertDataToHex(16);
   bb_free(&tempBuffer);
   return true;
 }
@@ -831,7 +825,7 @@ bool ShowProcessDialog(HWND parent, AppOptions& options)
   if (selectedPid > 0)
   {
     
-    if (ReadProcessMemoryData(selectedPid, &g_HexData))
+    if (ReadProcessMemoryData(selectedPid, g_HexData))
     {
       strCopy(g_CurrentFilePath, "[Process Memory - PID ");
       char pidBuf[32];
@@ -839,7 +833,7 @@ bool ShowProcessDialog(HWND parent, AppOptions& options)
       strCat(g_CurrentFilePath, pidBuf);
       strCat(g_CurrentFilePath, "]");
 
-      g_TotalLines = (int)g_HexData.getHexLines().count;
+      g_TotalLines = (long long)g_HexData->getLineCount();
       g_ScrollY = 0;
       ApplyEnabledPlugins();
 
@@ -1181,12 +1175,7 @@ bool ReadProcessMemoryData(int pid, HexData* hexData)
 
   if (tempBuffer.size > 0)
   {
-    bb_resize(&hexData->fileData, tempBuffer.size);
-    for (size_t i = 0; i < tempBuffer.size; i++)
-    {
-      hexData->fileData.data[i] = tempBuffer.data[i];
-    }
-    hexData->convertDataToHex(16);
+    hexData->loadBuffer(tempBuffer.data, tempBuffer.size);
     bb_free(&tempBuffer);
     return true;
   }
@@ -1465,7 +1454,7 @@ bool ShowProcessDialog(NativeWindow parent, AppOptions& options)
   if (selectedPid > 0)
   {
    
-    if (ReadProcessMemoryData(selectedPid, &g_HexData))
+    if (ReadProcessMemoryData(selectedPid, g_HexData))
     {
       strCopy(g_CurrentFilePath, "[Process Memory - PID ");
       char pidBuf[32];
@@ -1473,7 +1462,7 @@ bool ShowProcessDialog(NativeWindow parent, AppOptions& options)
       strCat(g_CurrentFilePath, pidBuf);
       strCat(g_CurrentFilePath, "]");
 
-      g_TotalLines = (int)g_HexData.getHexLines().count;
+      g_TotalLines = (long long)g_HexData->getLineCount();
       g_ScrollY = 0;
       ApplyEnabledPlugins();
 
@@ -1757,12 +1746,7 @@ bool ReadProcessMemoryData(int pid, HexData* hexData)
 
   if (tempBuffer.size > 0)
   {
-    bb_resize(&hexData->fileData, tempBuffer.size);
-    for (size_t i = 0; i < tempBuffer.size; i++)
-    {
-      hexData->fileData.data[i] = tempBuffer.data[i];
-    }
-    hexData->convertDataToHex(16);
+    hexData->loadBuffer(tempBuffer.data, tempBuffer.size);
     bb_free(&tempBuffer);
     return true;
   }
@@ -1902,7 +1886,7 @@ bool ShowProcessDialog(NativeWindow parent, AppOptions& options)
     if (selectedPid > 0)
     {
 
-      if (ReadProcessMemoryData(selectedPid, &g_HexData))
+      if (ReadProcessMemoryData(selectedPid, g_HexData))
       {
         strCopy(g_CurrentFilePath, "[Process Memory - PID ");
         char pidBuf[32];
@@ -1910,7 +1894,7 @@ bool ShowProcessDialog(NativeWindow parent, AppOptions& options)
         strCat(g_CurrentFilePath, pidBuf);
         strCat(g_CurrentFilePath, "]");
 
-        g_TotalLines = (int)g_HexData.getHexLines().count;
+        g_TotalLines = (long long)g_HexData->getLineCount();
         g_ScrollY = 0;
         ApplyEnabledPlugins();
 
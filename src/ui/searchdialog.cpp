@@ -29,6 +29,53 @@ namespace SearchDialogs
   static GoToDialogData* g_goToData = nullptr;
   static InputDialogData* g_inputData = nullptr;
 
+  static long long ParseGoToOffset(const char* str)
+  {
+    long long offset = 0;
+    bool isHex = false;
+
+    while (*str == ' ') str++;
+
+    if (str[0] == '0' && (str[1] == 'x' || str[1] == 'X'))
+    {
+      isHex = true;
+      str += 2;
+    }
+    else if (str[0] == 'x' || str[0] == 'X')
+    {
+      isHex = true;
+      str += 1;
+    }
+    else
+    {
+      const char* check = str;
+      while (*check)
+      {
+        char c = *check;
+        if ((c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f'))
+        {
+          isHex = true;
+          break;
+        }
+        check++;
+      }
+    }
+
+    while (*str)
+    {
+      char c = *str;
+      if (isHex && isXDigit(c))
+        offset = offset * 16 + hexDigitToInt(c);
+      else if (!isHex && c >= '0' && c <= '9')
+        offset = offset * 10 + (c - '0');
+      else if (c != ' ')
+        break;
+      str++;
+    }
+
+    return offset;
+  }
+
   inline bool IsPointInRect(int x, int y, const Rect& rect)
   {
     return x >= rect.x && x <= rect.x + rect.width &&
@@ -322,62 +369,9 @@ namespace SearchDialogs
       if (data->callback)
       {
 #ifdef _WIN32
-        const char* str = data->lineNumberText;
-        int offset = 0;
-        bool isHex = false;
-
-        while (*str == ' ') str++;
-
-        if (str[0] == '0' && (str[1] == 'x' || str[1] == 'X'))
-        {
-          isHex = true;
-          str += 2;
-        }
-        else if (str[0] == 'x' || str[0] == 'X')
-        {
-          isHex = true;
-          str += 1;
-        }
-        else
-        {
-          const char* check = str;
-          while (*check)
-          {
-            char c = *check;
-            if ((c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f'))
-            {
-              isHex = true;
-              break;
-            }
-            check++;
-          }
-        }
-
-        if (isHex)
-        {
-          while (*str)
-          {
-            char c = *str;
-            if (c >= '0' && c <= '9')
-              offset = offset * 16 + (c - '0');
-            else if (c >= 'A' && c <= 'F')
-              offset = offset * 16 + (c - 'A' + 10);
-            else if (c >= 'a' && c <= 'f')
-              offset = offset * 16 + (c - 'a' + 10);
-            else if (c != ' ')
-              break;
-            str++;
-          }
-        }
-        else
-        {
-          offset = strToInt(data->lineNumberText);
-        }
-
-        data->callback(offset);
+        data->callback(ParseGoToOffset(data->lineNumberText));
 #else
-        int offset = strToInt(data->lineNumberText.c_str());
-        data->callback(offset);
+        data->callback(ParseGoToOffset(data->lineNumberText.c_str()));
 #endif
       }
     }
@@ -1352,11 +1346,11 @@ typedef struct { NSPoint_compat origin; NSSize_compat size; } NSRect_compat;
 
 #ifdef _WIN32
   void ShowGoToDialog(void* parentHandle, bool darkMode,
-    void (*callback)(int), void* userData)
+    void (*callback)(long long), void* userData)
   {
 #else
   void ShowGoToDialog(void* parentHandle, bool darkMode,
-    std::function<void(int)> callback)
+    std::function<void(long long)> callback)
   {
 #endif
 